@@ -0,0 +1,45 @@
+# Writes the SPIR-V files compiled by the Shaders target into a header,
+# see include/klartraum/embedded_shaders.hpp
+#
+# cmake -DSHADER_BASE_DIR=<dir> -DSHADER_NAMES=<a.comp|gsplat/b.comp|...> -DOUTPUT=<header> -P EmbedShaders.cmake
+#
+# SHADER_NAMES are the shaders relative to SHADER_BASE_DIR without the .spv suffix,
+# separated by | since lists do not survive the command line
+
+string(REPLACE "|" ";" SHADER_NAMES "${SHADER_NAMES}")
+
+set(CONTENT "// generated by cmake/EmbedShaders.cmake, do not edit\n\n")
+string(APPEND CONTENT "namespace klartraum {\nnamespace embedded {\n\n")
+
+set(TABLE "")
+set(INDEX 0)
+foreach(NAME ${SHADER_NAMES})
+  file(READ "${SHADER_BASE_DIR}/${NAME}.spv" HEX HEX)
+  # 32 bytes per line
+  set(BYTES "")
+  string(LENGTH "${HEX}" HEX_LENGTH)
+  set(OFFSET 0)
+  while(OFFSET LESS HEX_LENGTH)
+    string(SUBSTRING "${HEX}" ${OFFSET} 64 LINE)
+    string(REGEX REPLACE "([0-9a-f][0-9a-f])" "0x\\1," LINE "${LINE}")
+    string(APPEND BYTES "    ${LINE}\n")
+    math(EXPR OFFSET "${OFFSET} + 64")
+  endwhile()
+
+  string(APPEND CONTENT "// ${NAME}\n")
+  string(APPEND CONTENT "alignas(4) constexpr unsigned char shader${INDEX}[] = {\n${BYTES}};\n\n")
+  string(APPEND TABLE "    {\"shaders/${NAME}.spv\", shader${INDEX}, sizeof(shader${INDEX})},\n")
+  math(EXPR INDEX "${INDEX} + 1")
+endforeach()
+
+string(APPEND CONTENT "constexpr EmbeddedShader shaders[] = {\n${TABLE}    {nullptr, nullptr, 0}\n};\n\n")
+string(APPEND CONTENT "} // namespace embedded\n} // namespace klartraum\n")
+
+# only touch the header if it changed, so that the library is not rebuilt needlessly
+if(EXISTS "${OUTPUT}")
+  file(READ "${OUTPUT}" OLD_CONTENT)
+  if(OLD_CONTENT STREQUAL CONTENT)
+    return()
+  endif()
+endif()
+file(WRITE "${OUTPUT}" "${CONTENT}")
@@ -1,16 +1,38 @@
 #include <iostream>
 #include <filesystem>
+#include <string>
 
 #include "klartraum/glfw_frontend.hpp"
 
+#include "klartraum/computegraph/frameimage.hpp"
 #include "klartraum/draw_basics.hpp"
+#include "klartraum/gaussian_splatting_tuning.hpp"
 #include "klartraum/vulkan_gaussian_splatting.hpp"
 #include "klartraum/interface_camera_orbit.hpp"
 
-int main() {
+int main(int argc, char* argv[]) {
     std::cout << "Wake up, dreamer!" << std::endl;
 
-    klartraum::GlfwFrontend frontend;
+    klartraum::BackendConfig config;
+    bool tune = false;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--low-latency") {
+            config = klartraum::BackendConfig::lowLatency();
+        } else if (arg == "--max-throughput") {
+            config = klartraum::BackendConfig::maxThroughput();
+        } else if (arg == "--vsync") {
+            config.PRESENT_MODE = klartraum::PresentMode::Fifo;
+        } else if (arg == "--tune") {
+            tune = true;
+        }
+    }
+    // later starts do not compile the shaders again
+    config.PIPELINE_CACHE_PATH = "pipeline_cache.bin";
+    // written by --tune, later starts load the tuned kernel parameters
+    config.KERNEL_TUNING_PATH = "kernel_tuning.txt";
+
+    klartraum::GlfwFrontend frontend(config);
 
     auto& engine = frontend.getKlartraumEngine();
 
@@ -25,15 +47,33 @@ int main() {
     cameraUBO->setName("CameraUBO");
     
     std::string spzFile = "./3rdparty/spz/samples/racoonfamily.spz";
-    std::shared_ptr<klartraum::VulkanGaussianSplatting> splatting = vulkanContext.create<klartraum::VulkanGaussianSplatting>(renderpass, cameraUBO, spzFile);
-    
-    engine.add(splatting);
 
     std::shared_ptr<klartraum::InterfaceCameraOrbit> cameraOrbit = std::make_shared<klartraum::InterfaceCameraOrbit>(klartraum::InterfaceCameraOrbit::UpDirection::Y);
     cameraOrbit->setAzimuth(0.9);
     cameraOrbit->setElevation(-0.5);
     cameraOrbit->setPosition({-0.5, 0.0, 0.5});
     cameraOrbit->setDistance(1.0);
+
+    if (tune) {
+        // measures the kernel parameters from the start view and saves the fastest
+        // for the device, the splatting below loads them
+        auto tuningImage = std::make_shared<klartraum::FrameImage>(vulkanContext.getSwapChainImageFormat(), vulkanContext.getSwapChainExtent());
+        auto tuningCamera = std::make_shared<klartraum::CameraUboType>();
+        cameraOrbit->initialize(vulkanContext);
+        cameraOrbit->update(tuningCamera->ubo);
+
+        klartraum::GaussianKernelTuner tuner(vulkanContext);
+        tuner.tune(tuningImage, tuningCamera, spzFile);
+    }
+
+    klartraum::GaussianSplattingOptions splattingOptions;
+    splattingOptions.lod.enabled = true;
+    splattingOptions.sort.temporal = true;
+
+    std::shared_ptr<klartraum::VulkanGaussianSplatting> splatting = vulkanContext.create<klartraum::VulkanGaussianSplatting>(renderpass, cameraUBO, spzFile, splattingOptions);
+    
+    engine.add(splatting);
+
     engine.setInterfaceCamera(cameraOrbit);
     engine.setCameraUBO(cameraUBO);
 
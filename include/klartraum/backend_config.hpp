@@ -1,19 +1,67 @@
 #ifndef BACKEND_CONFIG_HPP
 #define BACKEND_CONFIG_HPP
 
+#include <stddef.h>
 #include <stdint.h>
 
+#include <string>
+
 namespace klartraum {
 
+enum class PresentMode {
+    Mailbox,   // no tearing, the newest frame replaces the queued one
+    Immediate, // lowest latency, may tear
+    Fifo       // vsync, always supported
+};
+
 class BackendConfig {
 public:
-    static constexpr size_t MAX_FRAMES_IN_FLIGHT = 2;
+    // number of frames the cpu records ahead of the gpu,
+    // 1 gives the lowest latency, more keep the gpu busy
+    size_t MAX_FRAMES_IN_FLIGHT = 2;
+
+    // fifo is used if the surface does not support the present mode
+    PresentMode PRESENT_MODE = PresentMode::Mailbox;
+
+    // number of swapchain images, clamped to the limits of the surface,
+    // 0 uses one more than the minimum of the surface
+    uint32_t SWAPCHAIN_IMAGE_COUNT = 0;
+
+    // file the pipeline cache is loaded from at startup and saved to at shutdown,
+    // it is ignored if it was written by another device or driver, empty disables it
+    std::string PIPELINE_CACHE_PATH = "";
+
+    // file with the kernel parameters tuned per device (see GaussianKernelTuner),
+    // the gaussian splatting uses the entry of the device if there is one, empty disables it
+    std::string KERNEL_TUNING_PATH = "";
+
+    // enables buffer device addresses if the device supports them, so that shaders can
+    // access buffers by address instead of through descriptors (see GeneralComputation::setBufferAddressMode)
+    bool BUFFER_DEVICE_ADDRESS = true;
+
     static constexpr uint32_t WIDTH = 512;
     static constexpr uint32_t HEIGHT = 512;
 
     static constexpr char* ENGINE_VERSION = "Klartraum Engine v0.0.1";
+
+    // the gpu works on a single frame that is shown as soon as it is finished
+    static BackendConfig lowLatency() {
+        BackendConfig config;
+        config.MAX_FRAMES_IN_FLIGHT = 1;
+        config.PRESENT_MODE = PresentMode::Mailbox;
+        return config;
+    }
+
+    // the presentation never blocks the rendering of the next frames
+    static BackendConfig maxThroughput() {
+        BackendConfig config;
+        config.MAX_FRAMES_IN_FLIGHT = 3;
+        config.PRESENT_MODE = PresentMode::Immediate;
+        config.SWAPCHAIN_IMAGE_COUNT = 4;
+        return config;
+    }
 };
 
 } // namespace klartraum
 
-#endif // BACKEND_CONFIG_HPP
\ No newline at end of file
+#endif // BACKEND_CONFIG_HPP
@@ -84,6 +84,10 @@ public:
         recordToZero = _setToZero;
     }
 
+    virtual bool isRequiredByOutputs() const {
+        return recordToZero;
+    }
+
     virtual VkBuffer& getVkBuffer(uint32_t pathId) {
         return buffers[pathId].getBuffer();
     };
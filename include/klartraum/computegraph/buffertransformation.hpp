@@ -51,7 +51,7 @@ public:
                 vkDestroyPipeline(vulkanContext->getDevice(), computePipeline, nullptr);
             }
             vkDestroyDescriptorSetLayout(vulkanContext->getDevice(), computeDescriptorSetLayout, nullptr);
-            vkDestroyDescriptorPool(vulkanContext->getDevice(), descriptorPool, nullptr);
+            vulkanContext->getDescriptorAllocator().free(computeDescriptorSets);
 
             if constexpr (!std::is_void<U>::value) {
                 uboPtr.reset();
@@ -77,7 +77,9 @@ public:
             other->_setup(vulkanContext, numberPaths);
         }
 
-        createDescriptorPool();
+        // resolved once, getInput is used whenever the descriptor sets are written
+        inputBuffer = resolveInput();
+
         createComputeDescriptorSetLayout();
         createComputePipeline();
         
@@ -89,12 +91,13 @@ public:
         // If groupCountX is 0, use input size, otherwise use groupCountX
         groupCountX = groupCountX > 0 ? groupCountX : inputSize; 
 
-        computeDescriptorSets.resize(numberPaths);
+        // one set per path
+        computeDescriptorSets = vulkanContext.getDescriptorAllocator().allocate(computeDescriptorSetLayout, getDescriptorSetSizes(), numberPaths);
         for(uint32_t i = 0; i < numberPaths; i++) {
             // Use custom output size if set, otherwise use input size
             uint32_t outputSize = customOutputSize > 0 ? customOutputSize : inputSize;
             outputBuffers.emplace_back(vulkanContext, outputSize);
-            createComputeDescriptorSets(i);
+            writeComputeDescriptorSet(i);
             
             if constexpr (!std::is_void<U>::value) {
                 uboPtr->update(i);
@@ -104,6 +107,16 @@ public:
 
     };
 
+    // a struct of 32 bit members, the i-th member is given to constant_id i of the shaders,
+    // e.g. to adapt the workgroup size to the device, has to be set before the setup
+    template <typename S>
+    void setSpecializationConstants(const S& constants) {
+        if (this->initialized) {
+            throw std::runtime_error("specialization constants have to be set before the setup!");
+        }
+        specializationConstants = SpecializationConstants(constants);
+    }
+
     void setCustomOutputSize(uint32_t size) {
         customOutputSize = size;
     }
@@ -170,7 +183,7 @@ public:
         }
         else
         {
-            vkCmdDispatchIndirect(commandBuffer, dynamicGroupDispatchParams->getVkBuffer(0), 0);
+            vkCmdDispatchIndirect(commandBuffer, dynamicGroupDispatchParams->getVkBuffer(pathId), 0);
         }
         VkMemoryBarrier memoryBarrier{};
         memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
@@ -222,18 +235,25 @@ public:
 
     A& getInput(uint32_t pathId = 0) {
         // TODO why inputs[0], and not inputs[pathId]?
-        auto bufferPtr = dynamic_cast<TemplatedBufferElementInterface<A>*>(this->getInputElement(0).get());
-        if (bufferPtr == nullptr) {
-            throw std::runtime_error("input is not a fitting BufferElement!");
+        if (inputBuffer != nullptr) {
+            return inputBuffer->getBuffer(pathId);
         }
-        
-        return bufferPtr->getBuffer(pathId);
+        return resolveInput()->getBuffer(pathId);
     }
 
     virtual const char* getType() const {
         return "BufferTransformation";
     }    
 
+    virtual uint64_t getChangeCount() const override {
+        if constexpr (!std::is_void<U>::value) {
+            // the ubo is not part of the graph, so its changes are reported here
+            return this->changeCount + uboPtr->getChangeCount();
+        } else {
+            return this->changeCount;
+        }
+    }
+
     R& getOutputBuffer(uint32_t pathId = 0) {
         return outputBuffers[pathId];
     }
@@ -272,11 +292,11 @@ public:
     }
 
 private:
-    VkDescriptorPool descriptorPool;
     std::vector<VkDescriptorSet> computeDescriptorSets;
     VkDescriptorSetLayout computeDescriptorSetLayout;
     VkPipelineLayout computePipelineLayout;
     std::vector<VkPipeline> computePipelines;
+    SpecializationConstants specializationConstants;
 
     VulkanContext* vulkanContext;
 
@@ -291,6 +311,8 @@ private:
 
     std::vector<R> outputBuffers;
 
+    TemplatedBufferElementInterface<A>* inputBuffer = nullptr; // set during the setup
+
     std::conditional_t<!std::is_void<U>::value, std::shared_ptr<U>, void*> uboPtr = nullptr;
 
     std::conditional_t<!std::is_void<P>::value, std::vector<P>, void*> pushConstants;
@@ -303,44 +325,18 @@ private:
     /*
 
     */
-    void createDescriptorPool() {
-        auto& device = vulkanContext->getDevice();
-        auto& config = vulkanContext->getConfig();
-
-        
-        std::vector<VkDescriptorPoolSize> poolSizes(3 + otherInputs.size());
-        // A
-        poolSizes[0].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-        // TODO use numberPaths instead of hardcoded 3 ...
-        poolSizes[0].descriptorCount = 3; //static_cast<uint32_t>(swapChainSize);
-        
-        // B
-        poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-        // TODO use numberPaths instead of hardcoded 3 ...
-        poolSizes[1].descriptorCount = 3; //static_cast<uint32_t>(swapChainSize);
-        
-        // Result
-        poolSizes[2].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-        // TODO use numberPaths instead of hardcoded 3 ...
-        poolSizes[2].descriptorCount = 3; //static_cast<uint32_t>(swapChainSize);
-
-        // Other inputs
-        for (size_t i = 0; i < otherInputs.size(); i++) {
-            poolSizes[3 + i].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-            poolSizes[3 + i].descriptorCount = 3; //static_cast<uint32_t>(swapChainSize);
-        }
-        
-        VkDescriptorPoolCreateInfo poolInfo{};
-        poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-        poolInfo.poolSizeCount = (uint32_t)poolSizes.size();
-        poolInfo.pPoolSizes = poolSizes.data();
-        // TODO use numberPaths instead of hardcoded 3 ... or whatever is needed
-        poolInfo.maxSets = 3;
-    
-        if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS) {
-            throw std::runtime_error("failed to create descriptor pool!");
+    TemplatedBufferElementInterface<A>* resolveInput() {
+        auto bufferPtr = dynamic_cast<TemplatedBufferElementInterface<A>*>(this->getInputElement(0).get());
+        if (bufferPtr == nullptr) {
+            throw std::runtime_error("input is not a fitting BufferElement!");
         }
-    }    
+        return bufferPtr;
+    }
+
+    // the descriptors of a single set: A, B, Result and the other inputs
+    std::vector<VkDescriptorPoolSize> getDescriptorSetSizes() const {
+        return {{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, (uint32_t)(3 + otherInputs.size())}};
+    }
 
     void createComputeDescriptorSetLayout()
     {
@@ -388,26 +384,13 @@ private:
         }
     }
 
-    void createComputeDescriptorSets(uint32_t pathId)
+    void writeComputeDescriptorSet(uint32_t pathId)
     {
         auto& device = vulkanContext->getDevice();
-        auto& config = vulkanContext->getConfig();
 
         A& a = getInput(pathId);
         R& r = outputBuffers[pathId];
     
-        //VkDescriptorSetLayout layout;
-        VkDescriptorSetAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-        allocInfo.descriptorPool = descriptorPool;
-        allocInfo.descriptorSetCount = 1;
-        allocInfo.pSetLayouts = &computeDescriptorSetLayout;
-    
-        VkResult result = vkAllocateDescriptorSets(device, &allocInfo, &computeDescriptorSets[pathId]);
-        if (result != VK_SUCCESS) {
-            throw std::runtime_error("failed to allocate descriptor sets!");
-        }
-    
         VkDescriptorBufferInfo storageBufferInfoA{};
         storageBufferInfoA.buffer = a.getBuffer();
         storageBufferInfoA.offset = 0;
@@ -463,37 +446,18 @@ private:
     {
         auto& device = vulkanContext->getDevice();
 
-        std::vector<VkShaderModule> computeShaderModules(shaderPaths.size());
-        std::vector<VkPipelineShaderStageCreateInfo> computeShaderStages(shaderPaths.size()); 
-
-        for (size_t i = 0; i < shaderPaths.size(); i++) {
-            auto computeShaderCode = readFile(shaderPaths[i]);
-
-            computeShaderModules[i] = createShaderModule(computeShaderCode, vulkanContext->getDevice());
-
-            computeShaderStages[i].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-            computeShaderStages[i].stage = VK_SHADER_STAGE_COMPUTE_BIT;
-            computeShaderStages[i].module = computeShaderModules[i];
-            computeShaderStages[i].pName = "main";
-        }
-
-    
-        
         VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
         pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
         
+        std::vector<VkDescriptorSetLayout> combinedLayouts = {computeDescriptorSetLayout};
         if constexpr (!std::is_void<U>::value) {
-            pipelineLayoutInfo.setLayoutCount = 2;
-            VkDescriptorSetLayout combinedLayouts[] = {computeDescriptorSetLayout, uboPtr->getDescriptorSetLayout()};
-            pipelineLayoutInfo.pSetLayouts = combinedLayouts;
-        } else {
-            pipelineLayoutInfo.setLayoutCount = 1;
-            VkDescriptorSetLayout combinedLayouts[] = {computeDescriptorSetLayout};
-            pipelineLayoutInfo.pSetLayouts = combinedLayouts;
+            combinedLayouts.push_back(uboPtr->getDescriptorSetLayout());
         }
+        pipelineLayoutInfo.setLayoutCount = (uint32_t)combinedLayouts.size();
+        pipelineLayoutInfo.pSetLayouts = combinedLayouts.data();
 
+        VkPushConstantRange pushConstantRange{};
         if constexpr (!std::is_void<P>::value) {
-            VkPushConstantRange pushConstantRange{};
             pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
             pushConstantRange.offset = 0;
             pushConstantRange.size = sizeof(P);
@@ -504,23 +468,12 @@ private:
         if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &computePipelineLayout) != VK_SUCCESS) {
             throw std::runtime_error("failed to create compute pipeline layout!");
         }
-    
-    
-        std::vector<VkComputePipelineCreateInfo> pipelineInfos(computeShaderStages.size());
-        for (size_t i = 0; i < computeShaderStages.size(); i++) {
-            VkComputePipelineCreateInfo& pipelineInfo = pipelineInfos[i];
-            pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
-            pipelineInfo.layout = computePipelineLayout;
-            pipelineInfo.stage = computeShaderStages[i];
-        }
 
-        computePipelines.resize(computeShaderStages.size());
-        if (vkCreateComputePipelines(device, VK_NULL_HANDLE, computeShaderStages.size(), pipelineInfos.data(), nullptr, computePipelines.data()) != VK_SUCCESS) {
-            throw std::runtime_error("failed to create compute pipeline!");
-        }
-
-        for (size_t i = 0; i < computeShaderModules.size(); i++) {
-            vkDestroyShaderModule(device, computeShaderModules[i], nullptr);
+        // created right away or, during a graph compile, together with the other pipelines of the graph,
+        // the vector is not resized afterwards, the builder writes to its elements
+        computePipelines.assign(shaderPaths.size(), VK_NULL_HANDLE);
+        for (size_t i = 0; i < shaderPaths.size(); i++) {
+            vulkanContext->getPipelineBuilder().addComputePipeline(shaderPaths[i], computePipelineLayout, &computePipelines[i], specializationConstants);
         }
     }
 
@@ -1,6 +1,9 @@
 #ifndef KLARTRAUM_COMPUTEGRAPH_HPP
 #define KLARTRAUM_COMPUTEGRAPH_HPP
 
+#include <algorithm>
+#include <array>
+#include <cstdint>
 #include <iostream>
 #include <map>
 #include <queue>
@@ -8,6 +11,7 @@
 #include <vector>
 
 #include "klartraum/computegraph/computegraphelement.hpp"
+#include "klartraum/parallel_for.hpp"
 
 namespace klartraum {
 
@@ -22,21 +26,12 @@ public:
 class ComputeGraph {
 public:
     ComputeGraph(VulkanContext& vulkanContext, uint32_t numberPaths) : vulkanContext(vulkanContext), numberPaths(numberPaths) {
-        auto& device = vulkanContext.getDevice();
-
         all_path_submit_infos.resize(numberPaths);
+        submittedChangeCounts.resize(numberPaths);
+        recordedRecordCounts.resize(numberPaths);
+        recordedInputResourceCounts.resize(numberPaths);
         all_path_submit_info_wrappers.resize(numberPaths);
         allRenderFinishedSemaphores.resize(numberPaths);
-
-        // create the command pool
-        VkCommandPoolCreateInfo poolInfo{};
-        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-        poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
-        poolInfo.queueFamilyIndex = vulkanContext.getQueueFamilyIndices().graphicsAndComputeFamily.value();
-
-        if (vkCreateCommandPool(device, &poolInfo, nullptr, &commandPool) != VK_SUCCESS) {
-            throw std::runtime_error("failed to create command pool!");
-        }
     }
 
     virtual ~ComputeGraph() {
@@ -59,11 +54,16 @@ public:
             vkDestroySemaphore(device, semaphores, nullptr);
         }
 
-        for (auto& buffer : commandBuffers) {
-            vkFreeCommandBuffers(device, commandPool, 1, &buffer);
+        // destroying the command pools frees their command buffers
+        for (auto& commandPool : commandPools) {
+            vkDestroyCommandPool(device, commandPool, nullptr);
+        }
+        for (auto& pathCommandPool : pathCommandPools) {
+            vkDestroyCommandPool(device, pathCommandPool, nullptr);
+        }
+        for (auto& pathFence : pathFences) {
+            vkDestroyFence(device, pathFence, nullptr);
         }
-        // destroy the command pool
-        vkDestroyCommandPool(device, commandPool, nullptr);
     }
 
     void compileFrom(ComputeGraphElementPtr element) {
@@ -73,32 +73,76 @@ public:
 
         updateOutputs();
 
+        resolveConnections();
+
         createRenderFinishedSemaphores();
 
         createGraphFinishedSemaphores();
 
-        for (auto& element : ordered_elements) {
-            element->_setup(vulkanContext, numberPaths);
+        // the elements only request their pipelines during the setup,
+        // they are created concurrently afterwards
+        auto& pipelineBuilder = vulkanContext.getPipelineBuilder();
+        pipelineBuilder.defer();
+        try {
+            for (auto& element : ordered_elements) {
+                element->_setup(vulkanContext, numberPaths);
+            }
+        } catch (...) {
+            pipelineBuilder.discard();
+            throw;
         }
+        pipelineBuilder.build();
 
-        commandBuffers.resize(ordered_elements.size() * numberPaths);
+        dynamicElements.assign(ordered_elements.size(), false);
+        for (size_t i = 0; i < ordered_elements.size(); i++) {
+            dynamicElements[i] = ordered_elements[i]->isDynamic();
+        }
 
-        // create the command buffers
-        VkCommandBufferAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-        allocInfo.commandPool = commandPool;
-        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-        allocInfo.commandBufferCount = (uint32_t)(commandBuffers.size());
+        // each worker of the thread pool of the context has its own command pools,
+        // element i is recorded by worker i % recordThreads
+        auto& threadPool = vulkanContext.getThreadPool();
+        recordThreads = parallelRecording ? std::max<size_t>(1, threadPool.getNumberThreads(ordered_elements.size())) : 1;
+        createCommandPools();
+        if (std::find(dynamicElements.begin(), dynamicElements.end(), true) != dynamicElements.end()) {
+            createPathCommandPools();
+        }
+
+        commandBuffers.resize(ordered_elements.size() * numberPaths);
 
-        if (vkAllocateCommandBuffers(device, &allocInfo, commandBuffers.data()) != VK_SUCCESS) {
-            throw std::runtime_error("failed to allocate command buffers!");
+        // create the command buffers, the ones of dynamic elements in the pools of the paths
+        for (size_t i = 0; i < ordered_elements.size(); i++) {
+            for (uint32_t pathId = 0; pathId < numberPaths; pathId++) {
+                size_t thread = i % recordThreads;
+                VkCommandBufferAllocateInfo allocInfo{};
+                allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+                allocInfo.commandPool = dynamicElements[i] ? pathCommandPools[pathId * recordThreads + thread] : commandPools[thread];
+                allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+                allocInfo.commandBufferCount = 1;
+
+                if (vkAllocateCommandBuffers(device, &allocInfo, &commandBuffers[i * numberPaths + pathId]) != VK_SUCCESS) {
+                    throw std::runtime_error("failed to allocate command buffers!");
+                }
+            }
         }
 
+        // dynamic elements are recorded right before each submission
+        threadPool.forEachWorker(recordThreads, [&](size_t thread) {
+            for (size_t i = thread; i < ordered_elements.size(); i += recordThreads) {
+                if (dynamicElements[i]) {
+                    continue;
+                }
+                for (uint32_t pathId = 0; pathId < numberPaths; pathId++) {
+                    recordCommandBuffer(commandBuffers[i * numberPaths + pathId], ordered_elements[i], pathId);
+                }
+            }
+        });
+
         for (uint32_t pathId = 0; pathId < numberPaths; pathId++) {
             for (size_t i = 0; i < ordered_elements.size(); i++) {
                 auto& element = ordered_elements[i];
                 VkCommandBuffer& commandBuffer = commandBuffers[i * numberPaths + pathId];
-                recordCommandBuffer(commandBuffer, element, pathId);
+                recordedRecordCounts[pathId][i] = element->getRecordCount();
+                recordedInputResourceCounts[pathId][i] = getInputResourceCount(i);
                 // for now, all command buffers will be submitted to the same queue without any synchronization
                 // this is okay since we sorted the elements in the graph before and the queue is
                 // processing them one after another (assumption!!!)
@@ -117,9 +161,11 @@ public:
     /*
      * Submit the graph to the graphics queue
      *
-     * The submit infos will have to be prepared before by calling compile_from
+     * The submit infos will have to be prepared before by calling compile_from.
+     * If given, the begin command buffer (e.g. writing a timestamp) is submitted
+     * in front of the command buffer of the first element.
      */
-    VkSemaphore submitTo(VkQueue graphicsQueue, uint32_t pathId, VkFence fence = VK_NULL_HANDLE) {
+    VkSemaphore submitTo(VkQueue graphicsQueue, uint32_t pathId, VkFence fence = VK_NULL_HANDLE, VkCommandBuffer beginCommandBuffer = VK_NULL_HANDLE) {
         auto& submit_infos = all_path_submit_infos[pathId];
 
         // the following seems not to work if there are multiple paths in the graph
@@ -131,9 +177,50 @@ public:
         // in the future, we will merge command buffers of consecutive elements
         // and submit them together
 
-        if (vkQueueSubmit(graphicsQueue, (uint32_t)submit_infos.size(), submit_infos.data(), fence) != VK_SUCCESS) {
+        for (auto& element : ordered_elements) {
+            element->_update(pathId);
+        }
+
+        recordOutdated(graphicsQueue, pathId);
+
+        recordDynamic(pathId);
+
+        // the submit infos are only copied if they are modified for this submission
+        bool modify = skipUnchanged || (beginCommandBuffer != VK_NULL_HANDLE && !submit_infos.empty());
+        SubmitInfoList modified_submit_infos;
+        if (modify) {
+            modified_submit_infos = submit_infos;
+        }
+
+        if (skipUnchanged) {
+            // unchanged elements are submitted without command buffers,
+            // so that the semaphores between the elements are still signaled
+            // and their results of the previous submission of the path are kept
+            std::vector<bool> submit = getChangedElements(pathId);
+            for (size_t i = 0; i < ordered_elements.size(); i++) {
+                if (!submit[i]) {
+                    modified_submit_infos[i].commandBufferCount = 0;
+                    modified_submit_infos[i].pCommandBuffers = nullptr;
+                }
+                submittedChangeCounts[pathId][i] = ordered_elements[i]->getChangeCount();
+            }
+        }
+
+        std::array<VkCommandBuffer, 2> firstCommandBuffers{beginCommandBuffer, VK_NULL_HANDLE};
+        if (beginCommandBuffer != VK_NULL_HANDLE && !modified_submit_infos.empty()) {
+            auto& firstSubmitInfo = modified_submit_infos[0];
+            if (firstSubmitInfo.commandBufferCount > 0) {
+                firstCommandBuffers[1] = firstSubmitInfo.pCommandBuffers[0];
+            }
+            firstSubmitInfo.commandBufferCount += 1;
+            firstSubmitInfo.pCommandBuffers = firstCommandBuffers.data();
+        }
+
+        auto& path_submit_infos = modify ? modified_submit_infos : submit_infos;
+        if (vkQueueSubmit(graphicsQueue, (uint32_t)path_submit_infos.size(), path_submit_infos.data(), fence) != VK_SUCCESS) {
             throw std::runtime_error("failed to submit the graph elements!");
         }
+        signalPathFence(graphicsQueue, pathId);
 
         return graphFinishedSemaphores[pathId];
     }
@@ -159,13 +246,120 @@ public:
         return;
     }
 
+    /*
+     * If enabled, elements are only submitted if they or one of their inputs changed
+     * (see ComputeGraphElement::setChanged) since the last submission of the path.
+     * Their results, including the images they render to, are kept otherwise.
+     */
+    void setSkipUnchanged(bool skip) {
+        skipUnchanged = skip;
+    }
+
+    bool getSkipUnchanged() const {
+        return skipUnchanged;
+    }
+
+    // the elements in the order they are recorded and submitted, set by the compile
+    const std::vector<ComputeGraphElementPtr>& getOrderedElements() const {
+        return ordered_elements;
+    }
+
+    // returns which of the ordered elements have to be submitted for the path
+    std::vector<bool> getChangedElements(uint32_t pathId) {
+        auto& submitted = submittedChangeCounts[pathId];
+
+        std::vector<bool> changed(ordered_elements.size(), false);
+        for (size_t i = 0; i < ordered_elements.size(); i++) {
+            // NeverSubmitted is no change count
+            changed[i] = submitted[i] != ordered_elements[i]->getChangeCount();
+        }
+
+        // the inputs come before the elements in the order, so a single pass propagates
+        // the changes to the outputs, which in turn may require elements like resetting
+        // buffers to be submitted, which changes their outputs again
+        bool modified = true;
+        while (modified) {
+            modified = false;
+            for (size_t i = 0; i < ordered_elements.size(); i++) {
+                for (size_t input : inputPositions[i]) {
+                    if (!changed[i] && changed[input]) {
+                        changed[i] = true;
+                        modified = true;
+                    }
+                }
+            }
+            for (size_t i = 0; i < ordered_elements.size(); i++) {
+                if (changed[i] || !ordered_elements[i]->isRequiredByOutputs()) {
+                    continue;
+                }
+                for (size_t output : outputPositions[i]) {
+                    if (changed[output]) {
+                        changed[i] = true;
+                        modified = true;
+                        break;
+                    }
+                }
+            }
+        }
+        return changed;
+    }
+
+    /*
+     * If enabled, the command buffers of the elements are recorded on the workers of the thread
+     * pool of the context (with command pools per worker) during the compile and, for dynamic elements,
+     * before every submission. The _record of different elements may then run concurrently.
+     * Has to be set before the compile.
+     */
+    void setParallelRecording(bool parallel) {
+        parallelRecording = parallel;
+    }
+
+    bool getParallelRecording() const {
+        return parallelRecording;
+    }
+
 private:
     VulkanContext& vulkanContext;
     uint32_t numberPaths;
 
-    VkCommandPool commandPool;
+    bool skipUnchanged = false;
+
+    bool parallelRecording = false;
+    size_t recordThreads = 1;
+
+    // the counts below are indexed like ordered_elements
+    static constexpr uint64_t NeverSubmitted = UINT64_MAX;
+
+    // per path, the change counts of the elements at their last submission
+    std::vector<std::vector<uint64_t>> submittedChangeCounts;
+
+    // per path, the record counts of the elements when their command buffers were recorded
+    std::vector<std::vector<uint64_t>> recordedRecordCounts;
+
+    // per path, the resource counts of the inputs of the elements when their command buffers were recorded
+    std::vector<std::vector<uint64_t>> recordedInputResourceCounts;
+
+    // resolved once during the compile, so that the bookkeeping of every submission
+    // neither copies the input maps of the elements nor looks them up by pointer:
+    // the positions of the inputs and outputs of each element in ordered_elements
+    // and the elements providing the resources of its inputs (slots resolved)
+    std::vector<std::vector<size_t>> inputPositions;
+    std::vector<std::vector<size_t>> outputPositions;
+    std::vector<std::vector<ComputeGraphElement*>> resourceInputs;
+
+    // one per recording thread
+    std::vector<VkCommandPool> commandPools;
     std::vector<VkCommandBuffer> commandBuffers;
 
+    // indexed like ordered_elements, see ComputeGraphElement::setDynamic
+    std::vector<bool> dynamicElements;
+
+    // only created if the graph has dynamic elements: per path, the pools of the command buffers
+    // of the dynamic elements (one per worker, indexed by pathId * recordThreads + worker)
+    // and a fence signaled once the last submission of the path finished
+    std::vector<VkCommandPool> pathCommandPools;
+    std::vector<VkFence> pathFences;
+
     std::vector<ComputeGraphElementPtr> ordered_elements;
 
     typedef std::vector<VkSubmitInfo> SubmitInfoList;
@@ -181,13 +375,178 @@ private:
 
     std::vector<VkSemaphore> graphFinishedSemaphores;
 
-    void recordCommandBuffer(VkCommandBuffer commandBuffer, ComputeGraphElementPtr element, uint32_t pathId) {
-        // reset the command buffer before recording
-        vkResetCommandBuffer(commandBuffer, 0);
+    // the resource counts only increase, so the sum changes whenever the resources of one of the inputs were replaced
+    uint64_t getInputResourceCount(size_t position) {
+        uint64_t count = 0;
+        for (ComputeGraphElement* input : resourceInputs[position]) {
+            count += input->getResourceCount();
+        }
+        return count;
+    }
+
+    void resolveConnections() {
+        std::map<ComputeGraphElementPtr, size_t> positions;
+        for (size_t i = 0; i < ordered_elements.size(); i++) {
+            positions[ordered_elements[i]] = i;
+        }
+
+        inputPositions.assign(ordered_elements.size(), {});
+        outputPositions.assign(ordered_elements.size(), {});
+        resourceInputs.assign(ordered_elements.size(), {});
+        for (size_t i = 0; i < ordered_elements.size(); i++) {
+            auto& element = ordered_elements[i];
+            for (auto& input : element->getInputs()) {
+                inputPositions[i].push_back(positions.at(input.second));
+                resourceInputs[i].push_back(element->getInputElement(input.first).get());
+            }
+            for (auto& output : element->outputs) {
+                outputPositions[i].push_back(positions.at(output));
+            }
+        }
+
+        for (uint32_t pathId = 0; pathId < numberPaths; pathId++) {
+            submittedChangeCounts[pathId].assign(ordered_elements.size(), NeverSubmitted);
+            recordedRecordCounts[pathId].assign(ordered_elements.size(), 0);
+            recordedInputResourceCounts[pathId].assign(ordered_elements.size(), 0);
+        }
+    }
+
+    // records the command buffers of the path again whose elements were marked
+    // with setRecordOutdated or whose inputs replaced their resources (setResourcesOutdated),
+    // this is rare (e.g. when the resolution changes or the swapchain is recreated),
+    // so it simply waits until the queue is idle and the command buffers are not in use anymore
+    // (dynamic elements are recorded in recordDynamic instead)
+    void recordOutdated(VkQueue graphicsQueue, uint32_t pathId) {
+        auto& recorded = recordedRecordCounts[pathId];
+        auto& recordedInputs = recordedInputResourceCounts[pathId];
+        bool waited = false;
+        // the inputs come first, so their resources are updated before the elements using them
+        for (size_t i = 0; i < ordered_elements.size(); i++) {
+            auto& element = ordered_elements[i];
+            uint64_t inputResourceCount = getInputResourceCount(i);
+            bool inputsChanged = recordedInputs[i] != inputResourceCount;
+            if (dynamicElements[i] || (!inputsChanged && recorded[i] == element->getRecordCount())) {
+                continue;
+            }
+            if (!waited) {
+                vkQueueWaitIdle(graphicsQueue);
+                waited = true;
+            }
+            if (inputsChanged) {
+                element->_inputsChanged(pathId);
+                recordedInputs[i] = inputResourceCount;
+            }
+            recordCommandBuffer(commandBuffers[i * numberPaths + pathId], element, pathId);
+            recorded[i] = element->getRecordCount();
+        }
+    }
+
+    void createCommandPools() {
+        auto& device = vulkanContext.getDevice();
+
+        commandPools.resize(recordThreads, VK_NULL_HANDLE);
+        for (auto& commandPool : commandPools) {
+            VkCommandPoolCreateInfo poolInfo{};
+            poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+            poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+            poolInfo.queueFamilyIndex = vulkanContext.getQueueFamilyIndices().graphicsAndComputeFamily.value();
+
+            if (vkCreateCommandPool(device, &poolInfo, nullptr, &commandPool) != VK_SUCCESS) {
+                throw std::runtime_error("failed to create command pool!");
+            }
+        }
+    }
+
+    void createPathCommandPools() {
+        auto& device = vulkanContext.getDevice();
+
+        // reset as a whole before the dynamic elements of the path are recorded
+        pathCommandPools.resize(numberPaths * recordThreads, VK_NULL_HANDLE);
+        for (auto& pathCommandPool : pathCommandPools) {
+            VkCommandPoolCreateInfo poolInfo{};
+            poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+            poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+            poolInfo.queueFamilyIndex = vulkanContext.getQueueFamilyIndices().graphicsAndComputeFamily.value();
+
+            if (vkCreateCommandPool(device, &poolInfo, nullptr, &pathCommandPool) != VK_SUCCESS) {
+                throw std::runtime_error("failed to create command pool!");
+            }
+        }
+
+        pathFences.resize(numberPaths, VK_NULL_HANDLE);
+        for (uint32_t pathId = 0; pathId < numberPaths; pathId++) {
+
+            // nothing of the path was submitted yet
+            VkFenceCreateInfo fenceInfo{};
+            fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+            fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+            if (vkCreateFence(device, &fenceInfo, nullptr, &pathFences[pathId]) != VK_SUCCESS) {
+                throw std::runtime_error("failed to create fence!");
+            }
+        }
+    }
+
+    // records the command buffers of the dynamic elements of the path again, only the previous
+    // submission of the path has to be finished for that, which it usually is already
+    // (the engine waits for the frame in flight before it submits the path again)
+    void recordDynamic(uint32_t pathId) {
+        if (pathCommandPools.empty()) {
+            return;
+        }
+        auto& device = vulkanContext.getDevice();
+
+        if (vkWaitForFences(device, 1, &pathFences[pathId], VK_TRUE, UINT64_MAX) != VK_SUCCESS) {
+            throw std::runtime_error("failed to wait for fence!");
+        }
+        for (size_t thread = 0; thread < recordThreads; thread++) {
+            vkResetCommandPool(device, pathCommandPools[pathId * recordThreads + thread], 0);
+        }
+
+        auto& recorded = recordedRecordCounts[pathId];
+        auto& recordedInputs = recordedInputResourceCounts[pathId];
+        // the inputs come first, so their resources are updated before the elements using them
+        for (size_t i = 0; i < ordered_elements.size(); i++) {
+            if (!dynamicElements[i]) {
+                continue;
+            }
+            uint64_t inputResourceCount = getInputResourceCount(i);
+            if (recordedInputs[i] != inputResourceCount) {
+                ordered_elements[i]->_inputsChanged(pathId);
+                recordedInputs[i] = inputResourceCount;
+            }
+            recorded[i] = ordered_elements[i]->getRecordCount();
+        }
+
+        vulkanContext.getThreadPool().forEachWorker(recordThreads, [&](size_t thread) {
+            for (size_t i = thread; i < ordered_elements.size(); i += recordThreads) {
+                if (dynamicElements[i]) {
+                    recordCommandBuffer(commandBuffers[i * numberPaths + pathId], ordered_elements[i], pathId, true);
+                }
+            }
+        });
+    }
+
+    // an empty submission signals the fence once everything submitted before has finished
+    void signalPathFence(VkQueue graphicsQueue, uint32_t pathId) {
+        if (pathFences.empty()) {
+            return;
+        }
+        vkResetFences(vulkanContext.getDevice(), 1, &pathFences[pathId]);
+        if (vkQueueSubmit(graphicsQueue, 0, nullptr, pathFences[pathId]) != VK_SUCCESS) {
+            throw std::runtime_error("failed to submit the fence of the path!");
+        }
+    }
+
+    void recordCommandBuffer(VkCommandBuffer commandBuffer, ComputeGraphElementPtr element, uint32_t pathId, bool dynamic = false) {
+        // the command buffers of dynamic elements were reset with the pool of the path
+        if (!dynamic) {
+            vkResetCommandBuffer(commandBuffer, 0);
+        }
 
         VkCommandBufferBeginInfo beginInfo{};
         beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-        beginInfo.flags = 0;                  // Optional
+        beginInfo.flags = dynamic ? VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT : 0;
         beginInfo.pInheritanceInfo = nullptr; // Optional
 
         if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
@@ -70,13 +70,80 @@ public:
         }
     }
 
+    // called on the host right before the commands of pathId are submitted,
+    // e.g. to read back results of the previous submission of the path
+    // or to update host visible buffers
+    virtual void _update(uint32_t pathId) {
+    }
+
+    // marks the results of the element as outdated, graphs that skip unchanged
+    // elements submit it and all elements depending on it again for every path
+    void setChanged() {
+        changeCount++;
+    }
+
+    virtual uint64_t getChangeCount() const {
+        return changeCount;
+    }
+
+    // marks the recorded commands of the element as outdated, e.g. after changing its
+    // push constants or group counts, the graph records them again before the
+    // next submission of each path
+    void setRecordOutdated() {
+        recordCount++;
+        changeCount++;
+    }
+
+    uint64_t getRecordCount() const {
+        return recordCount;
+    }
+
+    // dynamic elements are recorded again before every submission of a path from a command
+    // pool of the path that is reset as a whole, so their push constants or group counts
+    // can change every frame without setRecordOutdated and without waiting for the queue,
+    // graphs that skip unchanged elements still need setChanged, has to be set before the compile
+    void setDynamic(bool dynamic) {
+        this->dynamic = dynamic;
+    }
+
+    bool isDynamic() const {
+        return dynamic;
+    }
+
+    // marks the resources of the element (images, image views, buffers) as replaced,
+    // e.g. after the swapchain was recreated, the graph calls _inputsChanged of the
+    // elements using them and records them again before the next submission of each path
+    void setResourcesOutdated() {
+        resourceCount++;
+        recordCount++;
+        changeCount++;
+    }
+
+    // elements forwarding the resources of their inputs include the count of the inputs
+    virtual uint64_t getResourceCount() const {
+        return resourceCount;
+    }
+
+    // called by the graph before the commands of pathId are recorded again, if the resources
+    // of one of the inputs were replaced, e.g. to update descriptor sets or framebuffers,
+    // the commands of the path are not in use anymore at this point
+    virtual void _inputsChanged(uint32_t pathId) {
+    }
+
+    // true if the element has to be submitted whenever one of its outputs is,
+    // e.g. because it resets a buffer its outputs accumulate into
+    virtual bool isRequiredByOutputs() const {
+        return false;
+    }
+
     virtual const char* getType() const = 0;
 
     virtual const char* getName() const {
         return name.c_str();
     }
     
-    virtual std::map<int, ComputeGraphElementPtr> getInputs() const {
+    // the elements the graph connects this element to, not copied
+    virtual const std::map<int, ComputeGraphElementPtr>& getInputs() const {
         return inputs;
     }
 
@@ -93,6 +160,12 @@ protected:
 
     std::string name;
 
+    uint64_t changeCount = 0;
+    uint64_t recordCount = 0;
+    uint64_t resourceCount = 0;
+
+    bool dynamic = false;
+
 private:
     // these are updated by the ComputeGraph, do not set them manually
     // it is important to reset them before destroying the graph
@@ -12,7 +12,7 @@ public:
         return "ComputeGraphGroup";
     }
 
-    virtual std::map<int, ComputeGraphElementPtr> getInputs() const {
+    virtual const std::map<int, ComputeGraphElementPtr>& getInputs() const {
         return outputElements;
     }
 
@@ -0,0 +1,165 @@
+#ifndef KLARTRAUM_COMPUTEGRAPH_FRAMEIMAGE_HPP
+#define KLARTRAUM_COMPUTEGRAPH_FRAMEIMAGE_HPP
+
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "klartraum/computegraph/imageviewsrc.hpp"
+
+namespace klartraum {
+
+/**
+ * @brief Offscreen images the graph renders a frame to, one per path.
+ *
+ * The paths of the graphs of the engine are the frames in flight, so the images are not
+ * tied to the swapchain images. The engine copies the image of the path to the acquired
+ * swapchain image after the graph, which is the only command bound to a swapchain image.
+ * Like the swapchain images, the graph leaves them in VK_IMAGE_LAYOUT_PRESENT_SRC_KHR.
+ */
+class FrameImage : public ImageViewSrc {
+public:
+    FrameImage(VkFormat format, VkExtent2D extent) : format(format) {
+        setExtent(extent);
+    };
+
+    ~FrameImage() {
+        if (vulkanContext == nullptr) {
+            return;
+        }
+        for (uint32_t i = 0; i < images.size(); i++) {
+            destroyImage(i);
+        }
+    };
+
+    virtual void checkInput(ComputeGraphElementPtr input, int index = 0) {
+        throw std::runtime_error("FrameImage has no inputs!");
+    }
+
+    virtual const char* getType() const {
+        return "FrameImage";
+    }
+
+    VkFormat getFormat() const {
+        return format;
+    }
+
+    // replaces the images by ones of the new extent, e.g. after the swapchain was recreated,
+    // the images must not be in use
+    void resize(VkExtent2D extent) {
+        setExtent(extent);
+        if (vulkanContext == nullptr) {
+            return;
+        }
+        for (uint32_t i = 0; i < images.size(); i++) {
+            destroyImage(i);
+            createImage(i);
+        }
+        setResourcesOutdated();
+    }
+
+    VkImageView& getImageView(uint32_t pathId) override {
+        if (pathId >= imageViews.size()) {
+            throw std::runtime_error("pathId out of range!");
+        }
+        return imageViews[pathId];
+    }
+
+    VkImage& getImage(uint32_t pathId) override {
+        if (pathId >= images.size()) {
+            throw std::runtime_error("pathId out of range!");
+        }
+        return images[pathId];
+    }
+
+    virtual void _setup(VulkanContext& vulkanContext, uint32_t numberPaths) {
+        // set up again if used by another graph, e.g. by GaussianKernelTuner
+        for (uint32_t i = 0; i < images.size(); i++) {
+            destroyImage(i);
+        }
+        this->vulkanContext = &vulkanContext;
+
+        images.resize(numberPaths);
+        imageViews.resize(numberPaths);
+        imageMemories.resize(numberPaths);
+
+        for (uint32_t i = 0; i < numberPaths; i++) {
+            createImage(i);
+        }
+        initialized = true;
+    }
+
+private:
+    VulkanContext* vulkanContext = nullptr;
+    VkFormat format;
+
+    std::vector<VkImage> images;
+    std::vector<VkImageView> imageViews;
+    std::vector<VkDeviceMemory> imageMemories;
+
+    void createImage(uint32_t pathId) {
+        auto& device = vulkanContext->getDevice();
+
+        VkExtent2D extent = getExtent();
+        if (extent.width == 0 || extent.height == 0) {
+            throw std::runtime_error("frame image has no extent!");
+        }
+
+        VkImageCreateInfo imageInfo{};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.extent = {extent.width, extent.height, 1};
+        imageInfo.mipLevels = 1;
+        imageInfo.arrayLayers = 1;
+        imageInfo.format = format;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        // rendered to like the swapchain images and copied to them
+        imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+        if (vkCreateImage(device, &imageInfo, nullptr, &images[pathId]) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create image!");
+        }
+
+        VkMemoryRequirements memRequirements;
+        vkGetImageMemoryRequirements(device, images[pathId], &memRequirements);
+
+        VkMemoryAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocInfo.allocationSize = memRequirements.size;
+        allocInfo.memoryTypeIndex = vulkanContext->findMemoryType(memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+        if (vkAllocateMemory(device, &allocInfo, nullptr, &imageMemories[pathId]) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate image memory!");
+        }
+        vkBindImageMemory(device, images[pathId], imageMemories[pathId], 0);
+
+        VkImageViewCreateInfo viewInfo{};
+        viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        viewInfo.image = images[pathId];
+        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        viewInfo.format = format;
+        viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        viewInfo.subresourceRange.baseMipLevel = 0;
+        viewInfo.subresourceRange.levelCount = 1;
+        viewInfo.subresourceRange.baseArrayLayer = 0;
+        viewInfo.subresourceRange.layerCount = 1;
+
+        if (vkCreateImageView(device, &viewInfo, nullptr, &imageViews[pathId]) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create image view!");
+        }
+    }
+
+    void destroyImage(uint32_t pathId) {
+        auto& device = vulkanContext->getDevice();
+        vkDestroyImageView(device, imageViews[pathId], nullptr);
+        vkDestroyImage(device, images[pathId], nullptr);
+        vkFreeMemory(device, imageMemories[pathId], nullptr);
+    }
+};
+
+} // namespace klartraum
+
+#endif // KLARTRAUM_COMPUTEGRAPH_FRAMEIMAGE_HPP
@@ -26,8 +26,10 @@ public:
         if(initialized) {
             vkDestroyPipelineLayout(vulkanContext->getDevice(), computePipelineLayout, nullptr);
             vkDestroyPipeline(vulkanContext->getDevice(), computePipeline, nullptr);
-            vkDestroyDescriptorSetLayout(vulkanContext->getDevice(), computeDescriptorSetLayout, nullptr);
-            vkDestroyDescriptorPool(vulkanContext->getDevice(), descriptorPool, nullptr);
+            if (!bufferAddressMode) {
+                vkDestroyDescriptorSetLayout(vulkanContext->getDevice(), computeDescriptorSetLayout, nullptr);
+                vulkanContext->getDescriptorAllocator().free(computeDescriptorSets);
+            }
         }
     }
 
@@ -35,23 +37,59 @@ public:
         this->numberPaths = numberPaths;
         this->vulkanContext = &vulkanContext;
 
-        createDescriptorPool();
-        createComputeDescriptorSetLayout();
-        createComputePipeline();
-        
         uint32_t inputSize = (uint32_t)inputs.size();
         if (inputSize == 0) {
             throw std::runtime_error("input size is 0!");
         }
 
-        computeDescriptorSets.resize(numberPaths);
-        for(uint32_t i = 0; i < numberPaths; i++) {
-            createComputeDescriptorSets(i);
+        resolveInputs();
+        if (bufferAddressMode) {
+            if (!vulkanContext.hasBufferDeviceAddress()) {
+                throw std::runtime_error("buffer address mode needs buffer device addresses!");
+            }
+            if (!imageInputs.empty()) {
+                throw std::runtime_error("buffer address mode supports no image inputs!");
+            }
+            createComputePipeline();
+            createAddressTables();
+        } else {
+            createComputeDescriptorSetLayout();
+            createComputePipeline();
+            createComputeDescriptorSets();
         }
 
         initialized = true;
     }
 
+    // a struct of 32 bit members, the i-th member is given to constant_id i of the shaders,
+    // e.g. to adapt the workgroup size to the device, has to be set before the setup
+    template <typename S>
+    void setSpecializationConstants(const S& constants) {
+        if (initialized) {
+            throw std::runtime_error("specialization constants have to be set before the setup!");
+        }
+        specializationConstants = SpecializationConstants(constants);
+    }
+
+    /*
+     * Instead of descriptors, the shader gets the addresses of its inputs: the push constants
+     * end with the address of a table (aligned to 8 bytes after P) holding the address of
+     * every input by its index, see shaders/operator_double_address.comp. The pipeline layout
+     * has no descriptor sets then and replacing an input only rewrites the table of the path.
+     * Needs buffer device addresses (VulkanContext::hasBufferDeviceAddress), buffers and
+     * uniform buffers only, has to be set before the setup.
+     */
+    void setBufferAddressMode(bool enabled) {
+        if (initialized) {
+            throw std::runtime_error("buffer address mode has to be set before the setup!");
+        }
+        bufferAddressMode = enabled;
+    }
+
+    bool getBufferAddressMode() const {
+        return bufferAddressMode;
+    }
+
     void setGroupCount(uint32_t countX, uint32_t countY, uint32_t countZ) {
         groupCountX = countX;
         groupCountY = countY;
@@ -94,38 +132,40 @@ public:
 
     virtual void _record(VkCommandBuffer commandBuffer, uint32_t pathId) {
         vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipeline);
-        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipelineLayout, 0, 1, &computeDescriptorSets[pathId], 0, 0);
+        if (bufferAddressMode) {
+            // kept while P is pushed, the ranges do not overlap
+            VkDeviceAddress tableAddress = addressTableAddresses[pathId];
+            vkCmdPushConstants(commandBuffer, computePipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, getAddressTableOffset(), sizeof(VkDeviceAddress), &tableAddress);
+        } else {
+            vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipelineLayout, 0, 1, &computeDescriptorSets[pathId], 0, 0);
+        }
 
         // Add memory barriers for all ImageViewSrc inputs
-        for (int i = 0; i < inputs.size(); i++) {
-            ComputeGraphElementPtr input = getInputElement(i);
-            ImageViewSrc* imageElement = dynamic_cast<ImageViewSrc*>(input.get());
-            if (imageElement) {
-                VkImageMemoryBarrier imageBarrier{};
-                imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-                imageBarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-                imageBarrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
-                imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-                imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-                imageBarrier.image = imageElement->getImage(pathId);
-                imageBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-                imageBarrier.subresourceRange.baseMipLevel = 0;
-                imageBarrier.subresourceRange.levelCount = 1;
-                imageBarrier.subresourceRange.baseArrayLayer = 0;
-                imageBarrier.subresourceRange.layerCount = 1;
-                imageBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
-                imageBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-                vkCmdPipelineBarrier(
-                    commandBuffer,
-                    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-                    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-                    0,
-                    0, nullptr,
-                    0, nullptr,
-                    1, &imageBarrier
-                );
-            }
+        for (ImageViewSrc* imageElement : imageInputs) {
+            VkImageMemoryBarrier imageBarrier{};
+            imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            imageBarrier.oldLayout = imageElement->getLayout();
+            imageBarrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+            imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            imageBarrier.image = imageElement->getImage(pathId);
+            imageBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            imageBarrier.subresourceRange.baseMipLevel = 0;
+            imageBarrier.subresourceRange.levelCount = 1;
+            imageBarrier.subresourceRange.baseArrayLayer = 0;
+            imageBarrier.subresourceRange.layerCount = 1;
+            imageBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+            imageBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+            vkCmdPipelineBarrier(
+                commandBuffer,
+                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                0,
+                0, nullptr,
+                0, nullptr,
+                1, &imageBarrier
+            );
         }
 
         if constexpr (std::is_void<P>::value) {
@@ -156,6 +196,15 @@ public:
         }
     }
 
+    // the descriptor set or the address table of the path refers to the replaced images or buffers of the inputs
+    virtual void _inputsChanged(uint32_t pathId) {
+        if (bufferAddressMode) {
+            writeAddressTable(pathId);
+        } else {
+            writeComputeDescriptorSet(pathId);
+        }
+    }
+
     virtual void checkInput(ComputeGraphElementPtr input, int index = 0) {
         BufferElementInterface* bufferSrc = std::dynamic_pointer_cast<BufferElementInterface>(input).get();
         ImageViewSrc* imageSrc = std::dynamic_pointer_cast<ImageViewSrc>(input).get();
@@ -174,6 +223,12 @@ public:
         return "GeneralComputation";
     }    
 
+protected:
+    // the image bound to input index, resolved during the setup, nullptr for other inputs
+    ImageViewSrc* getImageInput(int index) const {
+        return resolvedInputs.at(index).image;
+    }
+
     // BufferElementInterface& getOutputBuffer(uint32_t pathId = 0) {
     //     return this->outputBuffers[pathId];
     // }
@@ -183,11 +238,29 @@ public:
     // }
 
 private:
-    VkDescriptorPool descriptorPool;
+    // an input of the shader with its type resolved, the element is kept alive by the inputs
+    struct ResolvedInput {
+        VkDescriptorType descriptorType = VK_DESCRIPTOR_TYPE_MAX_ENUM;
+        ImageViewSrc* image = nullptr;
+        BufferElementInterface* buffer = nullptr;
+        UniformBufferObjectInterface* ubo = nullptr;
+    };
+
+    // by binding, resolved once during the setup so that recording the commands
+    // and writing the descriptor sets again needs no casts and no lookups of the inputs
+    std::vector<ResolvedInput> resolvedInputs;
+    std::vector<ImageViewSrc*> imageInputs; // barriers are recorded for them
+
     std::vector<VkDescriptorSet> computeDescriptorSets;
-    VkDescriptorSetLayout computeDescriptorSetLayout;
+    VkDescriptorSetLayout computeDescriptorSetLayout = VK_NULL_HANDLE;
+
+    // per path, the addresses of the inputs and the address of that table, used instead of the descriptor sets
+    bool bufferAddressMode = false;
+    std::vector<VulkanBuffer<VkDeviceAddress>> addressTables;
+    std::vector<VkDeviceAddress> addressTableAddresses;
     VkPipelineLayout computePipelineLayout;
-    VkPipeline computePipeline;
+    VkPipeline computePipeline = VK_NULL_HANDLE;
+    SpecializationConstants specializationConstants;
 
     VulkanContext* vulkanContext;
 
@@ -208,38 +281,34 @@ private:
     std::conditional_t<!std::is_void<P>::value, std::vector<P>, void*> pushConstants;
     std::shared_ptr<DispatchIndirectCommandBufferElement> dynamicGroupDispatchParams;
 
-    static VkDescriptorType getDescriptorType(const ComputeGraphElementPtr& input) {
-        if (dynamic_cast<ImageViewSrc*>(input.get())) {
-            return VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-        } else if (dynamic_cast<BufferElementInterface*>(input.get())) {
-            return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-        } else if (dynamic_cast<UniformBufferObjectInterface*>(input.get())) {
-            return VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    void resolveInputs() {
+        resolvedInputs.assign(inputs.size(), ResolvedInput());
+        imageInputs.clear();
+        for (size_t i = 0; i < inputs.size(); i++) {
+            ComputeGraphElement* input = getInputElement((int)i).get();
+            ResolvedInput& resolved = resolvedInputs[i];
+            if ((resolved.image = dynamic_cast<ImageViewSrc*>(input)) != nullptr) {
+                resolved.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+                imageInputs.push_back(resolved.image);
+            } else if ((resolved.buffer = dynamic_cast<BufferElementInterface*>(input)) != nullptr) {
+                resolved.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            } else if ((resolved.ubo = dynamic_cast<UniformBufferObjectInterface*>(input)) != nullptr) {
+                resolved.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+            } else {
+                throw std::runtime_error("Input type not supported for descriptor set layout");
+            }
         }
-        return VK_DESCRIPTOR_TYPE_MAX_ENUM; // Invalid type
     }
 
-    void createDescriptorPool() {
-        auto& device = vulkanContext->getDevice();
-        
-        std::vector<VkDescriptorPoolSize> poolSizes(inputs.size());
-        // Other inputs
+    // the descriptors of a single set, one per binding
+    std::vector<VkDescriptorPoolSize> getDescriptorSetSizes() const {
+        std::vector<VkDescriptorPoolSize> sizes(inputs.size());
         for (size_t i = 0; i < inputs.size(); i++) {
-            ComputeGraphElementPtr inputPtr = getInputElement(i);
-            poolSizes[i].type = getDescriptorType(inputPtr);
-            poolSizes[i].descriptorCount = numberPaths;
+            sizes[i].type = resolvedInputs[i].descriptorType;
+            sizes[i].descriptorCount = 1;
         }
-        
-        VkDescriptorPoolCreateInfo poolInfo{};
-        poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-        poolInfo.poolSizeCount = (uint32_t)poolSizes.size();
-        poolInfo.pPoolSizes = poolSizes.data();
-        poolInfo.maxSets = numberPaths;
-    
-        if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS) {
-            throw std::runtime_error("failed to create descriptor pool!");
-        }
-    }    
+        return sizes;
+    }
 
     void createComputeDescriptorSetLayout() {
         auto& device = vulkanContext->getDevice();
@@ -247,18 +316,9 @@ private:
         std::vector<VkDescriptorSetLayoutBinding> layoutBindings(inputs.size());
     
         for (int i = 0; i < inputs.size(); i++) {
-            ComputeGraphElementPtr inputPtr = getInputElement(i);
-
-            VkDescriptorType descriptorType = getDescriptorType(inputPtr);
-
-
-            if (descriptorType == VK_DESCRIPTOR_TYPE_MAX_ENUM) {
-                throw std::runtime_error("Input type not supported for descriptor set layout");
-            }
-
             layoutBindings[i].binding = i;
             layoutBindings[i].descriptorCount = 1;
-            layoutBindings[i].descriptorType = descriptorType;
+            layoutBindings[i].descriptorType = resolvedInputs[i].descriptorType;
             layoutBindings[i].pImmutableSamplers = nullptr;
             layoutBindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
         }
@@ -273,18 +333,16 @@ private:
         }
     }
 
-    void createComputeDescriptorSets(uint32_t pathId) {
-        auto& device = vulkanContext->getDevice();
-
-        VkDescriptorSetAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-        allocInfo.descriptorPool = descriptorPool;
-        allocInfo.descriptorSetCount = 1;
-        allocInfo.pSetLayouts = &computeDescriptorSetLayout;
-    
-        if (vkAllocateDescriptorSets(device, &allocInfo, &computeDescriptorSets[pathId]) != VK_SUCCESS) {
-            throw std::runtime_error("failed to allocate descriptor sets!");
+    // one set per path
+    void createComputeDescriptorSets() {
+        computeDescriptorSets = vulkanContext->getDescriptorAllocator().allocate(computeDescriptorSetLayout, getDescriptorSetSizes(), numberPaths);
+        for (uint32_t pathId = 0; pathId < numberPaths; pathId++) {
+            writeComputeDescriptorSet(pathId);
         }
+    }
+
+    void writeComputeDescriptorSet(uint32_t pathId) {
+        auto& device = vulkanContext->getDevice();
 
         // creates memory for the descriptor sets 
         // that is alive until the method goes out of scope
@@ -296,12 +354,9 @@ private:
 
         std::vector<VkWriteDescriptorSet> descriptorWrites{inputs.size()};
         for(int i = 0; i < inputs.size(); i++) {
-            ComputeGraphElementPtr inputPtr = getInputElement(i);
-
-            // Cast input to BufferElement to access underlying buffer
-            BufferElementInterface* bufferElement = dynamic_cast<BufferElementInterface*>(inputPtr.get());
-            ImageViewSrc* imageElement = dynamic_cast<ImageViewSrc*>(inputPtr.get());
-            UniformBufferObjectInterface* uboElement = dynamic_cast<UniformBufferObjectInterface*>(inputPtr.get());
+            BufferElementInterface* bufferElement = resolvedInputs[i].buffer;
+            ImageViewSrc* imageElement = resolvedInputs[i].image;
+            UniformBufferObjectInterface* uboElement = resolvedInputs[i].ubo;
 
             
             if (imageElement) {
@@ -357,29 +412,56 @@ private:
         vkUpdateDescriptorSets(device, (uint32_t)descriptorWrites.size(), descriptorWrites.data(), 0, nullptr);
     }
 
+    // the address of the table follows P in the push constants
+    static constexpr uint32_t getAddressTableOffset() {
+        if constexpr (std::is_void<P>::value) {
+            return 0;
+        } else {
+            return (uint32_t)((sizeof(P) + 7) & ~size_t(7));
+        }
+    }
+
+    // one table per path, the buffers are host visible and only written while the path is not in use
+    void createAddressTables() {
+        addressTables.clear();
+        addressTables.reserve(numberPaths);
+        addressTableAddresses.resize(numberPaths);
+        for (uint32_t pathId = 0; pathId < numberPaths; pathId++) {
+            addressTables.emplace_back(*vulkanContext, (uint32_t)inputs.size());
+            addressTableAddresses[pathId] = vulkanContext->getBufferDeviceAddress(addressTables[pathId].getBuffer());
+            writeAddressTable(pathId);
+        }
+    }
+
+    void writeAddressTable(uint32_t pathId) {
+        std::vector<VkDeviceAddress> addresses(inputs.size());
+        for (size_t i = 0; i < inputs.size(); i++) {
+            const ResolvedInput& resolved = resolvedInputs[i];
+            VkBuffer buffer = resolved.buffer ? resolved.buffer->getVkBuffer(pathId) : resolved.ubo->getVkBuffer(pathId);
+            addresses[i] = vulkanContext->getBufferDeviceAddress(buffer);
+        }
+        addressTables[pathId].memcopyFrom(addresses);
+    }
+
     void createComputePipeline() {
         auto& device = vulkanContext->getDevice();
 
-        auto computeShaderCode = readFile(shaderPath);
-    
-        VkShaderModule computeShaderModule = createShaderModule(computeShaderCode, vulkanContext->getDevice());
-        
-        VkPipelineShaderStageCreateInfo computeShaderStageInfo{};
-        computeShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-        computeShaderStageInfo.stage = VK_SHADER_STAGE_COMPUTE_BIT;
-        computeShaderStageInfo.module = computeShaderModule;
-        computeShaderStageInfo.pName = "main";
-    
         VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
         pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-        pipelineLayoutInfo.setLayoutCount = 1;
-        pipelineLayoutInfo.pSetLayouts = &computeDescriptorSetLayout;
+        if (!bufferAddressMode) {
+            pipelineLayoutInfo.setLayoutCount = 1;
+            pipelineLayoutInfo.pSetLayouts = &computeDescriptorSetLayout;
+        }
 
-        if constexpr (!std::is_void<P>::value) {
-            VkPushConstantRange pushConstantRange{};
-            pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
-            pushConstantRange.offset = 0;
+        VkPushConstantRange pushConstantRange{};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        pushConstantRange.offset = 0;
+        if (bufferAddressMode) {
+            pushConstantRange.size = getAddressTableOffset() + sizeof(VkDeviceAddress);
+        } else if constexpr (!std::is_void<P>::value) {
             pushConstantRange.size = sizeof(P);
+        }
+        if (pushConstantRange.size > 0) {
             pipelineLayoutInfo.pushConstantRangeCount = 1;
             pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
         }
@@ -387,17 +469,9 @@ private:
         if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &computePipelineLayout) != VK_SUCCESS) {
             throw std::runtime_error("failed to create compute pipeline layout!");
         }
-    
-        VkComputePipelineCreateInfo pipelineInfo{};
-        pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
-        pipelineInfo.layout = computePipelineLayout;
-        pipelineInfo.stage = computeShaderStageInfo;
-        
-        if (vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &computePipeline) != VK_SUCCESS) {
-            throw std::runtime_error("failed to create compute pipeline!");
-        }
-    
-        vkDestroyShaderModule(device, computeShaderModule, nullptr);        
+
+        // created right away or, during a graph compile, together with the other pipelines of the graph
+        vulkanContext->getPipelineBuilder().addComputePipeline(shaderPath, computePipelineLayout, &computePipeline, specializationConstants);
     }
     
     void recordScratchToZero(VkCommandBuffer commandBuffer) {
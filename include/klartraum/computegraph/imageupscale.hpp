@@ -0,0 +1,114 @@
+#ifndef KLARTRAUM_COMPUTEGRAPH_IMAGEUPSCALE_HPP
+#define KLARTRAUM_COMPUTEGRAPH_IMAGEUPSCALE_HPP
+
+#include "klartraum/computegraph/generalcomputation.hpp"
+#include "klartraum/computegraph/imageviewsrc.hpp"
+
+namespace klartraum {
+
+struct UpscalePushConstants {
+    uint32_t srcWidth;
+    uint32_t srcHeight;
+    uint32_t dstWidth;
+    uint32_t dstHeight;
+};
+
+/**
+ * @brief Upscales the used region of a (scaled) image and adds it to the destination image.
+ *
+ * Input 0 is the source, usually a ScaledImage given through the slot of the element rendering
+ * to it, so that the upscale runs after it. Input 1 is the destination, e.g. the RenderPass
+ * of the frame images. The source is sampled bilinearly and blended additively,
+ * like the gaussian splatting blends into its target image.
+ *
+ * The push constants follow the extents of both images, they are checked in _update.
+ * Since the extent of the source changes often with a dynamic resolution,
+ * the element is dynamic and recorded before every submission.
+ */
+class ImageUpscale : public GeneralComputation<UpscalePushConstants> {
+public:
+    ImageUpscale(VulkanContext& vulkanContext, const std::string& shaderPath = "shaders/image_upscale.comp.spv") :
+        GeneralComputation<UpscalePushConstants>(vulkanContext, shaderPath) {
+        setPushConstants({{0, 0, 0, 0}});
+        setDynamic(true);
+    }
+
+    virtual const char* getType() const {
+        return "ImageUpscale";
+    }
+
+    virtual void checkInput(ComputeGraphElementPtr input, int index = 0) {
+        ImageViewSrc* imageViewSrc = std::dynamic_pointer_cast<ImageViewSrc>(input).get();
+        if (imageViewSrc == nullptr) {
+            throw std::runtime_error("input is not an ImageViewSrc!");
+        }
+        if (index > 1) {
+            throw std::runtime_error("input index out of range!");
+        }
+    }
+
+    virtual void _setup(VulkanContext& vulkanContext, uint32_t numberPaths) {
+        GeneralComputation<UpscalePushConstants>::_setup(vulkanContext, numberPaths);
+        updateExtents();
+    }
+
+    virtual void _update(uint32_t pathId) {
+        // recorded afterwards with the new extents
+        updateExtents();
+    }
+
+    virtual void _record(VkCommandBuffer commandBuffer, uint32_t pathId) {
+        GeneralComputation<UpscalePushConstants>::_record(commandBuffer, pathId);
+
+        // this is the last element writing to the destination
+        ImageViewSrc* destination = getImageInput(1);
+
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = destination->getImage(pathId);
+        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.baseMipLevel = 0;
+        barrier.subresourceRange.levelCount = 1;
+        barrier.subresourceRange.baseArrayLayer = 0;
+        barrier.subresourceRange.layerCount = 1;
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+            0,
+            0, nullptr,
+            0, nullptr,
+            1, &barrier);
+    }
+
+private:
+    VkExtent2D srcExtent = {0, 0};
+    VkExtent2D dstExtent = {0, 0};
+
+    void updateExtents() {
+        VkExtent2D src = getImageInput(0)->getExtent();
+        VkExtent2D dst = getImageInput(1)->getExtent();
+        if (src.width == srcExtent.width && src.height == srcExtent.height &&
+            dst.width == dstExtent.width && dst.height == dstExtent.height) {
+            return;
+        }
+        srcExtent = src;
+        dstExtent = dst;
+
+        setPushConstants({{src.width, src.height, dst.width, dst.height}});
+        // one thread per destination pixel, see image_upscale.comp
+        setGroupCount((dst.width + 7) / 8, (dst.height + 7) / 8, 1);
+        setChanged();
+    }
+};
+
+} // namespace klartraum
+
+#endif // KLARTRAUM_COMPUTEGRAPH_IMAGEUPSCALE_HPP
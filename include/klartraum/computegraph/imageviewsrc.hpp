@@ -48,10 +48,39 @@ public:
         }
         return images[pathId];
     }
+
+    // replaces the images, e.g. after the swapchain was recreated,
+    // the elements using them update their descriptor sets and framebuffers
+    void setImageViews(std::vector<VkImageView> imageViews, std::vector<VkImage> images) {
+        this->imageViews = imageViews;
+        this->images = images;
+        setResourcesOutdated();
+    }
+
+    // size of the images, elements rendering to them adapt to it,
+    // zero if unknown
+    void setExtent(VkExtent2D extent) {
+        if (extent.width != this->extent.width || extent.height != this->extent.height) {
+            this->extent = extent;
+            setChanged();
+        }
+    }
+
+    virtual VkExtent2D getExtent() const {
+        return extent;
+    }
+
+    // layout the elements keep the image in between each other, so that the
+    // elements reading it keep its contents, undefined if the contents are
+    // not kept, e.g. for presented images that are written completely
+    virtual VkImageLayout getLayout() const {
+        return VK_IMAGE_LAYOUT_UNDEFINED;
+    }
     
 private:
     std::vector<VkImageView> imageViews;
     std::vector<VkImage> images;
+    VkExtent2D extent = {0, 0};
 };
 
 class ImageSrc : public ComputeGraphElement {
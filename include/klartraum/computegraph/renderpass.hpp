@@ -6,6 +6,7 @@
 #include <vulkan/vulkan.h>
 #include "klartraum/computegraph/imageviewsrc.hpp"
 #include "klartraum/computegraph/rendergraphelement.hpp"
+#include "klartraum/parallel_for.hpp"
 
 namespace klartraum {
 
@@ -23,7 +24,10 @@ public:
             vkDestroyFramebuffer(device, framebuffer, nullptr);
         }
         vkDestroyRenderPass(device, renderPass, nullptr);
-
+        // destroying the command pools frees the secondary command buffers
+        for (auto commandPool : secondaryCommandPools) {
+            vkDestroyCommandPool(device, commandPool, nullptr);
+        }
     };
 
     virtual void checkInput(ComputeGraphElementPtr input, int index = 0) {
@@ -46,6 +50,7 @@ public:
 
     virtual void _setup(VulkanContext& vulkanContext, uint32_t numberPaths) {
         this->vulkanContext = &vulkanContext;
+        target = getTarget();
         
         auto& device = vulkanContext.getDevice();
 
@@ -99,35 +104,26 @@ public:
         framebuffers.resize(numberPaths);
 
         for (uint32_t i = 0; i < framebuffers.size(); i++) {
-            VkImageView imageView = this->getImageView(i);
-            VkImageView attachments[] = {
-                imageView
-            }; 
-    
-            // TODO create framebuffer with render pass computegraph element
-            // and create imageviewsrc instead of framebuffer src
-    
-            VkFramebufferCreateInfo framebufferInfo{};
-            framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-            framebufferInfo.renderPass = renderPass;
-            framebufferInfo.attachmentCount = 1;
-            framebufferInfo.pAttachments = attachments;
-            framebufferInfo.width = swapChainExtent.width;
-            framebufferInfo.height = swapChainExtent.height;
-            framebufferInfo.layers = 1;
-    
-            if (vkCreateFramebuffer(device, &framebufferInfo, nullptr, &framebuffers[i]) != VK_SUCCESS) {
-                throw std::runtime_error("failed to create framebuffer!");
-            }
+            createFramebuffer(i);
         }
 
         auto cameraUBO = getCameraUBO();
         for(auto& drawComponent : drawComponents) {
             drawComponent->initialize(vulkanContext, renderPass, cameraUBO);
         }
+
+        if (parallelRecording && !drawComponents.empty()) {
+            createSecondaryCommandBuffers(numberPaths);
+        }
     };
 
 
+    // the swapchain was recreated, the framebuffer of the path is created again for the new image view and extent
+    virtual void _inputsChanged(uint32_t pathId) {
+        vkDestroyFramebuffer(vulkanContext->getDevice(), framebuffers[pathId], nullptr);
+        createFramebuffer(pathId);
+    }
+
     virtual void _record(VkCommandBuffer commandBuffer, uint32_t pathId) {
         // auto& camera = vulkanContext->getCamera();
         // auto& vertices = getVertices(type);
@@ -165,12 +161,21 @@ public:
         renderPassInfo.framebuffer = framebuffers[pathId];
     
         renderPassInfo.renderArea.offset = { 0, 0 };
-        renderPassInfo.renderArea.extent = swapChainExtent;
+        renderPassInfo.renderArea.extent = getFramebufferExtent();
     
         VkClearValue clearColor = { {{0.0f, 0.0f, 0.0f, 1.0f}} };
         renderPassInfo.clearValueCount = 1;
         renderPassInfo.pClearValues = &clearColor;
     
+        if (!secondaryCommandBuffers.empty()) {
+            recordSecondaryCommandBuffers(pathId);
+            // the draw components are executed in the order they were added
+            vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+            vkCmdExecuteCommands(commandBuffer, (uint32_t)drawComponents.size(), &secondaryCommandBuffers[pathId * drawComponents.size()]);
+            vkCmdEndRenderPass(commandBuffer);
+            return;
+        }
+
         vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
         for(auto& drawComponent : drawComponents) {
             drawComponent->recordCommandBuffer(commandBuffer, framebuffers[pathId], pathId);
@@ -184,26 +189,41 @@ public:
         drawComponents.push_back(drawComponent);
     }
 
+    // records each draw component into a secondary command buffer on worker threads,
+    // worth it for many draw components, especially if the pass is dynamic,
+    // recordCommandBuffer of different draw components may then run concurrently,
+    // has to be set before the setup
+    void setParallelRecording(bool parallel) {
+        parallelRecording = parallel;
+    }
+
     VkImageView& getImageView(uint32_t pathId) override {
-        if(inputs.size() == 0) {
-            throw std::runtime_error("no input!");
-        }
-        ImageViewSrc* imageViewSrc = std::dynamic_pointer_cast<ImageViewSrc>(getInputElement(0)).get();
-        if (imageViewSrc == nullptr) {
-            throw std::runtime_error("input is not an ImageViewSrc!");
-        }
-        return imageViewSrc->getImageView(pathId);
+        return getTarget()->getImageView(pathId);
     }
 
     VkImage& getImage(uint32_t pathId) override {
-        if(inputs.size() == 0) {
+        return getTarget()->getImage(pathId);
+    }
+
+    VkExtent2D getExtent() const override {
+        auto input = inputs.find(0);
+        if (input == inputs.end()) {
             throw std::runtime_error("no input!");
         }
-        ImageViewSrc* imageViewSrc = std::dynamic_pointer_cast<ImageViewSrc>((getInputElement(0))).get();
+        auto imageViewSrc = std::dynamic_pointer_cast<ImageViewSrc>(input->second);
         if (imageViewSrc == nullptr) {
             throw std::runtime_error("input is not an ImageViewSrc!");
         }
-        return imageViewSrc->getImage(pathId);
+        return imageViewSrc->getExtent();
+    }
+
+    // the images are the ones of the input
+    uint64_t getResourceCount() const override {
+        auto input = inputs.find(0);
+        if (input == inputs.end()) {
+            return resourceCount;
+        }
+        return resourceCount + input->second->getResourceCount();
     }
 
 private:
@@ -216,6 +236,128 @@ private:
 
     std::vector<std::shared_ptr<DrawComponent> > drawComponents;
 
+    bool parallelRecording = false;
+    size_t recordThreads = 1;
+
+    // per path and worker of the thread pool of the context, indexed by pathId * recordThreads + worker
+    std::vector<VkCommandPool> secondaryCommandPools;
+    // per path and draw component, indexed by pathId * drawComponents.size() + index,
+    // draw component index is recorded by worker index % recordThreads
+    std::vector<VkCommandBuffer> secondaryCommandBuffers;
+
+    // the image the pass renders to, resolved during the setup
+    // so that recording the pass needs no cast
+    ImageViewSrc* target = nullptr;
+
+    ImageViewSrc* getTarget() {
+        if (target != nullptr) {
+            return target;
+        }
+        if(inputs.size() == 0) {
+            throw std::runtime_error("no input!");
+        }
+        ImageViewSrc* imageViewSrc = std::dynamic_pointer_cast<ImageViewSrc>(getInputElement(0)).get();
+        if (imageViewSrc == nullptr) {
+            throw std::runtime_error("input is not an ImageViewSrc!");
+        }
+        return imageViewSrc;
+    }
+
+    // the extent given to the constructor is used if the input does not know its extent
+    VkExtent2D getFramebufferExtent() const {
+        VkExtent2D extent = getExtent();
+        if (extent.width == 0 || extent.height == 0) {
+            return swapChainExtent;
+        }
+        return extent;
+    }
+
+    void createSecondaryCommandBuffers(uint32_t numberPaths) {
+        auto& device = vulkanContext->getDevice();
+        size_t numberComponents = drawComponents.size();
+        recordThreads = vulkanContext->getThreadPool().getNumberThreads(numberComponents);
+
+        secondaryCommandPools.resize(numberPaths * recordThreads, VK_NULL_HANDLE);
+        for (auto& commandPool : secondaryCommandPools) {
+            VkCommandPoolCreateInfo poolInfo{};
+            poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+            poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+            poolInfo.queueFamilyIndex = vulkanContext->getQueueFamilyIndices().graphicsAndComputeFamily.value();
+
+            if (vkCreateCommandPool(device, &poolInfo, nullptr, &commandPool) != VK_SUCCESS) {
+                throw std::runtime_error("failed to create command pool!");
+            }
+        }
+
+        secondaryCommandBuffers.resize(numberPaths * numberComponents, VK_NULL_HANDLE);
+        for (uint32_t pathId = 0; pathId < numberPaths; pathId++) {
+            for (size_t i = 0; i < numberComponents; i++) {
+                VkCommandBufferAllocateInfo allocInfo{};
+                allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+                allocInfo.commandPool = secondaryCommandPools[pathId * recordThreads + i % recordThreads];
+                allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+                allocInfo.commandBufferCount = 1;
+
+                if (vkAllocateCommandBuffers(device, &allocInfo, &secondaryCommandBuffers[pathId * numberComponents + i]) != VK_SUCCESS) {
+                    throw std::runtime_error("failed to allocate command buffers!");
+                }
+            }
+        }
+    }
+
+    // the primary command buffer of the path is not in use, so neither are its secondaries
+    void recordSecondaryCommandBuffers(uint32_t pathId) {
+        size_t numberComponents = drawComponents.size();
+
+        VkCommandBufferInheritanceInfo inheritanceInfo{};
+        inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+        inheritanceInfo.renderPass = renderPass;
+        inheritanceInfo.subpass = 0;
+        inheritanceInfo.framebuffer = framebuffers[pathId];
+
+        vulkanContext->getThreadPool().forEachWorker(recordThreads, [&](size_t thread) {
+            for (size_t i = thread; i < numberComponents; i += recordThreads) {
+                VkCommandBuffer commandBuffer = secondaryCommandBuffers[pathId * numberComponents + i];
+                vkResetCommandBuffer(commandBuffer, 0);
+
+                VkCommandBufferBeginInfo beginInfo{};
+                beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+                beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+                beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+                if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+                    throw std::runtime_error("failed to begin recording command buffer!");
+                }
+                drawComponents[i]->recordCommandBuffer(commandBuffer, framebuffers[pathId], pathId);
+                if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+                    throw std::runtime_error("failed to record command buffer!");
+                }
+            }
+        });
+    }
+
+    void createFramebuffer(uint32_t pathId) {
+        VkImageView imageView = this->getImageView(pathId);
+        VkImageView attachments[] = {
+            imageView
+        };
+
+        VkExtent2D extent = getFramebufferExtent();
+
+        VkFramebufferCreateInfo framebufferInfo{};
+        framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+        framebufferInfo.renderPass = renderPass;
+        framebufferInfo.attachmentCount = 1;
+        framebufferInfo.pAttachments = attachments;
+        framebufferInfo.width = extent.width;
+        framebufferInfo.height = extent.height;
+        framebufferInfo.layers = 1;
+
+        if (vkCreateFramebuffer(vulkanContext->getDevice(), &framebufferInfo, nullptr, &framebuffers[pathId]) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create framebuffer!");
+        }
+    }
+
 };
 
 typedef std::shared_ptr<RenderPass> RenderPassPtr;
@@ -0,0 +1,250 @@
+#ifndef KLARTRAUM_COMPUTEGRAPH_SCALEDIMAGE_HPP
+#define KLARTRAUM_COMPUTEGRAPH_SCALEDIMAGE_HPP
+
+#include <algorithm>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "klartraum/computegraph/imageviewsrc.hpp"
+
+namespace klartraum {
+
+/**
+ * @brief Offscreen images with the size of the input image, of which only a scaled region is used.
+ *
+ * Elements rendering to a ScaledImage adapt to its extent, which is the extent of the
+ * input image times the scale, starting at the top left corner. The images are allocated
+ * in full size once, so changing the scale does not reallocate anything,
+ * only replacing the input image (e.g. resizing the window) does.
+ * The images are cleared to zero before the elements render to them,
+ * see ImageUpscale to bring the result to the input image.
+ */
+class ScaledImage : public ImageViewSrc {
+public:
+    ScaledImage(VkFormat format = VK_FORMAT_R8G8B8A8_UNORM) : format(format) {};
+
+    ~ScaledImage() {
+        if (vulkanContext == nullptr) {
+            return;
+        }
+        for (uint32_t i = 0; i < images.size(); i++) {
+            destroyImage(i);
+        }
+    };
+
+    virtual void checkInput(ComputeGraphElementPtr input, int index = 0) {
+        ImageViewSrc* imageViewSrc = std::dynamic_pointer_cast<ImageViewSrc>(input).get();
+        if (index == 0 && imageViewSrc == nullptr) {
+            throw std::runtime_error("input is not an ImageViewSrc!");
+        }
+        if (index > 0) {
+            throw std::runtime_error("input index out of range!");
+        }
+    }
+
+    virtual const char* getType() const {
+        return "ScaledImage";
+    }
+
+    // the scale is clamped to (0, 1]
+    void setScale(float scale) {
+        scale = std::clamp(scale, 0.01f, 1.0f);
+        VkExtent2D previousExtent = getExtent();
+        this->scale = scale;
+        VkExtent2D extent = getExtent();
+        if (extent.width != previousExtent.width || extent.height != previousExtent.height) {
+            setChanged();
+        }
+    }
+
+    float getScale() const {
+        return scale;
+    }
+
+    // the extent of the input image
+    VkExtent2D getFullExtent() const {
+        auto input = inputs.find(0);
+        if (input == inputs.end()) {
+            throw std::runtime_error("no input!");
+        }
+        return std::dynamic_pointer_cast<ImageViewSrc>(input->second)->getExtent();
+    }
+
+    VkExtent2D getExtent() const override {
+        VkExtent2D fullExtent = getFullExtent();
+        return {
+            std::max(1u, (uint32_t)(fullExtent.width * scale)),
+            std::max(1u, (uint32_t)(fullExtent.height * scale))};
+    }
+
+    VkImageView& getImageView(uint32_t pathId) override {
+        if (pathId >= imageViews.size()) {
+            throw std::runtime_error("pathId out of range!");
+        }
+        return imageViews[pathId];
+    }
+
+    VkImage& getImage(uint32_t pathId) override {
+        if (pathId >= images.size()) {
+            throw std::runtime_error("pathId out of range!");
+        }
+        return images[pathId];
+    }
+
+    virtual void _setup(VulkanContext& vulkanContext, uint32_t numberPaths) {
+        this->vulkanContext = &vulkanContext;
+
+        images.resize(numberPaths);
+        imageViews.resize(numberPaths);
+        imageMemories.resize(numberPaths);
+
+        for (uint32_t i = 0; i < numberPaths; i++) {
+            createImage(i);
+        }
+        initialized = true;
+    }
+
+    // the input image was replaced, e.g. because the swapchain was recreated with another size
+    virtual void _inputsChanged(uint32_t pathId) {
+        destroyImage(pathId);
+        createImage(pathId);
+    }
+
+    // the images are replaced together with the ones of the input
+    uint64_t getResourceCount() const override {
+        auto input = inputs.find(0);
+        if (input == inputs.end()) {
+            return resourceCount;
+        }
+        return resourceCount + input->second->getResourceCount();
+    }
+
+    virtual void _record(VkCommandBuffer commandBuffer, uint32_t pathId) {
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = images[pathId];
+        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.baseMipLevel = 0;
+        barrier.subresourceRange.levelCount = 1;
+        barrier.subresourceRange.baseArrayLayer = 0;
+        barrier.subresourceRange.layerCount = 1;
+        barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0,
+            0, nullptr,
+            0, nullptr,
+            1, &barrier);
+
+        // the elements rendering to the image accumulate into it
+        VkClearColorValue clearColor = {{0.0f, 0.0f, 0.0f, 0.0f}};
+        vkCmdClearColorImage(commandBuffer, images[pathId], VK_IMAGE_LAYOUT_GENERAL, &clearColor, 1, &barrier.subresourceRange);
+
+        barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0,
+            0, nullptr,
+            0, nullptr,
+            1, &barrier);
+    }
+
+    // the image is cleared every time, the elements rendering to it
+    // have to be submitted whenever one of them is
+    virtual bool isRequiredByOutputs() const override {
+        return true;
+    }
+
+    // the image is only read by the elements, e.g. an upscale, never presented
+    virtual VkImageLayout getLayout() const override {
+        return VK_IMAGE_LAYOUT_GENERAL;
+    }
+
+private:
+    VulkanContext* vulkanContext = nullptr;
+    VkFormat format;
+    float scale = 1.0f;
+
+    std::vector<VkImage> images;
+    std::vector<VkImageView> imageViews;
+    std::vector<VkDeviceMemory> imageMemories;
+
+    void createImage(uint32_t pathId) {
+        auto& device = vulkanContext->getDevice();
+
+        VkExtent2D fullExtent = getFullExtent();
+        if (fullExtent.width == 0 || fullExtent.height == 0) {
+            throw std::runtime_error("input image has no extent!");
+        }
+
+        VkImageCreateInfo imageInfo{};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.extent = {fullExtent.width, fullExtent.height, 1};
+        imageInfo.mipLevels = 1;
+        imageInfo.arrayLayers = 1;
+        imageInfo.format = format;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        imageInfo.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+        if (vkCreateImage(device, &imageInfo, nullptr, &images[pathId]) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create image!");
+        }
+
+        VkMemoryRequirements memRequirements;
+        vkGetImageMemoryRequirements(device, images[pathId], &memRequirements);
+
+        VkMemoryAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocInfo.allocationSize = memRequirements.size;
+        allocInfo.memoryTypeIndex = vulkanContext->findMemoryType(memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+        if (vkAllocateMemory(device, &allocInfo, nullptr, &imageMemories[pathId]) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate image memory!");
+        }
+        vkBindImageMemory(device, images[pathId], imageMemories[pathId], 0);
+
+        VkImageViewCreateInfo viewInfo{};
+        viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        viewInfo.image = images[pathId];
+        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        viewInfo.format = format;
+        viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        viewInfo.subresourceRange.baseMipLevel = 0;
+        viewInfo.subresourceRange.levelCount = 1;
+        viewInfo.subresourceRange.baseArrayLayer = 0;
+        viewInfo.subresourceRange.layerCount = 1;
+
+        if (vkCreateImageView(device, &viewInfo, nullptr, &imageViews[pathId]) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create image view!");
+        }
+    }
+
+    void destroyImage(uint32_t pathId) {
+        auto& device = vulkanContext->getDevice();
+        vkDestroyImageView(device, imageViews[pathId], nullptr);
+        vkDestroyImage(device, images[pathId], nullptr);
+        vkFreeMemory(device, imageMemories[pathId], nullptr);
+    }
+};
+
+} // namespace klartraum
+
+#endif // KLARTRAUM_COMPUTEGRAPH_SCALEDIMAGE_HPP
@@ -1,6 +1,7 @@
 #ifndef KLARTRAUM_UNIFORMBUFFEROBJECT_HPP
 #define KLARTRAUM_UNIFORMBUFFEROBJECT_HPP
 
+#include <cstring>
 #include <vector>
 
 #include <vulkan/vulkan.h>
@@ -28,7 +29,6 @@ public:
         
         createDescriptorSetLayout();
         createUniformBuffers();
-        createDescriptorPool();
         createDescriptorSets();
         initialized = true;
     }
@@ -45,7 +45,7 @@ public:
                 vkFreeMemory(device, uniformBuffersMemory[i], nullptr);
             }
         
-            vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+            vulkanContext->getDescriptorAllocator().free(descriptorSets);
             vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
         }
     }
@@ -66,6 +66,11 @@ public:
 
     void update(uint32_t pathId)
     {
+        if (!hasLastUbo || memcmp(&lastUbo, &ubo, sizeof(ubo)) != 0) {
+            lastUbo = ubo;
+            hasLastUbo = true;
+            setChanged();
+        }
         memcpy(uniformBuffersMapped[pathId], &ubo, sizeof(ubo));
     }
 
@@ -84,6 +89,10 @@ public:
 private:
     VulkanContext* vulkanContext = nullptr;
 
+    // the value of the last change, for the change tracking of the compute graph
+    UniformBufferObjectType lastUbo;
+    bool hasLastUbo = false;
+
     void createDescriptorSetLayout()
     {
         auto device = vulkanContext->getDevice();
@@ -123,45 +132,13 @@ private:
         }
     }
 
-    void createDescriptorPool()
-    {
-        auto device = vulkanContext->getDevice();
-        auto config = vulkanContext->getConfig();
-    
-        VkDescriptorPoolSize poolSize{};
-        poolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-        poolSize.descriptorCount = static_cast<uint32_t>(numberOfPaths);    
-    
-        VkDescriptorPoolCreateInfo poolInfo{};
-        poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-        poolInfo.poolSizeCount = 1;
-        poolInfo.pPoolSizes = &poolSize;
-    
-        poolInfo.maxSets = static_cast<uint32_t>(numberOfPaths);
-    
-        if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS) {
-            throw std::runtime_error("failed to create descriptor pool!");
-        }
-    
-    }
-
     void createDescriptorSets()
 
     {
         auto device = vulkanContext->getDevice();
-        auto config = vulkanContext->getConfig();
     
-        std::vector<VkDescriptorSetLayout> layouts(numberOfPaths, descriptorSetLayout);
-        VkDescriptorSetAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-        allocInfo.descriptorPool = descriptorPool;
-        allocInfo.descriptorSetCount = static_cast<uint32_t>(numberOfPaths);
-        allocInfo.pSetLayouts = layouts.data();
-    
-        descriptorSets.resize(numberOfPaths);
-        if (vkAllocateDescriptorSets(device, &allocInfo, descriptorSets.data()) != VK_SUCCESS) {
-            throw std::runtime_error("failed to allocate descriptor sets!");
-        }
+        descriptorSets = vulkanContext->getDescriptorAllocator().allocate(
+            descriptorSetLayout, {{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1}}, numberOfPaths);
     
         for (size_t i = 0; i < numberOfPaths; i++) {
             VkDescriptorBufferInfo bufferInfo{};
@@ -187,7 +164,6 @@ private:
     }
 
     VkDescriptorSetLayout descriptorSetLayout;
-    VkDescriptorPool descriptorPool;
     std::vector<VkDescriptorSet> descriptorSets;
 
     std::vector<VkBuffer> uniformBuffers;
@@ -0,0 +1,71 @@
+#ifndef KLARTRAUM_DESCRIPTOR_ALLOCATOR_HPP
+#define KLARTRAUM_DESCRIPTOR_ALLOCATOR_HPP
+
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+namespace klartraum {
+
+/**
+ * @brief Allocates the descriptor sets of the elements, owned by the VulkanContext.
+ *
+ * All elements share the pools of the allocator instead of creating a pool each.
+ * If no pool has room for a request, a new pool is created, twice as large as the
+ * previous one and at least large enough for the request, so graphs with any number
+ * of paths and elements can be set up.
+ */
+class DescriptorAllocator {
+public:
+    DescriptorAllocator() {};
+    DescriptorAllocator(const DescriptorAllocator&) = delete;
+    DescriptorAllocator& operator=(const DescriptorAllocator&) = delete;
+
+    void initialize(VkDevice device);
+
+    // destroys the pools, the sets allocated from them are freed with them
+    void destroy();
+
+    // allocates count sets of the layout (usually one per path),
+    // sizes are the descriptors of a single set, e.g. one entry per binding
+    std::vector<VkDescriptorSet> allocate(VkDescriptorSetLayout layout, const std::vector<VkDescriptorPoolSize>& sizes, uint32_t count);
+
+    // gives sets of allocate back to their pools, sets of destroyed pools are ignored
+    void free(const std::vector<VkDescriptorSet>& sets);
+
+    size_t getNumberPools() const {
+        return pools.size();
+    }
+
+private:
+    struct Pool {
+        VkDescriptorPool pool = VK_NULL_HANDLE;
+        uint32_t freeSets = 0;
+        std::map<VkDescriptorType, uint32_t> freeDescriptors;
+    };
+
+    struct Allocation {
+        size_t pool;
+        std::vector<VkDescriptorPoolSize> sizes;
+    };
+
+    // true if the pool has room for count sets of sizes according to its counters
+    bool fits(const Pool& pool, const std::vector<VkDescriptorPoolSize>& sizes, uint32_t count) const;
+    bool tryAllocate(size_t poolIndex, VkDescriptorSetLayout layout, const std::vector<VkDescriptorPoolSize>& sizes, uint32_t count, std::vector<VkDescriptorSet>& sets);
+    size_t createPool(const std::vector<VkDescriptorPoolSize>& sizes, uint32_t count);
+
+    VkDevice device = VK_NULL_HANDLE;
+
+    std::mutex mutex;
+    std::vector<Pool> pools;
+    std::map<VkDescriptorSet, Allocation> allocations;
+
+    // the number of sets of the next pool, doubled with every pool
+    uint32_t nextPoolSets = 64;
+};
+
+} // namespace klartraum
+
+#endif // KLARTRAUM_DESCRIPTOR_ALLOCATOR_HPP
@@ -0,0 +1,23 @@
+#ifndef KLARTRAUM_EMBEDDED_SHADERS_HPP
+#define KLARTRAUM_EMBEDDED_SHADERS_HPP
+
+#include <stddef.h>
+
+#include <string>
+
+namespace klartraum {
+
+// SPIR-V compiled into the library by the Shaders target (see cmake/EmbedShaders.cmake)
+struct EmbeddedShader {
+    const char* name;
+    const unsigned char* code;
+    size_t size;
+};
+
+// the embedded shader of the given path relative to the source directory,
+// e.g. "shaders/image_upscale.comp.spv", nullptr if it is not part of the library
+const EmbeddedShader* findEmbeddedShader(const std::string& name);
+
+} // namespace klartraum
+
+#endif // KLARTRAUM_EMBEDDED_SHADERS_HPP
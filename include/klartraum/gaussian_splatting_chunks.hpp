@@ -0,0 +1,30 @@
+#ifndef KLARTRAUM_GAUSSIAN_SPLATTING_CHUNKS_HPP
+#define KLARTRAUM_GAUSSIAN_SPLATTING_CHUNKS_HPP
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "klartraum/vulkan_gaussian_splatting_types.hpp"
+
+namespace klartraum {
+
+// number of gaussians per chunk, has to match GSPLAT_CHUNK_SIZE in gsplat_types.glsl
+const uint32_t GaussianChunkSize = 256;
+
+// interleaves the lower 21 bits of x, y and z into a 63 bit morton code
+uint64_t encodeMortonCode(uint32_t x, uint32_t y, uint32_t z);
+
+/**
+ * @brief Reorders the gaussians along a morton curve and splits them into chunks.
+ *
+ * Consecutive gaussians on the morton curve are close to each other in space,
+ * so each chunk of chunkSize gaussians covers a small region of the scene
+ * and can be culled as a whole against the view frustum.
+ * The gaussians are sorted in place, each chunk refers to a consecutive range of them.
+ */
+std::vector<GaussianChunk> partitionIntoChunks(std::vector<Gaussian3D>& gaussians, uint32_t chunkSize = GaussianChunkSize);
+
+} // namespace klartraum
+
+#endif // KLARTRAUM_GAUSSIAN_SPLATTING_CHUNKS_HPP
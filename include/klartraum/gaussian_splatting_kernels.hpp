@@ -0,0 +1,53 @@
+#ifndef KLARTRAUM_GAUSSIAN_SPLATTING_KERNELS_HPP
+#define KLARTRAUM_GAUSSIAN_SPLATTING_KERNELS_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace klartraum {
+
+enum class KernelIsa {
+    Scalar,
+    SSE2,
+    AVX2,
+    NEON
+};
+
+const char* getKernelIsaName(KernelIsa isa);
+
+/**
+ * @brief Batch kernels used while ingesting gaussian splatting scenes.
+ *
+ * All kernels work on structure of arrays columns. Input and output
+ * of sigmoid and exp may alias. There is one table per instruction set,
+ * getGaussianKernels() picks the best one the cpu supports at runtime.
+ */
+struct GaussianKernels {
+    KernelIsa isa;
+
+    // out[i] = 1 / (1 + exp(-in[i]))
+    void (*sigmoid)(const float* in, float* out, size_t count);
+
+    // out[i] = exp(in[i])
+    void (*exp)(const float* in, float* out, size_t count);
+
+    // normalizes count quaternions stored as four columns, in place
+    void (*normalizeQuaternions)(float* x, float* y, float* z, float* w, size_t count);
+
+    // out[i] = scale * (float at in + i * inStride bytes)
+    // strided gather that deinterleaves and rescales sh coefficients and
+    // pulls float columns out of packed records, in does not have to be aligned
+    void (*rescale)(const void* in, size_t inStride, float* out, size_t count, float scale);
+};
+
+bool isKernelIsaSupported(KernelIsa isa);
+
+// kernels for the best instruction set available on this cpu
+const GaussianKernels& getGaussianKernels();
+
+// kernels for a specific instruction set, throws if it is not supported
+const GaussianKernels& getGaussianKernels(KernelIsa isa);
+
+} // namespace klartraum
+
+#endif // KLARTRAUM_GAUSSIAN_SPLATTING_KERNELS_HPP
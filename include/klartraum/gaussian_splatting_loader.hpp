@@ -0,0 +1,117 @@
+#ifndef KLARTRAUM_GAUSSIAN_SPLATTING_LOADER_HPP
+#define KLARTRAUM_GAUSSIAN_SPLATTING_LOADER_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "klartraum/vulkan_gaussian_splatting_types.hpp"
+
+namespace klartraum {
+
+/**
+ * @brief Options applied while loading a gaussian splatting scene.
+ *
+ * Cropping is disabled by default, so the whole scene is loaded.
+ */
+struct GaussianLoadOptions {
+    // only keep gaussians whose center lies inside [cropMin, cropMax]
+    bool crop = false;
+    std::array<float, 3> cropMin = {-std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max()};
+    std::array<float, 3> cropMax = {std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max()};
+
+    // drop gaussians whose (activated) opacity is below this value
+    float minAlpha = 0.0f;
+
+    bool accepts(const std::array<float, 3>& position, float alpha) const {
+        if (alpha < minAlpha) {
+            return false;
+        }
+        if (!crop) {
+            return true;
+        }
+        for (int i = 0; i < 3; i++) {
+            if (position[i] < cropMin[i] || position[i] > cropMax[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+/**
+ * @brief Read-only memory mapping of a whole file.
+ *
+ * The mapping is released when the object is destroyed.
+ */
+class MappedFile {
+public:
+    MappedFile(const std::string& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const uint8_t* data() const {
+        return bytes;
+    }
+
+    size_t size() const {
+        return length;
+    }
+
+private:
+    const uint8_t* bytes = nullptr;
+    size_t length = 0;
+
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#endif
+};
+
+enum class PlyType {
+    Int8,
+    UInt8,
+    Int16,
+    UInt16,
+    Int32,
+    UInt32,
+    Float32,
+    Float64
+};
+
+struct PlyProperty {
+    std::string name;
+    PlyType type;
+    size_t offset; // byte offset inside a single vertex record
+};
+
+struct PlyHeader {
+    size_t vertexCount = 0;
+    size_t vertexStride = 0;  // size of one vertex record in bytes
+    size_t vertexOffset = 0;  // byte offset of the first vertex record in the file
+    std::vector<PlyProperty> properties;
+
+    const PlyProperty* find(const std::string& name) const;
+};
+
+// parses the ascii header of a binary little endian PLY file
+// only the vertex element is described, everything else is skipped
+PlyHeader parsePlyHeader(const uint8_t* data, size_t size);
+
+// loads a 3D gaussian splatting PLY file (as written by the reference implementation)
+// the activation functions (sigmoid for opacity, exp for scales, normalization
+// for the rotations) are applied while loading
+std::vector<Gaussian3D> loadGaussiansFromPly(const std::string& path, const GaussianLoadOptions& options = GaussianLoadOptions());
+
+// loads a gaussian splatting scene stored in niantics spz format,
+// with the same activation functions applied as for PLY files
+std::vector<Gaussian3D> loadGaussiansFromSpz(const std::string& path, const GaussianLoadOptions& options = GaussianLoadOptions());
+
+} // namespace klartraum
+
+#endif // KLARTRAUM_GAUSSIAN_SPLATTING_LOADER_HPP
@@ -0,0 +1,65 @@
+#ifndef KLARTRAUM_GAUSSIAN_SPLATTING_LOD_HPP
+#define KLARTRAUM_GAUSSIAN_SPLATTING_LOD_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "klartraum/gaussian_splatting_chunks.hpp"
+#include "klartraum/vulkan_gaussian_splatting_types.hpp"
+
+namespace klartraum {
+
+const uint32_t NoParentChunk = std::numeric_limits<uint32_t>::max();
+
+struct GaussianLodOptions {
+    // if disabled, only the leaves (the loaded gaussians) are rendered,
+    // enabling it builds the hierarchy on every load and changes the rendered result
+    bool enabled = false;
+
+    // maximum number of levels of the hierarchy, including the leaves
+    uint32_t maxLevels = 8;
+
+    // a chunk is rendered once its error projected to the screen
+    // is below this threshold (in pixels)
+    float errorThreshold = 1.0f;
+
+    // the threshold is raised at runtime while more gaussians than this are selected
+    uint32_t splatBudget = std::numeric_limits<uint32_t>::max();
+};
+
+/**
+ * @brief Multi-level hierarchy of gaussians, stored as chunks.
+ *
+ * Level 0 contains the loaded gaussians (the leaves), partitioned by partitionIntoChunks.
+ * Each chunk of the next level merges the gaussians of four consecutive chunks
+ * (in morton order) of the level below, always four gaussians into one.
+ * Gaussians and chunks of all levels are stored in one array each, leaves first.
+ *
+ * At runtime, a cut through the hierarchy is selected independently per chunk:
+ * a chunk is rendered if its projected error is small enough, but the projected error
+ * of its parent is not. Errors grow monotonically and each parent sphere contains the spheres
+ * of its children, so exactly one chunk on each path from a root to a leaf is selected.
+ */
+struct GaussianHierarchy {
+    std::vector<Gaussian3D> gaussians;
+    std::vector<GaussianChunk> chunks;
+    std::vector<uint32_t> parents; // index of the parent chunk, NoParentChunk for the roots
+    uint32_t numberLeafGaussians = 0;
+    uint32_t numberLevels = 0;
+};
+
+GaussianHierarchy buildGaussianHierarchy(std::vector<Gaussian3D> gaussians, uint32_t maxLevels, uint32_t chunkSize = GaussianChunkSize);
+
+// 3x3 covariance matrix (row major) of a gaussian given by its rotation and scale
+std::array<float, 9> computeCovariance(const Gaussian3D& gaussian);
+
+// merges count gaussians into a single one, matching the first two moments
+// of the opacity and area weighted mixture, color and sh are averaged likewise
+Gaussian3D mergeGaussians(const Gaussian3D* gaussians, size_t count);
+
+} // namespace klartraum
+
+#endif // KLARTRAUM_GAUSSIAN_SPLATTING_LOD_HPP
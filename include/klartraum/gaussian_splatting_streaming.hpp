@@ -0,0 +1,209 @@
+#ifndef KLARTRAUM_GAUSSIAN_SPLATTING_STREAMING_HPP
+#define KLARTRAUM_GAUSSIAN_SPLATTING_STREAMING_HPP
+
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "klartraum/gaussian_splatting_loader.hpp"
+#include "klartraum/gaussian_splatting_lod.hpp"
+#include "klartraum/vulkan_gaussian_splatting_types.hpp"
+
+namespace klartraum {
+
+struct GaussianStreamingOptions {
+    // if disabled, the whole hierarchy is kept on the gpu
+    bool enabled = false;
+
+    // the hierarchy is written to this file once and streamed from it,
+    // defaults to the path of the scene with the extension .kts appended
+    std::string pageFile;
+
+    // number of chunks the gpu page pool can hold
+    uint32_t poolPages = 4096;
+
+    // limits on how many groups of sibling chunks are read in the background
+    // and how many of them are uploaded to the gpu per frame
+    uint32_t maxLoadsInFlight = 32;
+    uint32_t maxUploadsPerFrame = 16;
+};
+
+/**
+ * @brief Identifies the source and the options a page file was built from.
+ *
+ * Changes of the source file (by size or modification time) or of the
+ * options used for loading and building the hierarchy lead to a different key.
+ */
+uint64_t computeGaussianSourceKey(const std::string& path, const GaussianLoadOptions& loadOptions, uint32_t maxLevels);
+
+struct GaussianPageFileHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t sourceKey;
+    uint32_t chunkSize;
+    uint32_t numberLevels;
+    uint32_t numberLeafGaussians;
+    uint32_t numberChunks;
+    uint64_t numberGaussians;
+    uint64_t gaussiansOffset; // byte offset of the gaussians in the file, page aligned
+};
+
+// writes the chunks, their parents and the gaussians of all levels
+void writeGaussianPageFile(const std::string& path, const GaussianHierarchy& hierarchy, uint64_t sourceKey);
+
+// true if the file exists and was written for sourceKey
+bool isGaussianPageFileValid(const std::string& path, uint64_t sourceKey);
+
+/**
+ * @brief A page file mapped into memory.
+ *
+ * The chunk table is copied, the gaussians are only accessed through the mapping
+ * so that they are paged in by the operating system when a chunk is streamed.
+ */
+class GaussianPageFile {
+public:
+    GaussianPageFile(const std::string& path);
+
+    const GaussianPageFileHeader& getHeader() const {
+        return header;
+    }
+
+    const std::vector<GaussianChunk>& getChunks() const {
+        return chunks;
+    }
+
+    const std::vector<uint32_t>& getParents() const {
+        return parents;
+    }
+
+    const Gaussian3D* getGaussians() const {
+        return gaussians;
+    }
+
+private:
+    MappedFile file;
+    GaussianPageFileHeader header;
+    std::vector<GaussianChunk> chunks;
+    std::vector<uint32_t> parents;
+    const Gaussian3D* gaussians = nullptr;
+};
+
+/**
+ * @brief Keeps the chunks of a gaussian hierarchy resident in a fixed size gpu page pool.
+ *
+ * Every chunk occupies one page (of GaussianChunkSize gaussians) of the pool.
+ * The children of a chunk are loaded and evicted together, and only while their
+ * parent is resident, so the resident chunks always form the top of the hierarchy.
+ * The roots are loaded at construction and never evicted.
+ *
+ * The page table maps each chunk to its page, or NotResident. Chunks whose children
+ * are resident carry the ChildrenResidentBit, the culling pass only refines those.
+ *
+ * Every frame, update() consumes the feedback the culling pass wrote for a path:
+ * FeedbackUsed for rendered chunks (for the LRU eviction) and FeedbackRefine for chunks
+ * that need more detail than is resident. The children of the latter are read from the
+ * gaussians (usually a memory mapped page file) on a background thread, closest to the
+ * camera first. Evicted pages are reused only after all frames in flight are done with them.
+ */
+class GaussianResidencyManager {
+public:
+    static constexpr uint32_t NotResident = 0xffffffff;
+    static constexpr uint32_t ChildrenResidentBit = 0x80000000;
+
+    static constexpr uint32_t FeedbackUsed = 1;
+    static constexpr uint32_t FeedbackRefine = 2;
+
+    // copies count gaussians to the page of the pool, called from update()
+    typedef std::function<void(uint32_t page, const Gaussian3D* gaussians, uint32_t count)> UploadFunction;
+
+    GaussianResidencyManager(
+        const Gaussian3D* gaussians,
+        const std::vector<GaussianChunk>& chunks,
+        const std::vector<uint32_t>& parents,
+        uint32_t framesInFlight,
+        const GaussianStreamingOptions& options,
+        UploadFunction upload);
+    ~GaussianResidencyManager();
+
+    GaussianResidencyManager(const GaussianResidencyManager&) = delete;
+    GaussianResidencyManager& operator=(const GaussianResidencyManager&) = delete;
+
+    // frames after which evicted pages can be reused, e.g. after the graph was compiled with more paths
+    void setFramesInFlight(uint32_t framesInFlight) {
+        this->framesInFlight = framesInFlight;
+    }
+
+    // feedback holds one value per chunk (or is nullptr), cameraPosition is in model space
+    void update(const uint32_t* feedback, const std::array<float, 3>& cameraPosition);
+
+    const std::vector<uint32_t>& getPageTable() const {
+        return pageTable;
+    }
+
+    // incremented whenever the page table changes
+    uint64_t getPageTableVersion() const {
+        return pageTableVersion;
+    }
+
+    bool isResident(uint32_t chunk) const {
+        return pageTable[chunk] != NotResident;
+    }
+
+    uint32_t getNumberResidentChunks() const;
+
+    // blocks until all requested chunks have been read, used by tests
+    void waitForLoads();
+
+private:
+    struct LoadedGroup {
+        uint32_t parent;
+        std::vector<Gaussian3D> gaussians;
+    };
+
+    const Gaussian3D* gaussians;
+    const std::vector<GaussianChunk>& chunks;
+    std::vector<std::vector<uint32_t>> children;
+    uint32_t framesInFlight;
+    GaussianStreamingOptions options;
+    UploadFunction upload;
+
+    std::vector<uint32_t> pageTable;
+    uint64_t pageTableVersion = 0;
+
+    std::vector<uint64_t> lastUsed;   // per chunk, frame in which it was rendered last
+    std::vector<bool> loading;        // per chunk, true while its children are being loaded
+    std::vector<uint32_t> residentGroups; // parents whose children are resident
+    std::vector<uint32_t> freePages;
+    std::deque<std::pair<uint64_t, uint32_t>> retiredPages; // frame of eviction, page
+    std::deque<LoadedGroup> pendingUploads;
+    uint64_t frame = 0;
+    uint32_t loadsInFlight = 0;
+
+    // shared with the background thread
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::condition_variable loadedCondition;
+    std::deque<uint32_t> requests;
+    std::deque<LoadedGroup> loaded;
+    bool stop = false;
+    std::thread worker;
+
+    void work();
+    LoadedGroup readGroup(uint32_t parent) const;
+
+    void requestRefinements(const uint32_t* feedback, const std::array<float, 3>& cameraPosition);
+    void uploadGroups();
+    bool uploadGroup(LoadedGroup& group);
+    bool evictLeastRecentlyUsed();
+};
+
+} // namespace klartraum
+
+#endif // KLARTRAUM_GAUSSIAN_SPLATTING_STREAMING_HPP
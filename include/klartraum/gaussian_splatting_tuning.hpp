@@ -0,0 +1,98 @@
+#ifndef KLARTRAUM_GAUSSIAN_SPLATTING_TUNING_HPP
+#define KLARTRAUM_GAUSSIAN_SPLATTING_TUNING_HPP
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "klartraum/computegraph/imageviewsrc.hpp"
+#include "klartraum/vulkan_context.hpp"
+#include "klartraum/vulkan_gaussian_splatting.hpp"
+
+namespace klartraum {
+
+/*
+ * The tuning file is a text file with one line per device:
+ * the device uuid in hex followed by the members of GaussianKernelConstants,
+ * lines starting with # are comments.
+ */
+
+// true if the file has an entry for the device, constants is only changed then
+bool loadTunedKernelConstants(const std::string& path, const DeviceUUID& deviceUUID, GaussianKernelConstants& constants);
+
+// adds or replaces the entry of the device, the entries of other devices are kept
+void saveTunedKernelConstants(const std::string& path, const DeviceUUID& deviceUUID, const GaussianKernelConstants& constants);
+
+struct GaussianKernelTuningOptions {
+    // the grid of candidates, all combinations the device supports are measured
+    std::vector<uint32_t> projectionGroupSizes = {64, 128, 256};
+    std::vector<uint32_t> sortGroupSizes = {64, 128, 256};
+    std::vector<uint32_t> splatTileSizes = {8, 16};
+
+    // frames rendered before measuring, e.g. to fill the page pool of streamed scenes
+    uint32_t warmupFrames = 4;
+    // the gpu time of a candidate is the median of these frames
+    uint32_t measuredFrames = 16;
+};
+
+struct GaussianKernelTuningResult {
+    GaussianKernelConstants constants;
+    float gpuTime; // milliseconds per frame
+};
+
+/**
+ * @brief Finds the fastest GaussianKernelConstants of the device for a scene.
+ *
+ * For every candidate of the grid the scene is loaded into a VulkanGaussianSplatting
+ * with these constants and rendered on its own graph. The gpu time of a frame is measured
+ * with timestamp queries around the whole graph, since the constants are shared by several
+ * kernels and e.g. the sort group size also changes the work of the binning.
+ *
+ * The best constants are saved to BackendConfig::KERNEL_TUNING_PATH, from where every
+ * VulkanGaussianSplatting created on the same device loads them.
+ */
+class GaussianKernelTuner {
+public:
+    GaussianKernelTuner(VulkanContext& vulkanContext, const GaussianKernelTuningOptions& options = GaussianKernelTuningOptions());
+    ~GaussianKernelTuner();
+
+    // the candidates of the grid that fit the limits of the device
+    std::vector<GaussianKernelConstants> getCandidates() const;
+
+    // renders the scene at path to imageViewSrc (path 0) from the camera, options are
+    // used for everything but the kernel constants, the graph must not be in use
+    GaussianKernelConstants tune(
+        std::shared_ptr<ImageViewSrc> imageViewSrc,
+        std::shared_ptr<CameraUboType> cameraUBO,
+        const std::string& path,
+        const GaussianSplattingOptions& options = GaussianSplattingOptions());
+
+    // the measurements of the last tune, in the order of getCandidates
+    const std::vector<GaussianKernelTuningResult>& getResults() const {
+        return results;
+    }
+
+private:
+    float measure(
+        std::shared_ptr<ImageViewSrc> imageViewSrc,
+        std::shared_ptr<CameraUboType> cameraUBO,
+        const std::string& path,
+        GaussianSplattingOptions options);
+
+    VulkanContext& vulkanContext;
+    GaussianKernelTuningOptions options;
+
+    float timestampPeriod = 0.0f; // nanoseconds per timestamp tick
+    VkQueryPool queryPool = VK_NULL_HANDLE;
+    VkCommandPool commandPool = VK_NULL_HANDLE;
+    VkCommandBuffer beginCommandBuffer = VK_NULL_HANDLE;
+    VkCommandBuffer endCommandBuffer = VK_NULL_HANDLE;
+    VkFence fence = VK_NULL_HANDLE;
+
+    std::vector<GaussianKernelTuningResult> results;
+};
+
+} // namespace klartraum
+
+#endif // KLARTRAUM_GAUSSIAN_SPLATTING_TUNING_HPP
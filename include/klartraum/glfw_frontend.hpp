@@ -14,7 +14,8 @@ class GlfwFrontend {
  * 
  */
 public:
-    GlfwFrontend();
+    // the config selects e.g. the present mode and the number of frames in flight
+    GlfwFrontend(const BackendConfig& config = BackendConfig());
     ~GlfwFrontend();
 
 
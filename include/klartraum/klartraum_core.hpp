@@ -15,11 +15,28 @@
 #include "klartraum/events.hpp"
 
 #include "klartraum/computegraph/computegraph.hpp"
+#include "klartraum/computegraph/frameimage.hpp"
 #include "klartraum/computegraph/renderpass.hpp"
+#include "klartraum/computegraph/scaledimage.hpp"
 
 
 namespace klartraum {
 
+struct DynamicResolutionOptions {
+    // gpu time per frame the render scale is adapted to, in milliseconds
+    float targetFrameTime = 1000.0f / 60.0f;
+
+    float minScale = 0.25f;
+    float maxScale = 1.0f;
+
+    // the scale changes in steps, every change records the
+    // command buffers of the affected elements again
+    float scaleStep = 0.125f;
+
+    // number of frames the scale is kept at least before it is increased again
+    uint32_t increaseDelayFrames = 60;
+};
+
 class KlartraumEngine {
 public:
     KlartraumEngine();
@@ -40,9 +57,15 @@ public:
 
     RenderPassPtr createRenderPass();
 
-    void clearComputeGraphs() {
-        computeGraphs.clear();
-    }
+    // has to be called before the VulkanContext is shut down
+    void clearComputeGraphs();
+
+    /*
+     * Adapts the scale of the image to the measured gpu frame time,
+     * elements rendering to it render at the scaled resolution
+     * and an ImageUpscale brings the result to the screen.
+     */
+    void setDynamicResolution(std::shared_ptr<ScaledImage> image, const DynamicResolutionOptions& options = DynamicResolutionOptions());
 
 private:
     VulkanContext vulkanContext;
@@ -54,6 +77,25 @@ private:
 
     std::vector<ComputeGraph> computeGraphs;
 
+    std::shared_ptr<ScaledImage> dynamicResolutionImage;
+    DynamicResolutionOptions dynamicResolutionOptions;
+    float averageGpuFrameTime = 0.0f;
+    uint32_t framesSinceScaleChange = 0;
+
+    void updateDynamicResolution();
+
+    // the images the render pass renders to, one per frame in flight, see createRenderPass
+    std::shared_ptr<FrameImage> frameImage;
+    uint64_t swapChainVersion = 0;
+
+    // copies of the frame images to the swapchain images, per frame in flight and swapchain image
+    std::vector<VkCommandBuffer> frameCopyCommandBuffers;
+    std::vector<VkSemaphore> frameCopySemaphores;
+
+    void updateSwapChainImages();
+    void recordFrameCopies();
+    VkSemaphore submitFrameCopy(uint32_t pathId, uint32_t imageIndex, VkSemaphore renderFinishedSemaphore, VkSemaphore imageAvailableSemaphore);
+
 };
 
 } // namespace klartraum
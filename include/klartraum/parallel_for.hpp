@@ -0,0 +1,181 @@
+#ifndef KLARTRAUM_PARALLEL_FOR_HPP
+#define KLARTRAUM_PARALLEL_FOR_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace klartraum {
+
+namespace detail {
+// set while a thread runs the tasks of a ThreadPool
+inline thread_local bool insideParallelFor = false;
+}
+
+/*
+ * A fixed set of worker threads, created once (e.g. with the VulkanContext) and
+ * reused for every recording, so that no threads are started per frame.
+ * The calling thread is worker 0, the pool runs one job at a time.
+ *
+ * A job started from the task of another one runs on the calling thread,
+ * since all workers are already busy (e.g. a render pass recorded by a graph worker).
+ */
+class ThreadPool {
+public:
+    // one worker per core by default
+    explicit ThreadPool(size_t numberThreads = std::max(1u, std::thread::hardware_concurrency())) {
+        numberThreads = std::max<size_t>(1, numberThreads);
+        for (size_t worker = 1; worker < numberThreads; worker++) {
+            threads.emplace_back([this, worker]() { workerLoop(worker); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        started.notify_all();
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // the number of workers including the calling thread
+    size_t getNumberThreads() const {
+        return threads.size() + 1;
+    }
+
+    // the number of workers a job started now uses for count tasks,
+    // at most one per task and only the calling thread inside another job
+    size_t getNumberThreads(size_t count) const {
+        if (detail::insideParallelFor) {
+            return std::min<size_t>(count, 1);
+        }
+        return std::min<size_t>(count, getNumberThreads());
+    }
+
+    // calls task(worker) once for every worker < numberWorkers on the worker
+    // with that index, so tasks can own resources per worker (e.g. command pools),
+    // the first exception thrown by a task is rethrown after all tasks finished
+    void forEachWorker(size_t numberWorkers, const std::function<void(size_t)>& task) {
+        numberWorkers = std::min(numberWorkers, getNumberThreads());
+        if (numberWorkers <= 1 || detail::insideParallelFor) {
+            // all tasks on the calling thread, one after the other
+            for (size_t worker = 0; worker < numberWorkers; worker++) {
+                task(worker);
+            }
+            return;
+        }
+
+        std::lock_guard<std::mutex> jobLock(jobMutex);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = &task;
+            jobWorkers = numberWorkers;
+            remaining = numberWorkers - 1;
+            generation++;
+        }
+        started.notify_all();
+
+        runTask(task, 0);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        finished.wait(lock, [this]() { return remaining == 0; });
+        job = nullptr;
+        lock.unlock();
+        rethrow();
+    }
+
+    // calls task(i) for all i < count, distributed over the workers,
+    // the first exception thrown by a task is rethrown after all tasks finished
+    template <typename F>
+    void parallelFor(size_t count, F task) {
+        std::atomic<size_t> next{0};
+        forEachWorker(getNumberThreads(count), [&](size_t) {
+            for (size_t i = next++; i < count; i = next++) {
+                task(i);
+            }
+        });
+    }
+
+private:
+    std::vector<std::thread> threads;
+
+    std::mutex jobMutex; // one job at a time
+    std::mutex mutex;
+    std::condition_variable started;
+    std::condition_variable finished;
+    const std::function<void(size_t)>* job = nullptr;
+    size_t jobWorkers = 0;
+    size_t remaining = 0;
+    uint64_t generation = 0;
+    bool stopping = false;
+
+    std::mutex errorMutex;
+    std::exception_ptr error;
+
+    void workerLoop(size_t worker) {
+        uint64_t seen = 0;
+        while (true) {
+            const std::function<void(size_t)>* task = nullptr;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                started.wait(lock, [&]() { return stopping || generation != seen; });
+                if (stopping) {
+                    return;
+                }
+                seen = generation;
+                if (worker >= jobWorkers) {
+                    continue;
+                }
+                task = job;
+            }
+
+            runTask(*task, worker);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--remaining == 0) {
+                finished.notify_one();
+            }
+        }
+    }
+
+    void runTask(const std::function<void(size_t)>& task, size_t worker) {
+        bool inside = detail::insideParallelFor;
+        detail::insideParallelFor = true;
+        try {
+            task(worker);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if (!error) {
+                error = std::current_exception();
+            }
+        }
+        detail::insideParallelFor = inside;
+    }
+
+    void rethrow() {
+        std::exception_ptr thrown;
+        {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            std::swap(thrown, error);
+        }
+        if (thrown) {
+            std::rethrow_exception(thrown);
+        }
+    }
+};
+
+} // namespace klartraum
+
+#endif // KLARTRAUM_PARALLEL_FOR_HPP
@@ -0,0 +1,118 @@
+#ifndef KLARTRAUM_PIPELINE_BUILDER_HPP
+#define KLARTRAUM_PIPELINE_BUILDER_HPP
+
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "klartraum/parallel_for.hpp"
+
+namespace klartraum {
+
+/**
+ * @brief Specialization constants of a pipeline, made from a struct of 32 bit members.
+ *
+ * The i-th member is given to constant_id i of the shader, e.g.
+ * layout(constant_id = 0) const uint groupSize = 128; for the first member.
+ * Members without a matching constant in the shader are ignored.
+ */
+class SpecializationConstants {
+public:
+    SpecializationConstants() {};
+
+    template <typename S>
+    SpecializationConstants(const S& constants) {
+        static_assert(std::is_trivially_copyable<S>::value, "specialization constants have to be trivially copyable!");
+        static_assert(sizeof(S) % sizeof(uint32_t) == 0, "specialization constants have to consist of 32 bit members!");
+
+        data.resize(sizeof(S));
+        memcpy(data.data(), &constants, sizeof(S));
+        for (uint32_t i = 0; i < sizeof(S) / sizeof(uint32_t); i++) {
+            entries.push_back({i, i * (uint32_t)sizeof(uint32_t), sizeof(uint32_t)});
+        }
+    }
+
+    bool empty() const {
+        return data.empty();
+    }
+
+    // info points into this object, it is only valid as long as it is alive
+    VkSpecializationInfo getInfo() const {
+        VkSpecializationInfo info{};
+        info.mapEntryCount = (uint32_t)entries.size();
+        info.pMapEntries = entries.data();
+        info.dataSize = data.size();
+        info.pData = data.data();
+        return info;
+    }
+
+private:
+    std::vector<VkSpecializationMapEntry> entries;
+    std::vector<char> data;
+};
+
+/**
+ * @brief Creates the compute pipelines of the elements, owned by the VulkanContext.
+ *
+ * Outside of a graph compile a pipeline is created as soon as it is added. While a graph is
+ * compiled (between defer and build), the elements only add the requests in their _setup,
+ * build then creates the shader modules and the pipelines of all requests on several threads.
+ * All pipelines share the pipeline cache of the context, which is synchronized by the driver.
+ *
+ * The SPIR-V of a shader is loaded once, elements using the same shader share it. The shaders
+ * of the library are embedded into it (see embedded_shaders.hpp), other paths are read from disk.
+ */
+class PipelineBuilder {
+public:
+    PipelineBuilder() {};
+    PipelineBuilder(const PipelineBuilder&) = delete;
+    PipelineBuilder& operator=(const PipelineBuilder&) = delete;
+
+    // the shader modules and pipelines are created on the workers of threadPool
+    void initialize(VkDevice device, VkPipelineCache pipelineCache, ThreadPool& threadPool);
+
+    // pipeline is written when the pipeline is created, it has to stay valid until then
+    void addComputePipeline(const std::string& shaderPath, VkPipelineLayout layout, VkPipeline* pipeline,
+        const SpecializationConstants& specializationConstants = SpecializationConstants());
+
+    // the pipelines added from now on are created by build, calls can be nested
+    void defer();
+
+    // creates the pipelines added since the outermost defer
+    void build();
+
+    // drops the pipelines added since the outermost defer, e.g. if a setup failed
+    void discard();
+
+    std::shared_ptr<const std::vector<char>> getShaderCode(const std::string& shaderPath);
+
+private:
+    struct Request {
+        std::string shaderPath;
+        VkPipelineLayout layout;
+        VkPipeline* pipeline;
+        SpecializationConstants specializationConstants;
+    };
+
+    void createPipelines(const std::vector<Request>& requests);
+
+    VkDevice device = VK_NULL_HANDLE;
+    VkPipelineCache pipelineCache = VK_NULL_HANDLE;
+    ThreadPool* threadPool = nullptr;
+
+    uint32_t deferDepth = 0;
+    std::vector<Request> pendingRequests;
+
+    std::mutex shaderCodesMutex;
+    std::map<std::string, std::shared_ptr<const std::vector<char>>> shaderCodes;
+};
+
+} // namespace klartraum
+
+#endif // KLARTRAUM_PIPELINE_BUILDER_HPP
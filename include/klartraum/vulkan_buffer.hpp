@@ -13,72 +13,65 @@ template <typename T>
 class VulkanBuffer {
 public:
     VulkanBuffer(VulkanContext& kernel, uint32_t size, VkBufferUsageFlags usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT) : vulkanContext(kernel), size(size) {
-        auto& device = kernel.getDevice();
-
-        VkBufferCreateInfo bufferInfo{};
-        bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-        bufferInfo.size = sizeof(T) * size;
-        bufferInfo.usage = usage;
-        bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-    
-        if (vkCreateBuffer(device, &bufferInfo, nullptr, &vertexBuffer) != VK_SUCCESS) {
-            throw std::runtime_error("failed to create compute buffer!");
+        // created by the context, so that storage buffers get an address if the device supports it
+        vulkanContext.createBuffer(sizeof(T) * size, usage,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            vertexBuffer, vertexBufferMemory);
+
+        // mapped once and kept mapped, so that frequent small copies (e.g. the pages
+        // uploaded by the streaming thread) do not map the memory every time,
+        // the memory is coherent, so the copies need no flush
+        if (vkMapMemory(vulkanContext.getDevice(), vertexBufferMemory, 0, sizeof(T) * size, 0, &mappedData) != VK_SUCCESS) {
+            throw std::runtime_error("failed to map buffer memory!");
         }
-
-        VkMemoryRequirements memRequirements;
-        vkGetBufferMemoryRequirements(device, vertexBuffer, &memRequirements);
-    
-        VkMemoryAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        allocInfo.allocationSize = memRequirements.size;
-        allocInfo.memoryTypeIndex = vulkanContext.findMemoryType(memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-    
-        if (vkAllocateMemory(device, &allocInfo, nullptr, &vertexBufferMemory) != VK_SUCCESS) {
-            throw std::runtime_error("failed to allocate vertex buffer memory!");
-        }
-        vkBindBufferMemory(device, vertexBuffer, vertexBufferMemory, 0);
     }
 
     VulkanBuffer(VulkanBuffer&& other) noexcept
         : size(other.size),
           vertexBuffer(other.vertexBuffer),
           vertexBufferMemory(other.vertexBufferMemory),
+          mappedData(other.mappedData),
           vulkanContext(other.vulkanContext) {
         other.vertexBuffer = VK_NULL_HANDLE;
         other.vertexBufferMemory = VK_NULL_HANDLE;
+        other.mappedData = nullptr;
     }
 
     ~VulkanBuffer() {
         auto& device = vulkanContext.getDevice();
+        if (mappedData != nullptr) {
+            vkUnmapMemory(device, vertexBufferMemory);
+        }
         vkDestroyBuffer(device, vertexBuffer, nullptr);
         vkFreeMemory(device, vertexBufferMemory, nullptr);
     }
 
     void memcopyFrom(const std::vector<T>& src) {
-        auto& device = vulkanContext.getDevice();
-        void* mappedData;
-        vkMapMemory(device, vertexBufferMemory, 0, sizeof(T) * size, 0, &mappedData);
         size_t dataSize = sizeof(T) * std::min((uint32_t)src.size(), (uint32_t)size);
         memcpy(mappedData, src.data(), dataSize);
-        vkUnmapMemory(device, vertexBufferMemory);
+    }
+
+    // copies count elements to the buffer, starting at element offset
+    void memcopyFrom(const T* src, uint32_t offset, uint32_t count) {
+        if (offset + count > size) {
+            throw std::runtime_error("copy exceeds the size of the buffer!");
+        }
+        memcpy(getMappedData() + offset, src, sizeof(T) * count);
     }
 
     void memcopyTo(std::vector<T>& dst) {
-        auto& device = vulkanContext.getDevice();
-        void* mappedData;
-        vkMapMemory(device, vertexBufferMemory, 0, sizeof(T) * size, 0, &mappedData);
         size_t dataSize = sizeof(T) * std::min((uint32_t)dst.size(), (uint32_t)size);
         memcpy(dst.data(), mappedData, dataSize);
-        vkUnmapMemory(device, vertexBufferMemory);
     }
 
     void zero()
     {
-        auto& device = vulkanContext.getDevice();
-        void* mappedData;
-        vkMapMemory(device, vertexBufferMemory, 0, sizeof(T) * size, 0, &mappedData);
         memset(mappedData, 0, sizeof(T) * size);
-        vkUnmapMemory(device, vertexBufferMemory);
+    }
+
+    // the persistent mapping of the buffer
+    T* getMappedData() {
+        return static_cast<T*>(mappedData);
     }
 
     void _recordZero(VkCommandBuffer commandBuffer) {
@@ -103,6 +96,7 @@ private:
 
     VkBuffer vertexBuffer;
     VkDeviceMemory vertexBufferMemory;
+    void* mappedData = nullptr;
     VulkanContext& vulkanContext;
 
 
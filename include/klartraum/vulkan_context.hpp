@@ -2,6 +2,7 @@
 #define VULKAN_CONTEXT_HPP
 
 #include <algorithm>
+#include <array>
 #include <iostream>
 #include <memory>
 #include <optional>
@@ -17,9 +18,14 @@
 
 #include "klartraum/backend_config.hpp"
 #include "klartraum/camera.hpp"
+#include "klartraum/descriptor_allocator.hpp"
+#include "klartraum/pipeline_builder.hpp"
 
 namespace klartraum {
 
+// identifies a physical device across runs, see VkPhysicalDeviceIDProperties::deviceUUID
+typedef std::array<uint8_t, VK_UUID_SIZE> DeviceUUID;
+
 struct QueueFamilyIndices {
     std::optional<uint32_t> presentFamily;
     std::optional<uint32_t> graphicsAndComputeFamily;
@@ -150,7 +156,7 @@ public:
     VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
 
     VkDevice device;
-    VkSwapchainKHR swapChain;
+    VkSwapchainKHR swapChain = VK_NULL_HANDLE;
 
     VkQueue graphicsQueue;
     VkQueue presentQueue;
@@ -173,6 +179,9 @@ public:
 
     VkImage& getSwapChainImage(uint32_t imageIndex);
 
+    // depends on BackendConfig::SWAPCHAIN_IMAGE_COUNT and the limits of the surface
+    uint32_t getSwapChainImageCount() const;
+
     VkExtent2D& getSwapChainExtent();
 
     const VkFormat& getSwapChainImageFormat() const;
@@ -182,7 +191,18 @@ public:
     BackendConfig config;
 
     uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
+    // storage and uniform buffers are addressable if hasBufferDeviceAddress
     void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& bufferMemory);
+
+    // see BackendConfig::BUFFER_DEVICE_ADDRESS, only known after initialize
+    bool hasBufferDeviceAddress() const {
+        return bufferDeviceAddressEnabled;
+    }
+
+    // the address of a buffer created by createBuffer, e.g. given to a shader in push constants
+    VkDeviceAddress getBufferDeviceAddress(VkBuffer buffer);
+    // the config has to be set before initialize, e.g. the present mode,
+    // the number of frames in flight and the number of swapchain images
     BackendConfig& getConfig();
 
     std::vector<VkFence> inFlightFences;
@@ -194,14 +214,103 @@ public:
 
     uint32_t currentFrame = 0;
 
+    // the frame in flight between beginRender and endRender
+    uint32_t getCurrentFrame() const {
+        return currentFrame;
+    }
+
     std::tuple<uint32_t, VkSemaphore&> beginRender();
     void endRender(uint32_t imageIndex, VkSemaphore& renderFinishedSemaphore);
     void stopRender();
 
+    // size of the framebuffer of the window, used if the surface does not
+    // define the extent of the swapchain, the swapchain is recreated after the next frame
+    void setWindowExtent(VkExtent2D extent);
+
+    // recreates the swapchain with the current size of the surface, the old swapchain
+    // is handed over to the new one, the number of images stays the same,
+    // this is done by beginRender and endRender if the swapchain is out of date,
+    // returns false if the surface has no size (minimized window)
+    bool recreateSwapChain();
+
+    // increased every time the swapchain is recreated, the images and image views
+    // taken from the context before have to be replaced then
+    uint64_t getSwapChainVersion() const {
+        return swapChainVersion;
+    }
+
     void createCommandPool();
 
+    // e.g. to store results that are only valid for this device, like tuned kernel parameters
+    const DeviceUUID& getDeviceUUID() const {
+        return deviceUUID;
+    }
+
+    // shared by all pipelines created with the context, see BackendConfig::PIPELINE_CACHE_PATH
+    VkPipelineCache getPipelineCache() const {
+        return pipelineCache;
+    }
+
+    // the worker threads recording command buffers and creating pipelines,
+    // created once with the context and shared by all graphs
+    ThreadPool& getThreadPool() {
+        return threadPool;
+    }
+
+    // creates the compute pipelines of the elements, concurrently while a graph is compiled
+    PipelineBuilder& getPipelineBuilder() {
+        return pipelineBuilder;
+    }
+
+    // the descriptor sets of all elements come from its pools
+    DescriptorAllocator& getDescriptorAllocator() {
+        return descriptorAllocator;
+    }
+
     VkCommandPool commandPool;
     std::vector<VkCommandBuffer> commandBuffers;
+
+    // gpu time in milliseconds of the work of the last finished frame,
+    // 0 if timestamps are not supported or no frame finished yet
+    float getGpuFrameTime() const {
+        return gpuFrameTime;
+    }
+
+    // returns the command buffer writing the begin timestamp of the current frame,
+    // to be submitted in front of the first command buffer of the frame's work,
+    // VK_NULL_HANDLE if timestamps are not supported
+    VkCommandBuffer beginTimestamp();
+
+private:
+    // two timestamps per frame in flight, the begin timestamp is submitted with the
+    // frame's work and the end timestamp in endRender after the frame's work finished
+    void createTimestampQueries();
+    void readTimestampQueries();
+
+    VkQueryPool timestampQueryPool = VK_NULL_HANDLE;
+    std::vector<VkCommandBuffer> timestampBeginCommandBuffers;
+    std::vector<VkCommandBuffer> timestampEndCommandBuffers;
+    std::vector<bool> timestampsBegun;
+    std::vector<bool> timestampsWritten;
+    float timestampPeriod = 0.0f; // nanoseconds per timestamp tick
+    float gpuFrameTime = 0.0f;
+
+    // loaded in initialize and saved in shutdown
+    void createPipelineCache();
+    void savePipelineCache();
+
+    VkPipelineCache pipelineCache = VK_NULL_HANDLE;
+    // declared before the users of its workers, so that it is destroyed after them
+    ThreadPool threadPool;
+    PipelineBuilder pipelineBuilder;
+    DescriptorAllocator descriptorAllocator;
+
+    DeviceUUID deviceUUID{};
+    bool bufferDeviceAddressEnabled = false;
+
+    VkExtent2D windowExtent = {0, 0};
+    bool swapChainOutdated = false;
+    uint64_t swapChainVersion = 0;
 };
 
 } // namespace klartraum
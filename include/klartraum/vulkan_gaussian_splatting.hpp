@@ -10,6 +10,9 @@
 #include "klartraum/computegraph/computegraphgroup.hpp"
 #include "klartraum/computegraph/imageviewsrc.hpp"
 #include "klartraum/computegraph/rendergraphelement.hpp"
+#include "klartraum/gaussian_splatting_loader.hpp"
+#include "klartraum/gaussian_splatting_lod.hpp"
+#include "klartraum/gaussian_splatting_streaming.hpp"
 #include "klartraum/vulkan_buffer.hpp"
 #include "klartraum/vulkan_gaussian_splatting_types.hpp"
 
@@ -20,14 +23,50 @@ enum class GaussianSplattingRenderingType {
     // GaussianSplatting, not implemented yet
 };
 
+struct GaussianSortOptions {
+    // reuse the order of the previous frame and only fix it up while the camera
+    // moves slowly, instead of running the full radix sort every frame,
+    // if the fix-up leaves gaussians out of order, the full sort runs in the same frame
+    bool temporal = false;
+
+    // number of odd-even transposition passes of the fix-up, each pass
+    // moves a gaussian by at most one position
+    uint32_t fixupPasses = 8;
+
+    // camera movement between two frames of a path up to which the order is reused
+    float maxViewAngle = 0.05f;       // in radians
+    float maxViewTranslation = 0.02f; // relative to the radius of the scene
+};
+
+struct GaussianSplattingOptions {
+    GaussianLoadOptions load;
+    GaussianLodOptions lod;
+    GaussianStreamingOptions streaming;
+    GaussianSortOptions sort;
+    GaussianKernelConstants kernels;
+
+    // kernels is replaced by the constants tuned for the device, if there are any
+    // (see GaussianKernelTuner and BackendConfig::KERNEL_TUNING_PATH)
+    bool useTunedKernels = true;
+
+    // records the kernels depending on the resolution before every frame (see
+    // ComputeGraphElement::setDynamic), so that frequent changes of the resolution,
+    // e.g. by KlartraumEngine::setDynamicResolution, do not wait for the queue
+    bool dynamicResolution = false;
+};
+
 class VulkanGaussianSplatting : virtual public RenderGraphElement, virtual public ComputeGraphGroup {
     /**
      * @brief
      *
      * Gaussian Splatting consists of these steps:
-     * 1. project the 3D Gaussian to 2D
+     * 0. select the chunks of spatially close 3D Gaussians from the level of detail
+     *    hierarchy and cull them against the view frustum, only chunks resident
+     *    in the page pool are considered (see GaussianResidencyManager)
+     * 1. project the 3D Gaussians of the visible chunks to 2D
      * 2. distribute/bin the 2D Gaussians to 4x4 subtiles
-     * 3. sort the 2D Gaussians by depth and tile using radix sort
+     * 3. sort the 2D Gaussians by depth and tile using radix sort, or, while the
+     *    camera moves slowly, fix up the order of the previous frame
      * 4. splat the 2D Gaussians to each subtile of the image
      *
      * The current implementation is probably not optimal:
@@ -45,13 +84,16 @@ public:
         VulkanContext& vulkanContext,
         std::shared_ptr<ImageViewSrc> imageViewSrc,
         std::shared_ptr<CameraUboType> cameraUBO,
-        std::string path);
+        std::string path,
+        const GaussianSplattingOptions& options = GaussianSplattingOptions());
     ~VulkanGaussianSplatting();
 
     virtual void checkInput(ComputeGraphElementPtr input, int index = 0) override;
 
     virtual void _setup(VulkanContext& vulkanContext, uint32_t numberPaths) override;
 
+    virtual void _update(uint32_t pathId) override;
+
     virtual void _record(VkCommandBuffer commandBuffer, uint32_t pathId) override;
 
     virtual const char* getType() const override {
@@ -59,24 +101,66 @@ public:
     }
 
 private:
-    void loadSPZModel(std::string path);
-    void loadPLYModel(std::string path);
+    // the file format is chosen by the extension of path (.spz or .ply)
+    void loadModel(const std::string& path, const GaussianLoadOptions& options);
+    void loadSPZModel(const std::string& path, const GaussianLoadOptions& options);
+    void loadPLYModel(const std::string& path, const GaussianLoadOptions& options);
+
+    bool isViewChangeSmall(const glm::mat4& previous, const glm::mat4& current) const;
+
+    // the extent of the ImageViewSrc, the splatting renders at this resolution
+    VkExtent2D getTargetExtent();
+    void setResolution(VkExtent2D extent);
+    std::vector<ComputeGraphElementPtr> getResolutionElements() const;
 
     VulkanContext* vulkanContext = nullptr;
 
+    // the inputs, resolved in the constructor so that the updates and the recording need no casts
+    ImageViewSrc* target = nullptr;
+    CameraUboType* camera = nullptr;
+
     VkBuffer vertexBuffer;
     VkDeviceMemory vertexBufferMemory;
 
-    std::vector<Gaussian3D> gaussians3DData;
-    uint32_t number_of_gaussians;
+    std::vector<Gaussian3D> gaussians3DData; // only used while loading, released once uploaded or streamed
+    std::vector<GaussianChunk> chunksData;
+    std::vector<uint32_t> parentsData;
+    uint32_t number_of_gaussians = 0; // number of leaves of the hierarchy
+    uint32_t maxVisibleSplats = 0;
+
+    const uint32_t gridSize = 4; // 4x4 grid for binning
+    const uint32_t maxGaussiansModifier = 2; // arbitrary number, currently 2x the number of initial 3D gaussians
+    VkExtent2D resolution = {0, 0};
+
+    GaussianLodOptions lodOptions;
+    GaussianStreamingOptions streamingOptions;
+    GaussianSortOptions sortOptions;
+    GaussianKernelConstants kernelConstants;
+    float sceneRadius = 0.0f;
+
+    std::unique_ptr<GaussianPageFile> pageFile;
+    std::unique_ptr<GaussianResidencyManager> residencyManager;
+    std::vector<uint64_t> pageTableVersions; // per path
+    uint64_t changedPageTableVersion = 0;
+    std::vector<uint32_t> feedbackData;
+    std::vector<glm::mat4> previousModelViews; // per path, for the incremental sort
 
     uint32_t numberOfPaths = 0;
 
     std::shared_ptr<BufferElementSinglePath<Gaussian3DBuffer>> gaussians3D;
     std::shared_ptr<BufferElement<Gaussian2DBuffer>> gaussians2D;
-
+    std::shared_ptr<BufferElementSinglePath<GaussianChunkBuffer>> chunks;
+    std::shared_ptr<BufferElement<VulkanBuffer<GaussianLodState>>> lodState;
+    std::shared_ptr<BufferElement<VulkanBuffer<uint32_t>>> pageTable;
+    std::shared_ptr<BufferElement<VulkanBuffer<uint32_t>>> feedback;
+    std::shared_ptr<BufferElement<VulkanBuffer<TemporalSortState>>> sortState;
+    std::shared_ptr<BufferElement<VulkanBuffer<uint32_t>>> forceFullSort;
+
+    std::shared_ptr<GaussianChunkCulling> cullChunks;
     std::shared_ptr<GaussianProjection> project3Dto2D;
     std::shared_ptr<GaussianSort> sort2DGaussians;
+    std::shared_ptr<GaussianTemporalSortRefresh> refreshSort;
+    std::shared_ptr<GaussianTemporalSortResolve> resolveSort;
     std::shared_ptr<GaussianBinning> bin;
     std::shared_ptr<GaussianComputeBounds> computeBounds;
     std::shared_ptr<GaussianSplatting> splat;
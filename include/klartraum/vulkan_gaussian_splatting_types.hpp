@@ -18,8 +18,18 @@ struct Gaussian2D {
     uint32_t binMask;
     glm::mat2 covariance;
     glm::vec3 color;
+    float alpha;
+    uint32_t id;        // index of the 3D gaussian in the page pool
 };
 
+// the record the splat kernel keeps per gaussian in shared memory, only used on the gpu,
+// mirrored here for its size (see Splat2D in shaders/gsplat/gsplat_types.glsl)
+struct Splat2D {
+    std::array<float, 4> positionAndConic;
+    std::array<uint32_t, 4> conicAndColor;
+};
+static_assert(sizeof(Splat2D) == 32, "Splat2D has to match the shader");
+
 // this is a copy of the UnpackedGaussian struct from spz::UnpackedGaussian
 struct Gaussian3D {
     std::array<float, 3> position;  // x, y, z
@@ -32,8 +42,24 @@ struct Gaussian3D {
     std::array<float, 15> shB;
   };
 
+// a spatially coherent, consecutive range of 3D gaussians
+// the bounding box includes the extent of the gaussians (3 sigma)
+struct GaussianChunk {
+    std::array<float, 3> boundsMin;
+    uint32_t first;                 // index of the first gaussian of the chunk
+    std::array<float, 3> boundsMax;
+    uint32_t count;                 // number of gaussians in the chunk
+
+    // level of detail selection, see gaussian_splatting_lod.hpp
+    std::array<float, 4> sphere;       // bounding sphere (center, radius) of this chunk
+    std::array<float, 4> parentSphere; // bounding sphere of the parent chunk
+    float error;                       // world space error compared to the leaves
+    float parentError;                 // error of the parent chunk, infinity for the roots
+};
+
 typedef VulkanBuffer<Gaussian3D> Gaussian3DBuffer;
 typedef VulkanBuffer<Gaussian2D> Gaussian2DBuffer;
+typedef VulkanBuffer<GaussianChunk> GaussianChunkBuffer;
 
 struct ProjectionPushConstants {
   uint32_t numElements;
@@ -44,6 +70,22 @@ struct ProjectionPushConstants {
 
 typedef GeneralComputation<ProjectionPushConstants> GaussianProjection;
 
+struct ChunkCullingPushConstants {
+  uint32_t numChunks;
+  uint32_t maxVisibleSplats;   // capacity of the list of visible gaussians
+  uint32_t splatBudget;
+  float screenHeight;
+  float minErrorThreshold;     // in pixels
+};
+
+// persistent state of the level of detail selection, one per path
+struct GaussianLodState {
+  float errorThreshold;        // in pixels, adapted to the splat budget every frame
+  uint32_t finishedGroups;
+};
+
+typedef GeneralComputation<ChunkCullingPushConstants> GaussianChunkCulling;
+
 struct SplatPushConstants {
   uint32_t numElements;
   uint32_t gridSize;
@@ -54,6 +96,15 @@ struct SplatPushConstants {
 };
 
 
+// workgroup sizes of the splatting kernels, given to all of them as specialization
+// constants (see shaders/gsplat/gsplat_constants.glsl, the i-th member is constant_id i),
+// the group counts are computed from the same values
+struct GaussianKernelConstants {
+  uint32_t projectionGroupSize = 128; // projection and binning
+  uint32_t sortGroupSize = 128;       // radix sort and the kernels dispatched like it, at least 16
+  uint32_t splatTileSize = 8;         // the splatting uses splatTileSize x splatTileSize threads per group
+};
+
 struct SortPushConstants {
   uint32_t pass;
   uint32_t numElements;
@@ -61,6 +112,20 @@ struct SortPushConstants {
 };
 typedef BufferTransformation<Gaussian2DBuffer, Gaussian2DBuffer, void, SortPushConstants> GaussianSort;
 
+// persistent state of the incremental sort, one per path
+struct TemporalSortState {
+  uint32_t previousCount;      // number of binned gaussians sorted in the previous frame of the path
+  uint32_t invalidEntries;
+  uint32_t unsortedPairs;      // neighbours still out of order after the fix-up
+  uint32_t useTemporal;        // 1 if the order of the previous frame is reused
+  uint32_t finishedGroups;
+};
+
+typedef GeneralComputation<ProjectionPushConstants> GaussianTemporalSortRefresh;
+typedef GeneralComputation<SortPushConstants> GaussianTemporalSortFixup;
+typedef GeneralComputation<> GaussianTemporalSortCheck;
+typedef GeneralComputation<ProjectionPushConstants> GaussianTemporalSortResolve;
+
 typedef GeneralComputation<ProjectionPushConstants> GaussianBinning;
 typedef GeneralComputation<ProjectionPushConstants> GaussianComputeBounds;
 typedef GeneralComputation<SplatPushConstants> GaussianSplatting;
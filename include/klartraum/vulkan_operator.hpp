@@ -20,7 +20,6 @@ public:
     VulkanOperator(VulkanContext &vulkanContext, const std::string &shaderPath)
     {
         this->vulkanContext = &vulkanContext;
-        createDescriptorPool();
         createComputeDescriptorSetLayout();
         
         createComputePipeline(shaderPath);
@@ -32,7 +31,7 @@ public:
         vkDestroyPipelineLayout(vulkanContext->getDevice(), computePipelineLayout, nullptr);
         vkDestroyPipeline(vulkanContext->getDevice(), computePipeline, nullptr);
         vkDestroyDescriptorSetLayout(vulkanContext->getDevice(), computeDescriptorSetLayout, nullptr);
-        vkDestroyDescriptorPool(vulkanContext->getDevice(), descriptorPool, nullptr);
+        vulkanContext->getDescriptorAllocator().free(computeDescriptorSets);
     };
 
     VulkanOperationResult* operator()(A& a, B& b, R& result)
@@ -60,11 +59,12 @@ public:
     }
 
 private:
-    VkDescriptorPool descriptorPool;
+    // every call of the operator allocates one set, the last one is recorded
+    std::vector<VkDescriptorSet> computeDescriptorSets;
     VkDescriptorSet computeDescriptorSet;
     VkDescriptorSetLayout computeDescriptorSetLayout;
     VkPipelineLayout computePipelineLayout;
-    VkPipeline computePipeline;
+    VkPipeline computePipeline = VK_NULL_HANDLE;
 
     VulkanContext* vulkanContext;
 
@@ -72,34 +72,6 @@ private:
     uint32_t groupCountY = 1;
     uint32_t groupCountZ = 1;
 
-    void createDescriptorPool() {
-        auto& device = vulkanContext->getDevice();
-        auto& config = vulkanContext->getConfig();
-    
-        std::array<VkDescriptorPoolSize, 3> poolSizes{};
-        // A
-        poolSizes[0].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-        poolSizes[0].descriptorCount = 3; //static_cast<uint32_t>(swapChainSize);
-        
-        // B
-        poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-        poolSizes[1].descriptorCount = 3; //static_cast<uint32_t>(swapChainSize);
-    
-        // Result
-        poolSizes[2].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-        poolSizes[2].descriptorCount = 3; //static_cast<uint32_t>(swapChainSize);
-    
-        VkDescriptorPoolCreateInfo poolInfo{};
-        poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-        poolInfo.poolSizeCount = (uint32_t)poolSizes.size();
-        poolInfo.pPoolSizes = poolSizes.data();
-        poolInfo.maxSets = 3;
-    
-        if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS) {
-            throw std::runtime_error("failed to create descriptor pool!");
-        }
-    }    
-
     void createComputeDescriptorSetLayout()
     {
         auto& device = vulkanContext->getDevice();
@@ -140,20 +112,11 @@ private:
     void createComputeDescriptorSets(A& a, B& b, R& r)
     {
         auto& device = vulkanContext->getDevice();
-        auto& config = vulkanContext->getConfig();
-    
-        //VkDescriptorSetLayout layout;
-        VkDescriptorSetAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-        allocInfo.descriptorPool = descriptorPool;
-        allocInfo.descriptorSetCount = 1;
-        allocInfo.pSetLayouts = &computeDescriptorSetLayout;
-    
-        //computeDescriptorSet;
-        VkResult result = vkAllocateDescriptorSets(device, &allocInfo, &computeDescriptorSet);
-        if (result != VK_SUCCESS) {
-            throw std::runtime_error("failed to allocate descriptor sets!");
-        }
+
+        // A, B and Result
+        computeDescriptorSet = vulkanContext->getDescriptorAllocator().allocate(
+            computeDescriptorSetLayout, {{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 3}}, 1)[0];
+        computeDescriptorSets.push_back(computeDescriptorSet);
     
         VkDescriptorBufferInfo storageBufferInfoA{};
         storageBufferInfoA.buffer = a.getBuffer();
@@ -203,18 +166,6 @@ private:
     {
         auto& device = vulkanContext->getDevice();
 
-        auto computeShaderCode = readFile(shaderPath);
-    
-        VkShaderModule computeShaderModule = createShaderModule(computeShaderCode, vulkanContext->getDevice());
-        
-        VkPipelineShaderStageCreateInfo computeShaderStageInfo{};
-        computeShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-        computeShaderStageInfo.stage = VK_SHADER_STAGE_COMPUTE_BIT;
-        computeShaderStageInfo.module = computeShaderModule;
-        computeShaderStageInfo.pName = "main";
-    
-    
-        
         VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
         pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
         pipelineLayoutInfo.setLayoutCount = 2;
@@ -225,18 +176,8 @@ private:
         if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &computePipelineLayout) != VK_SUCCESS) {
             throw std::runtime_error("failed to create compute pipeline layout!");
         }
-    
-    
-        VkComputePipelineCreateInfo pipelineInfo{};
-        pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
-        pipelineInfo.layout = computePipelineLayout;
-        pipelineInfo.stage = computeShaderStageInfo;
-        
-        if (vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &computePipeline) != VK_SUCCESS) {
-            throw std::runtime_error("failed to create compute pipeline!");
-        }
-    
-        vkDestroyShaderModule(device, computeShaderModule, nullptr);        
+
+        vulkanContext->getPipelineBuilder().addComputePipeline(shaderPath, computePipelineLayout, &computePipeline);
     }
 
 };
@@ -0,0 +1,39 @@
+// the screen is divided into gridSize x gridSize bins, every 2D gaussian is
+// duplicated for each bin it overlaps (see gsplat_binning.comp)
+
+// Helper function to check if a gaussian overlaps with a bin
+bool overlapsWithBin(Gaussian2D gaussian, uint binIndex, uint gridSize, vec2 screenSize) {
+    // Calculate grid cell size
+    float cellWidth = screenSize.x / float(gridSize);
+    float cellHeight = screenSize.y / float(gridSize);
+    
+    // Calculate bin bounds
+    uint gridX = binIndex % gridSize;
+    uint gridY = binIndex / gridSize;
+    
+    vec2 binMin = vec2(gridX * cellWidth, gridY * cellHeight);
+    vec2 binMax = vec2((gridX + 1) * cellWidth, (gridY + 1) * cellHeight);
+    
+    // Calculate gaussian bounds using covariance matrix
+    // For simplicity, we'll use the diagonal elements of the covariance matrix
+    // as a measure of the gaussian's spread
+    //THIS SHOULD BE WORKED OUT PROPERLY
+    mat2 covariance = inverse(gaussian.covarianceInv);
+    float stdDevX = sqrt(covariance[0][0]);
+    float stdDevY = sqrt(covariance[1][1]);
+    float spreadX = stdDevX * 2.5; // Use 2.5 standard deviations for overlap check
+    float spreadY = stdDevY * 2.5; // Use 2.5 standard deviations for overlap check
+
+    vec2 gaussianMin = gaussian.position - vec2(spreadX, spreadY);
+    vec2 gaussianMax = gaussian.position + vec2(spreadX, spreadY);
+
+    // Check for overlap
+    return !(gaussianMax.x < binMin.x || gaussianMin.x > binMax.x ||
+             gaussianMax.y < binMin.y || gaussianMin.y > binMax.y);
+}
+
+// order of the binned gaussians after sorting: by bin, then front to back,
+// the same order the radix sort produces (the depth of binned gaussians is >= 1)
+bool isSortedBefore(Gaussian2D a, Gaussian2D b) {
+    return a.binMask < b.binMask || (a.binMask == b.binMask && a.z < b.z);
+}
@@ -0,0 +1,13 @@
+// workgroup sizes of the splatting kernels, given as specialization constants
+// by the host (see GaussianKernelConstants), the host computes the group counts
+// from the same values, the defaults are used if no constants are given
+
+// threads per workgroup of the projection and the binning, one per visible gaussian
+layout(constant_id = 0) const uint projectionGroupSize = 128;
+
+// elements per workgroup (and per local histogram) of the radix sort and of
+// the kernels dispatched with its group count, at least the 16 bins of a pass
+layout(constant_id = 1) const uint sortGroupSize = 128;
+
+// the splatting runs splatTileSize x splatTileSize threads per workgroup, one per pixel
+layout(constant_id = 2) const uint splatTileSize = 8;
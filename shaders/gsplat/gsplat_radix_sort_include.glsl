@@ -1,4 +1,5 @@
 #include "gsplat_types.glsl"
+#include "gsplat_constants.glsl"
 
 #extension GL_EXT_debug_printf : enable
 
@@ -1,3 +1,6 @@
+// number of 3D gaussians per chunk, see GaussianChunkSize
+#define GSPLAT_CHUNK_SIZE 256
+
 struct Gaussian {
     vec3 position;
     vec4 rotation;
@@ -16,6 +19,17 @@ struct Gaussian2D {
     mat2 covarianceInv; // inverse covariance matrix for the gaussian
     vec3 color; // color of the gaussian
     float alpha;
+    uint id; // index of the 3D gaussian in the page pool it was projected from
+};
+
+// compact form of a Gaussian2D that the splat kernel keeps in shared memory,
+// two 16 byte members so that no padding is added (32 bytes, see Splat2D in
+// vulkan_gaussian_splatting_types.hpp)
+struct Splat2D {
+    vec4 positionAndConic; // position in screen space and conic.xy
+    // the bits of conic.z, followed by color and log2(alpha) as four halfs,
+    // the conic is the upper triangle of the inverse covariance, scaled for exp2, see toSplat2D
+    uvec4 conicAndColor;
 };
 
 struct StartAndEnd {
@@ -27,4 +41,29 @@ struct DispatchIndirectCommand {
     uint x;
     uint y;
     uint z;
-};
\ No newline at end of file
+};
+
+struct GaussianChunk {
+    vec3 boundsMin;
+    uint first; // index of the first gaussian of the chunk
+    vec3 boundsMax;
+    uint count; // number of gaussians in the chunk
+
+    // level of detail selection
+    vec4 sphere; // bounding sphere (center, radius) of this chunk
+    vec4 parentSphere; // bounding sphere of the parent chunk
+    float error; // world space error compared to the leaves
+    float parentError; // error of the parent chunk, infinity for the roots
+};
+
+struct GaussianLodState {
+    float errorThreshold; // in pixels, adapted to the splat budget every frame
+    uint finishedGroups; // number of workgroups of the culling pass that are done
+};
+struct TemporalSortState {
+    uint previousCount; // number of binned gaussians sorted in the previous frame of the path
+    uint invalidEntries; // gaussians of the previous frame that left their bin
+    uint unsortedPairs; // neighbours still out of order after the fix-up passes, counted by the check
+    uint useTemporal; // 1 if the order of the previous frame is reused in this frame
+    uint finishedGroups; // number of workgroups of the refresh or the check pass that are done
+};
@@ -0,0 +1,153 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include "klartraum/descriptor_allocator.hpp"
+
+namespace klartraum {
+
+// descriptors per set of a new pool, the types used by the elements of the library
+static const std::vector<VkDescriptorPoolSize> DefaultSetSizes = {
+    {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 8},
+    {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1},
+    {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1},
+};
+
+static const uint32_t MaxPoolSets = 4096;
+
+void DescriptorAllocator::initialize(VkDevice device) {
+    this->device = device;
+}
+
+void DescriptorAllocator::destroy() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& pool : pools) {
+        vkDestroyDescriptorPool(device, pool.pool, nullptr);
+    }
+    pools.clear();
+    allocations.clear();
+}
+
+std::vector<VkDescriptorSet> DescriptorAllocator::allocate(VkDescriptorSetLayout layout, const std::vector<VkDescriptorPoolSize>& sizes, uint32_t count) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    std::vector<VkDescriptorSet> sets(count, VK_NULL_HANDLE);
+    if (count == 0) {
+        return sets;
+    }
+
+    // the latest pools are the largest ones and most likely have room
+    for (size_t i = pools.size(); i-- > 0;) {
+        if (fits(pools[i], sizes, count) && tryAllocate(i, layout, sizes, count, sets)) {
+            return sets;
+        }
+    }
+
+    size_t poolIndex = createPool(sizes, count);
+    if (!tryAllocate(poolIndex, layout, sizes, count, sets)) {
+        throw std::runtime_error("failed to allocate descriptor sets!");
+    }
+    return sets;
+}
+
+void DescriptorAllocator::free(const std::vector<VkDescriptorSet>& sets) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto set : sets) {
+        auto allocation = allocations.find(set);
+        if (allocation == allocations.end()) {
+            continue;
+        }
+        Pool& pool = pools[allocation->second.pool];
+        vkFreeDescriptorSets(device, pool.pool, 1, &set);
+        pool.freeSets++;
+        for (auto& size : allocation->second.sizes) {
+            pool.freeDescriptors[size.type] += size.descriptorCount;
+        }
+        allocations.erase(allocation);
+    }
+}
+
+bool DescriptorAllocator::fits(const Pool& pool, const std::vector<VkDescriptorPoolSize>& sizes, uint32_t count) const {
+    if (pool.freeSets < count) {
+        return false;
+    }
+    std::map<VkDescriptorType, uint32_t> needed;
+    for (auto& size : sizes) {
+        needed[size.type] += size.descriptorCount * count;
+    }
+    for (auto& need : needed) {
+        auto available = pool.freeDescriptors.find(need.first);
+        if (available == pool.freeDescriptors.end() || available->second < need.second) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool DescriptorAllocator::tryAllocate(size_t poolIndex, VkDescriptorSetLayout layout, const std::vector<VkDescriptorPoolSize>& sizes, uint32_t count, std::vector<VkDescriptorSet>& sets) {
+    Pool& pool = pools[poolIndex];
+
+    std::vector<VkDescriptorSetLayout> layouts(count, layout);
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = pool.pool;
+    allocInfo.descriptorSetCount = count;
+    allocInfo.pSetLayouts = layouts.data();
+
+    // the counters can not tell whether the pool is fragmented
+    VkResult result = vkAllocateDescriptorSets(device, &allocInfo, sets.data());
+    if (result == VK_ERROR_FRAGMENTED_POOL || result == VK_ERROR_OUT_OF_POOL_MEMORY) {
+        return false;
+    }
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate descriptor sets!");
+    }
+
+    pool.freeSets -= count;
+    for (auto& size : sizes) {
+        pool.freeDescriptors[size.type] -= size.descriptorCount * count;
+    }
+    for (auto set : sets) {
+        allocations[set] = {poolIndex, sizes};
+    }
+    return true;
+}
+
+size_t DescriptorAllocator::createPool(const std::vector<VkDescriptorPoolSize>& sizes, uint32_t count) {
+    Pool pool;
+    pool.freeSets = std::max(nextPoolSets, count);
+    nextPoolSets = std::min(nextPoolSets * 2, MaxPoolSets);
+
+    for (auto& size : DefaultSetSizes) {
+        pool.freeDescriptors[size.type] = size.descriptorCount * pool.freeSets;
+    }
+    std::map<VkDescriptorType, uint32_t> needed;
+    for (auto& size : sizes) {
+        needed[size.type] += size.descriptorCount * count;
+    }
+    for (auto& need : needed) {
+        uint32_t& available = pool.freeDescriptors[need.first];
+        available = std::max(available, need.second);
+    }
+
+    std::vector<VkDescriptorPoolSize> poolSizes;
+    for (auto& available : pool.freeDescriptors) {
+        poolSizes.push_back({available.first, available.second});
+    }
+
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    // the elements give their sets back when they are destroyed
+    poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+    poolInfo.poolSizeCount = (uint32_t)poolSizes.size();
+    poolInfo.pPoolSizes = poolSizes.data();
+    poolInfo.maxSets = pool.freeSets;
+
+    if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &pool.pool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create descriptor pool!");
+    }
+
+    pools.push_back(pool);
+    return pools.size() - 1;
+}
+
+} // namespace klartraum
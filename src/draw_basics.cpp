@@ -104,11 +104,12 @@ void DrawBasics::createGraphicsPipeline() {
     auto device = vulkanContext->getDevice();
     auto swapChainExtent = vulkanContext->getSwapChainExtent();
 
-    auto vertShaderCode = readFile("shaders/shader_draw_basics.vert.spv");
-    auto fragShaderCode = readFile("shaders/shader.frag.spv");
+    // embedded into the library, see PipelineBuilder::getShaderCode
+    auto vertShaderCode = vulkanContext->getPipelineBuilder().getShaderCode("shaders/shader_draw_basics.vert.spv");
+    auto fragShaderCode = vulkanContext->getPipelineBuilder().getShaderCode("shaders/shader.frag.spv");
 
-    VkShaderModule vertShaderModule = createShaderModule(vertShaderCode, device);
-    VkShaderModule fragShaderModule = createShaderModule(fragShaderCode, device);
+    VkShaderModule vertShaderModule = createShaderModule(*vertShaderCode, device);
+    VkShaderModule fragShaderModule = createShaderModule(*fragShaderCode, device);
 
     VkPipelineShaderStageCreateInfo vertShaderStageInfo{};
     vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -243,7 +244,7 @@ void DrawBasics::createGraphicsPipeline() {
     pipelineInfo.basePipelineHandle = VK_NULL_HANDLE; // Optional
     pipelineInfo.basePipelineIndex = -1; // Optional
 
-    if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &graphicsPipeline) != VK_SUCCESS) {
+    if (vkCreateGraphicsPipelines(device, vulkanContext->getPipelineCache(), 1, &pipelineInfo, nullptr, &graphicsPipeline) != VK_SUCCESS) {
         throw std::runtime_error("failed to create graphics pipeline!");
     }
 
@@ -0,0 +1,19 @@
+#include <cstring>
+
+#include "klartraum/embedded_shaders.hpp"
+
+// generated from the compiled shaders at build time
+#include "klartraum/embedded_shaders_data.hpp"
+
+namespace klartraum {
+
+const EmbeddedShader* findEmbeddedShader(const std::string& name) {
+    for (const EmbeddedShader* shader = embedded::shaders; shader->name != nullptr; shader++) {
+        if (strcmp(shader->name, name.c_str()) == 0) {
+            return shader;
+        }
+    }
+    return nullptr;
+}
+
+} // namespace klartraum
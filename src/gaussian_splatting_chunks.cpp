@@ -0,0 +1,116 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+#include "klartraum/gaussian_splatting_chunks.hpp"
+
+namespace klartraum {
+
+namespace {
+
+// spreads the lower 21 bits of v so that there are two zero bits between each of them
+uint64_t spreadBits(uint32_t v) {
+    uint64_t x = v & 0x1fffff;
+    x = (x | x << 32) & 0x1f00000000ffffull;
+    x = (x | x << 16) & 0x1f0000ff0000ffull;
+    x = (x | x << 8) & 0x100f00f00f00f00full;
+    x = (x | x << 4) & 0x10c30c30c30c30c3ull;
+    x = (x | x << 2) & 0x1249249249249249ull;
+    return x;
+}
+
+} // namespace
+
+uint64_t encodeMortonCode(uint32_t x, uint32_t y, uint32_t z) {
+    return spreadBits(x) | (spreadBits(y) << 1) | (spreadBits(z) << 2);
+}
+
+std::vector<GaussianChunk> partitionIntoChunks(std::vector<Gaussian3D>& gaussians, uint32_t chunkSize) {
+    if (chunkSize == 0) {
+        throw std::runtime_error("chunk size must not be zero!");
+    }
+
+    std::vector<GaussianChunk> chunks;
+    if (gaussians.empty()) {
+        return chunks;
+    }
+
+    // STEP 1: bounding box of all gaussian centers
+    std::array<float, 3> sceneMin = gaussians[0].position;
+    std::array<float, 3> sceneMax = gaussians[0].position;
+    for (auto& gaussian : gaussians) {
+        for (int i = 0; i < 3; i++) {
+            sceneMin[i] = std::min(sceneMin[i], gaussian.position[i]);
+            sceneMax[i] = std::max(sceneMax[i], gaussian.position[i]);
+        }
+    }
+
+    // STEP 2: quantize the centers to a cubic 2^21 grid and sort them by their morton code
+    // the grid cells have to be cubes, otherwise the chunks get stretched along the
+    // longest axis of the scene
+    const float gridMax = (float)((1u << 21) - 1);
+    float extent = std::max(std::max(sceneMax[0] - sceneMin[0], sceneMax[1] - sceneMin[1]), sceneMax[2] - sceneMin[2]);
+    float toGrid = extent > 0.0f ? gridMax / extent : 0.0f;
+
+    std::vector<std::pair<uint64_t, uint32_t>> codes(gaussians.size());
+    for (size_t i = 0; i < gaussians.size(); i++) {
+        auto& position = gaussians[i].position;
+        uint32_t cell[3];
+        for (int j = 0; j < 3; j++) {
+            float scaled = (position[j] - sceneMin[j]) * toGrid;
+            cell[j] = (uint32_t)std::min(std::max(scaled, 0.0f), gridMax);
+        }
+        codes[i] = {encodeMortonCode(cell[0], cell[1], cell[2]), (uint32_t)i};
+    }
+    // the index breaks ties, so the result does not depend on the sort implementation
+    std::sort(codes.begin(), codes.end());
+
+    std::vector<Gaussian3D> sorted;
+    sorted.reserve(gaussians.size());
+    for (auto& code : codes) {
+        sorted.push_back(gaussians[code.second]);
+    }
+    gaussians.swap(sorted);
+
+    // STEP 3: cut the curve into chunks and compute their bounds,
+    // the bounds are extended by 3 sigma of the largest scale axis
+    // so that a culled chunk has no visible contribution
+    uint32_t numberGaussians = (uint32_t)gaussians.size();
+    chunks.reserve((numberGaussians + chunkSize - 1) / chunkSize);
+    for (uint32_t first = 0; first < numberGaussians; first += chunkSize) {
+        GaussianChunk chunk;
+        chunk.first = first;
+        chunk.count = std::min(chunkSize, numberGaussians - first);
+        chunk.boundsMin = {std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max()};
+        chunk.boundsMax = {-std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max()};
+
+        for (uint32_t i = first; i < first + chunk.count; i++) {
+            auto& gaussian = gaussians[i];
+            float radius = 3.0f * std::max(std::max(gaussian.scale[0], gaussian.scale[1]), gaussian.scale[2]);
+            for (int j = 0; j < 3; j++) {
+                chunk.boundsMin[j] = std::min(chunk.boundsMin[j], gaussian.position[j] - radius);
+                chunk.boundsMax[j] = std::max(chunk.boundsMax[j], gaussian.position[j] + radius);
+            }
+        }
+
+        // without a hierarchy every chunk is a root and a leaf at the same time
+        float radius = 0.0f;
+        for (int j = 0; j < 3; j++) {
+            chunk.sphere[j] = 0.5f * (chunk.boundsMin[j] + chunk.boundsMax[j]);
+            float halfExtent = 0.5f * (chunk.boundsMax[j] - chunk.boundsMin[j]);
+            radius += halfExtent * halfExtent;
+        }
+        chunk.sphere[3] = std::sqrt(radius);
+        chunk.parentSphere = chunk.sphere;
+        chunk.error = 0.0f;
+        chunk.parentError = std::numeric_limits<float>::infinity();
+
+        chunks.push_back(chunk);
+    }
+
+    return chunks;
+}
+
+} // namespace klartraum
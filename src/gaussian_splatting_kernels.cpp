@@ -0,0 +1,503 @@
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+// only x86-64 guarantees SSE2, 32 bit x86 uses the scalar kernels
+#if defined(__x86_64__) || defined(_M_X64)
+#define KLARTRAUM_KERNELS_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define KLARTRAUM_KERNELS_NEON
+#include <arm_neon.h>
+#endif
+
+#include "klartraum/gaussian_splatting_kernels.hpp"
+
+// gcc and clang only emit avx2 instructions for functions that ask for them,
+// msvc allows the intrinsics everywhere
+#if defined(__GNUC__) || defined(__clang__)
+#define KLARTRAUM_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define KLARTRAUM_TARGET_AVX2
+#endif
+
+namespace klartraum {
+
+namespace {
+
+// constants of the cephes single precision exp approximation, the argument is
+// clamped to [expLo, expHi] and the exponent n to at most expMaxN, since at expHi
+// n rounds to 128, whose exponent field 255 would be +inf, with n = 127 the
+// remaining factor exp(g) <= sqrt(2) keeps the result finite
+const float expHi = 88.3762626647949f;
+const float expLo = -88.3762626647949f;
+const float expMaxN = 127.0f;
+const float log2e = 1.44269504088896341f;
+const float expC1 = 0.693359375f;
+const float expC2 = -2.12194440e-4f;
+const float expP0 = 1.9875691500e-4f;
+const float expP1 = 1.3981999507e-3f;
+const float expP2 = 8.3334519073e-3f;
+const float expP3 = 4.1665795894e-2f;
+const float expP4 = 1.6666665459e-1f;
+const float expP5 = 5.0000001201e-1f;
+
+// scalar kernels, also used for the tails of the vectorized loops
+/////////////////////////////////////////////
+
+void sigmoidScalar(const float* in, float* out, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        out[i] = 1.0f / (1.0f + std::exp(-in[i]));
+    }
+}
+
+void expScalar(const float* in, float* out, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        out[i] = std::exp(in[i]);
+    }
+}
+
+void normalizeQuaternionsScalar(float* x, float* y, float* z, float* w, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        float norm = std::sqrt(x[i] * x[i] + y[i] * y[i] + z[i] * z[i] + w[i] * w[i]);
+        float invNorm = norm > 0.0f ? 1.0f / norm : 0.0f;
+        x[i] *= invNorm;
+        y[i] *= invNorm;
+        z[i] *= invNorm;
+        w[i] *= invNorm;
+    }
+}
+
+void rescaleScalar(const void* in, size_t inStride, float* out, size_t count, float scale) {
+    const uint8_t* src = (const uint8_t*)in;
+    for (size_t i = 0; i < count; i++) {
+        float value;
+        std::memcpy(&value, src + i * inStride, sizeof(float));
+        out[i] = value * scale;
+    }
+}
+
+const GaussianKernels scalarKernels = {
+    KernelIsa::Scalar,
+    sigmoidScalar,
+    expScalar,
+    normalizeQuaternionsScalar,
+    rescaleScalar};
+
+#ifdef KLARTRAUM_KERNELS_X86
+
+// SSE2, available on every x86-64 cpu
+/////////////////////////////////////////////
+
+inline __m128 expSse2(__m128 x) {
+    const __m128 one = _mm_set1_ps(1.0f);
+
+    x = _mm_min_ps(x, _mm_set1_ps(expHi));
+    x = _mm_max_ps(x, _mm_set1_ps(expLo));
+
+    // express exp(x) as exp(g + n * log(2)), n = round(x / log(2))
+    __m128 fx = _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(log2e)), _mm_set1_ps(0.5f));
+    // floor without SSE4.1
+    __m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(fx));
+    __m128 correction = _mm_and_ps(_mm_cmpgt_ps(truncated, fx), one);
+    fx = _mm_sub_ps(truncated, correction);
+    fx = _mm_min_ps(fx, _mm_set1_ps(expMaxN));
+
+    x = _mm_sub_ps(x, _mm_mul_ps(fx, _mm_set1_ps(expC1)));
+    x = _mm_sub_ps(x, _mm_mul_ps(fx, _mm_set1_ps(expC2)));
+
+    __m128 z = _mm_mul_ps(x, x);
+    __m128 y = _mm_set1_ps(expP0);
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(expP1));
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(expP2));
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(expP3));
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(expP4));
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(expP5));
+    y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(y, z), x), one);
+
+    // build 2^n directly in the exponent bits
+    __m128i n = _mm_cvttps_epi32(fx);
+    n = _mm_slli_epi32(_mm_add_epi32(n, _mm_set1_epi32(127)), 23);
+    return _mm_mul_ps(y, _mm_castsi128_ps(n));
+}
+
+void sigmoidSse2(const float* in, float* out, size_t count) {
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 zero = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 x = _mm_loadu_ps(in + i);
+        __m128 e = expSse2(_mm_sub_ps(zero, x));
+        _mm_storeu_ps(out + i, _mm_div_ps(one, _mm_add_ps(one, e)));
+    }
+    sigmoidScalar(in + i, out + i, count - i);
+}
+
+void expSse2(const float* in, float* out, size_t count) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_ps(out + i, expSse2(_mm_loadu_ps(in + i)));
+    }
+    expScalar(in + i, out + i, count - i);
+}
+
+void normalizeQuaternionsSse2(float* x, float* y, float* z, float* w, size_t count) {
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 qx = _mm_loadu_ps(x + i);
+        __m128 qy = _mm_loadu_ps(y + i);
+        __m128 qz = _mm_loadu_ps(z + i);
+        __m128 qw = _mm_loadu_ps(w + i);
+        __m128 norm2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(qx, qx), _mm_mul_ps(qy, qy)),
+                                  _mm_add_ps(_mm_mul_ps(qz, qz), _mm_mul_ps(qw, qw)));
+        // zero length quaternions stay zero
+        __m128 valid = _mm_cmpgt_ps(norm2, zero);
+        __m128 invNorm = _mm_and_ps(_mm_div_ps(one, _mm_sqrt_ps(norm2)), valid);
+        _mm_storeu_ps(x + i, _mm_mul_ps(qx, invNorm));
+        _mm_storeu_ps(y + i, _mm_mul_ps(qy, invNorm));
+        _mm_storeu_ps(z + i, _mm_mul_ps(qz, invNorm));
+        _mm_storeu_ps(w + i, _mm_mul_ps(qw, invNorm));
+    }
+    normalizeQuaternionsScalar(x + i, y + i, z + i, w + i, count - i);
+}
+
+void rescaleSse2(const void* in, size_t inStride, float* out, size_t count, float scale) {
+    const uint8_t* src = (const uint8_t*)in;
+    const __m128 factor = _mm_set1_ps(scale);
+    size_t i = 0;
+    if (inStride == sizeof(float)) {
+        for (; i + 4 <= count; i += 4) {
+            __m128 value = _mm_loadu_ps((const float*)(src + i * inStride));
+            _mm_storeu_ps(out + i, _mm_mul_ps(value, factor));
+        }
+    } else {
+        // no gather instruction in SSE2, at least the scaling and the stores are vectorized
+        for (; i + 4 <= count; i += 4) {
+            float values[4];
+            for (int k = 0; k < 4; k++) {
+                std::memcpy(&values[k], src + (i + k) * inStride, sizeof(float));
+            }
+            _mm_storeu_ps(out + i, _mm_mul_ps(_mm_loadu_ps(values), factor));
+        }
+    }
+    rescaleScalar(src + i * inStride, inStride, out + i, count - i, scale);
+}
+
+const GaussianKernels sse2Kernels = {
+    KernelIsa::SSE2,
+    sigmoidSse2,
+    expSse2,
+    normalizeQuaternionsSse2,
+    rescaleSse2};
+
+// AVX2, chosen at runtime
+/////////////////////////////////////////////
+
+KLARTRAUM_TARGET_AVX2 inline __m256 expAvx2(__m256 x) {
+    const __m256 one = _mm256_set1_ps(1.0f);
+
+    x = _mm256_min_ps(x, _mm256_set1_ps(expHi));
+    x = _mm256_max_ps(x, _mm256_set1_ps(expLo));
+
+    __m256 fx = _mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(log2e)), _mm256_set1_ps(0.5f));
+    fx = _mm256_floor_ps(fx);
+    fx = _mm256_min_ps(fx, _mm256_set1_ps(expMaxN));
+
+    x = _mm256_sub_ps(x, _mm256_mul_ps(fx, _mm256_set1_ps(expC1)));
+    x = _mm256_sub_ps(x, _mm256_mul_ps(fx, _mm256_set1_ps(expC2)));
+
+    __m256 z = _mm256_mul_ps(x, x);
+    __m256 y = _mm256_set1_ps(expP0);
+    y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(expP1));
+    y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(expP2));
+    y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(expP3));
+    y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(expP4));
+    y = _mm256_add_ps(_mm256_mul_ps(y, x), _mm256_set1_ps(expP5));
+    y = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(y, z), x), one);
+
+    __m256i n = _mm256_cvttps_epi32(fx);
+    n = _mm256_slli_epi32(_mm256_add_epi32(n, _mm256_set1_epi32(127)), 23);
+    return _mm256_mul_ps(y, _mm256_castsi256_ps(n));
+}
+
+KLARTRAUM_TARGET_AVX2 void sigmoidAvx2(const float* in, float* out, size_t count) {
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 zero = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 x = _mm256_loadu_ps(in + i);
+        __m256 e = expAvx2(_mm256_sub_ps(zero, x));
+        _mm256_storeu_ps(out + i, _mm256_div_ps(one, _mm256_add_ps(one, e)));
+    }
+    sigmoidSse2(in + i, out + i, count - i);
+}
+
+KLARTRAUM_TARGET_AVX2 void expAvx2(const float* in, float* out, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        _mm256_storeu_ps(out + i, expAvx2(_mm256_loadu_ps(in + i)));
+    }
+    expSse2(in + i, out + i, count - i);
+}
+
+KLARTRAUM_TARGET_AVX2 void normalizeQuaternionsAvx2(float* x, float* y, float* z, float* w, size_t count) {
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 qx = _mm256_loadu_ps(x + i);
+        __m256 qy = _mm256_loadu_ps(y + i);
+        __m256 qz = _mm256_loadu_ps(z + i);
+        __m256 qw = _mm256_loadu_ps(w + i);
+        __m256 norm2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(qx, qx), _mm256_mul_ps(qy, qy)),
+                                     _mm256_add_ps(_mm256_mul_ps(qz, qz), _mm256_mul_ps(qw, qw)));
+        __m256 valid = _mm256_cmp_ps(norm2, zero, _CMP_GT_OQ);
+        __m256 invNorm = _mm256_and_ps(_mm256_div_ps(one, _mm256_sqrt_ps(norm2)), valid);
+        _mm256_storeu_ps(x + i, _mm256_mul_ps(qx, invNorm));
+        _mm256_storeu_ps(y + i, _mm256_mul_ps(qy, invNorm));
+        _mm256_storeu_ps(z + i, _mm256_mul_ps(qz, invNorm));
+        _mm256_storeu_ps(w + i, _mm256_mul_ps(qw, invNorm));
+    }
+    normalizeQuaternionsSse2(x + i, y + i, z + i, w + i, count - i);
+}
+
+KLARTRAUM_TARGET_AVX2 void rescaleAvx2(const void* in, size_t inStride, float* out, size_t count, float scale) {
+    const uint8_t* src = (const uint8_t*)in;
+    const __m256 factor = _mm256_set1_ps(scale);
+    size_t i = 0;
+    if (inStride == sizeof(float)) {
+        for (; i + 8 <= count; i += 8) {
+            __m256 value = _mm256_loadu_ps((const float*)(src + i * inStride));
+            _mm256_storeu_ps(out + i, _mm256_mul_ps(value, factor));
+        }
+    } else if (inStride <= (size_t)INT32_MAX / 8) {
+        // byte offsets of the eight lanes relative to the current element
+        const int32_t stride = (int32_t)inStride;
+        const __m256i offsets = _mm256_setr_epi32(0, stride, 2 * stride, 3 * stride, 4 * stride, 5 * stride, 6 * stride, 7 * stride);
+        for (; i + 8 <= count; i += 8) {
+            __m256 value = _mm256_i32gather_ps((const float*)(src + i * inStride), offsets, 1);
+            _mm256_storeu_ps(out + i, _mm256_mul_ps(value, factor));
+        }
+    }
+    rescaleSse2(src + i * inStride, inStride, out + i, count - i, scale);
+}
+
+const GaussianKernels avx2Kernels = {
+    KernelIsa::AVX2,
+    sigmoidAvx2,
+    expAvx2,
+    normalizeQuaternionsAvx2,
+    rescaleAvx2};
+
+bool cpuSupportsAvx2() {
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx) {
+        return false;
+    }
+    // the os has to save the ymm registers on context switches
+    if ((_xgetbv(0) & 0x6) != 0x6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif // KLARTRAUM_KERNELS_X86
+
+#ifdef KLARTRAUM_KERNELS_NEON
+
+// NEON, part of every aarch64 cpu
+/////////////////////////////////////////////
+
+inline float32x4_t expNeon(float32x4_t x) {
+    const float32x4_t one = vdupq_n_f32(1.0f);
+
+    x = vminq_f32(x, vdupq_n_f32(expHi));
+    x = vmaxq_f32(x, vdupq_n_f32(expLo));
+
+    float32x4_t fx = vmlaq_f32(vdupq_n_f32(0.5f), x, vdupq_n_f32(log2e));
+    fx = vrndmq_f32(fx);
+    fx = vminq_f32(fx, vdupq_n_f32(expMaxN));
+
+    x = vmlsq_f32(x, fx, vdupq_n_f32(expC1));
+    x = vmlsq_f32(x, fx, vdupq_n_f32(expC2));
+
+    float32x4_t z = vmulq_f32(x, x);
+    float32x4_t y = vdupq_n_f32(expP0);
+    y = vmlaq_f32(vdupq_n_f32(expP1), y, x);
+    y = vmlaq_f32(vdupq_n_f32(expP2), y, x);
+    y = vmlaq_f32(vdupq_n_f32(expP3), y, x);
+    y = vmlaq_f32(vdupq_n_f32(expP4), y, x);
+    y = vmlaq_f32(vdupq_n_f32(expP5), y, x);
+    y = vaddq_f32(vmlaq_f32(x, y, z), one);
+
+    int32x4_t n = vcvtq_s32_f32(fx);
+    n = vshlq_n_s32(vaddq_s32(n, vdupq_n_s32(127)), 23);
+    return vmulq_f32(y, vreinterpretq_f32_s32(n));
+}
+
+void sigmoidNeon(const float* in, float* out, size_t count) {
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        float32x4_t e = expNeon(vnegq_f32(vld1q_f32(in + i)));
+        vst1q_f32(out + i, vdivq_f32(one, vaddq_f32(one, e)));
+    }
+    sigmoidScalar(in + i, out + i, count - i);
+}
+
+void expNeon(const float* in, float* out, size_t count) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        vst1q_f32(out + i, expNeon(vld1q_f32(in + i)));
+    }
+    expScalar(in + i, out + i, count - i);
+}
+
+void normalizeQuaternionsNeon(float* x, float* y, float* z, float* w, size_t count) {
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        float32x4_t qx = vld1q_f32(x + i);
+        float32x4_t qy = vld1q_f32(y + i);
+        float32x4_t qz = vld1q_f32(z + i);
+        float32x4_t qw = vld1q_f32(w + i);
+        float32x4_t norm2 = vmulq_f32(qx, qx);
+        norm2 = vmlaq_f32(norm2, qy, qy);
+        norm2 = vmlaq_f32(norm2, qz, qz);
+        norm2 = vmlaq_f32(norm2, qw, qw);
+        uint32x4_t valid = vcgtq_f32(norm2, zero);
+        float32x4_t invNorm = vdivq_f32(one, vsqrtq_f32(norm2));
+        invNorm = vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(invNorm), valid));
+        vst1q_f32(x + i, vmulq_f32(qx, invNorm));
+        vst1q_f32(y + i, vmulq_f32(qy, invNorm));
+        vst1q_f32(z + i, vmulq_f32(qz, invNorm));
+        vst1q_f32(w + i, vmulq_f32(qw, invNorm));
+    }
+    normalizeQuaternionsScalar(x + i, y + i, z + i, w + i, count - i);
+}
+
+void rescaleNeon(const void* in, size_t inStride, float* out, size_t count, float scale) {
+    const uint8_t* src = (const uint8_t*)in;
+    size_t i = 0;
+    if (inStride == sizeof(float)) {
+        for (; i + 4 <= count; i += 4) {
+            float32x4_t value = vreinterpretq_f32_u8(vld1q_u8(src + i * inStride));
+            vst1q_f32(out + i, vmulq_n_f32(value, scale));
+        }
+    } else {
+        for (; i + 4 <= count; i += 4) {
+            float values[4];
+            for (int k = 0; k < 4; k++) {
+                std::memcpy(&values[k], src + (i + k) * inStride, sizeof(float));
+            }
+            vst1q_f32(out + i, vmulq_n_f32(vld1q_f32(values), scale));
+        }
+    }
+    rescaleScalar(src + i * inStride, inStride, out + i, count - i, scale);
+}
+
+const GaussianKernels neonKernels = {
+    KernelIsa::NEON,
+    sigmoidNeon,
+    expNeon,
+    normalizeQuaternionsNeon,
+    rescaleNeon};
+
+#endif // KLARTRAUM_KERNELS_NEON
+
+const GaussianKernels& selectBestKernels() {
+#ifdef KLARTRAUM_KERNELS_X86
+    if (cpuSupportsAvx2()) {
+        return avx2Kernels;
+    }
+    return sse2Kernels;
+#elif defined(KLARTRAUM_KERNELS_NEON)
+    return neonKernels;
+#else
+    return scalarKernels;
+#endif
+}
+
+} // namespace
+
+const char* getKernelIsaName(KernelIsa isa) {
+    switch (isa) {
+    case KernelIsa::Scalar:
+        return "scalar";
+    case KernelIsa::SSE2:
+        return "sse2";
+    case KernelIsa::AVX2:
+        return "avx2";
+    case KernelIsa::NEON:
+        return "neon";
+    }
+    return "unknown";
+}
+
+bool isKernelIsaSupported(KernelIsa isa) {
+    switch (isa) {
+    case KernelIsa::Scalar:
+        return true;
+#ifdef KLARTRAUM_KERNELS_X86
+    case KernelIsa::SSE2:
+        return true;
+    case KernelIsa::AVX2: {
+        static const bool avx2 = cpuSupportsAvx2();
+        return avx2;
+    }
+#endif
+#ifdef KLARTRAUM_KERNELS_NEON
+    case KernelIsa::NEON:
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+const GaussianKernels& getGaussianKernels() {
+    static const GaussianKernels& kernels = selectBestKernels();
+    return kernels;
+}
+
+const GaussianKernels& getGaussianKernels(KernelIsa isa) {
+    if (!isKernelIsaSupported(isa)) {
+        throw std::runtime_error(std::string("kernel instruction set not supported: ") + getKernelIsaName(isa));
+    }
+    switch (isa) {
+#ifdef KLARTRAUM_KERNELS_X86
+    case KernelIsa::SSE2:
+        return sse2Kernels;
+    case KernelIsa::AVX2:
+        return avx2Kernels;
+#endif
+#ifdef KLARTRAUM_KERNELS_NEON
+    case KernelIsa::NEON:
+        return neonKernels;
+#endif
+    default:
+        return scalarKernels;
+    }
+}
+
+} // namespace klartraum
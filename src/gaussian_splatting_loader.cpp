@@ -0,0 +1,516 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "load-spz.h"
+
+#include "klartraum/gaussian_splatting_kernels.hpp"
+#include "klartraum/gaussian_splatting_loader.hpp"
+
+namespace klartraum {
+
+#ifdef _WIN32
+MappedFile::MappedFile(const std::string& path) {
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("failed to open file: " + path);
+    }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize)) {
+        CloseHandle(file);
+        throw std::runtime_error("failed to query file size: " + path);
+    }
+    fileHandle = file;
+    length = (size_t)fileSize.QuadPart;
+    if (length == 0) {
+        return;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr) {
+        CloseHandle(file);
+        throw std::runtime_error("failed to map file: " + path);
+    }
+    mappingHandle = mapping;
+    bytes = (const uint8_t*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (bytes == nullptr) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        throw std::runtime_error("failed to map file: " + path);
+    }
+}
+
+MappedFile::~MappedFile() {
+    if (bytes != nullptr) {
+        UnmapViewOfFile(bytes);
+    }
+    if (mappingHandle != nullptr) {
+        CloseHandle((HANDLE)mappingHandle);
+    }
+    if (fileHandle != nullptr) {
+        CloseHandle((HANDLE)fileHandle);
+    }
+}
+#else
+MappedFile::MappedFile(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("failed to open file: " + path);
+    }
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0) {
+        close(fd);
+        throw std::runtime_error("failed to query file size: " + path);
+    }
+    length = (size_t)fileStat.st_size;
+    if (length == 0) {
+        close(fd);
+        return;
+    }
+
+    void* mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    // the mapping stays valid after closing the descriptor
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error("failed to map file: " + path);
+    }
+    // we read the file front to back exactly once
+    madvise(mapping, length, MADV_SEQUENTIAL);
+    bytes = (const uint8_t*)mapping;
+}
+
+MappedFile::~MappedFile() {
+    if (bytes != nullptr) {
+        munmap((void*)bytes, length);
+    }
+}
+#endif
+
+namespace {
+
+size_t plyTypeSize(PlyType type) {
+    switch (type) {
+    case PlyType::Int8:
+    case PlyType::UInt8:
+        return 1;
+    case PlyType::Int16:
+    case PlyType::UInt16:
+        return 2;
+    case PlyType::Int32:
+    case PlyType::UInt32:
+    case PlyType::Float32:
+        return 4;
+    case PlyType::Float64:
+        return 8;
+    }
+    return 0;
+}
+
+PlyType parsePlyType(const std::string& name) {
+    if (name == "char" || name == "int8") {
+        return PlyType::Int8;
+    }
+    if (name == "uchar" || name == "uint8") {
+        return PlyType::UInt8;
+    }
+    if (name == "short" || name == "int16") {
+        return PlyType::Int16;
+    }
+    if (name == "ushort" || name == "uint16") {
+        return PlyType::UInt16;
+    }
+    if (name == "int" || name == "int32") {
+        return PlyType::Int32;
+    }
+    if (name == "uint" || name == "uint32") {
+        return PlyType::UInt32;
+    }
+    if (name == "float" || name == "float32") {
+        return PlyType::Float32;
+    }
+    if (name == "double" || name == "float64") {
+        return PlyType::Float64;
+    }
+    throw std::runtime_error("unknown PLY property type: " + name);
+}
+
+template <typename T>
+void readColumnAs(const uint8_t* src, size_t stride, size_t count, float* out) {
+    for (size_t i = 0; i < count; i++) {
+        T value;
+        std::memcpy(&value, src + i * stride, sizeof(T));
+        out[i] = (float)value;
+    }
+}
+
+// gathers one property of `count` consecutive vertex records into a float column
+void readColumn(const GaussianKernels& kernels, const uint8_t* records, size_t stride, size_t count, const PlyProperty& property, float* out) {
+    const uint8_t* src = records + property.offset;
+    switch (property.type) {
+    case PlyType::Int8:
+        readColumnAs<int8_t>(src, stride, count, out);
+        break;
+    case PlyType::UInt8:
+        readColumnAs<uint8_t>(src, stride, count, out);
+        break;
+    case PlyType::Int16:
+        readColumnAs<int16_t>(src, stride, count, out);
+        break;
+    case PlyType::UInt16:
+        readColumnAs<uint16_t>(src, stride, count, out);
+        break;
+    case PlyType::Int32:
+        readColumnAs<int32_t>(src, stride, count, out);
+        break;
+    case PlyType::UInt32:
+        readColumnAs<uint32_t>(src, stride, count, out);
+        break;
+    case PlyType::Float32:
+        kernels.rescale(src, stride, out, count, 1.0f);
+        break;
+    case PlyType::Float64:
+        readColumnAs<double>(src, stride, count, out);
+        break;
+    }
+}
+
+const PlyProperty& requireProperty(const PlyHeader& header, const std::string& name) {
+    const PlyProperty* property = header.find(name);
+    if (property == nullptr) {
+        throw std::runtime_error("PLY file is missing the vertex property '" + name + "'!");
+    }
+    return *property;
+}
+
+// number of gaussians that are converted at once, small enough to keep
+// the columns of one block in cache
+const size_t gaussianBlockSize = 16384;
+
+// structure of arrays staging area for one block of gaussians,
+// the loaders fill the columns and the kernels work on them in place
+struct GaussianBlock {
+    GaussianBlock(size_t shPerChannel) : shPerChannel(shPerChannel) {
+        storage.resize((3 + 3 + 4 + 1 + 3 + 3 * shPerChannel) * gaussianBlockSize);
+        float* column = storage.data();
+        auto next = [&]() {
+            float* current = column;
+            column += gaussianBlockSize;
+            return current;
+        };
+        for (int c = 0; c < 3; c++) {
+            position[c] = next();
+            scale[c] = next();
+            color[c] = next();
+            for (size_t k = 0; k < shPerChannel; k++) {
+                sh[c][k] = next();
+            }
+        }
+        for (int c = 0; c < 4; c++) {
+            rotation[c] = next();
+        }
+        alpha = next();
+    }
+
+    std::vector<float> storage;
+    size_t shPerChannel;
+
+    float* position[3];
+    float* scale[3];
+    float* rotation[4]; // x, y, z, w
+    float* color[3];
+    float* alpha;
+    float* sh[3][15];
+};
+
+// use activation functions as done in original implementation and described in the paper
+void activateBlock(const GaussianKernels& kernels, GaussianBlock& block, size_t count) {
+    kernels.sigmoid(block.alpha, block.alpha, count); // inverse logistic back to alpha
+    for (int c = 0; c < 3; c++) {
+        kernels.exp(block.scale[c], block.scale[c], count);
+    }
+    kernels.normalizeQuaternions(block.rotation[0], block.rotation[1], block.rotation[2], block.rotation[3], count);
+}
+
+void appendBlock(const GaussianBlock& block, size_t count, const GaussianLoadOptions& options, std::vector<Gaussian3D>& gaussians) {
+    for (size_t i = 0; i < count; i++) {
+        Gaussian3D gaussian3D = {};
+        for (int c = 0; c < 3; c++) {
+            gaussian3D.position[c] = block.position[c][i];
+        }
+        gaussian3D.alpha = block.alpha[i];
+        if (!options.accepts(gaussian3D.position, gaussian3D.alpha)) {
+            continue;
+        }
+        for (int c = 0; c < 3; c++) {
+            gaussian3D.scale[c] = block.scale[c][i];
+            gaussian3D.color[c] = block.color[c][i];
+        }
+        for (int c = 0; c < 4; c++) {
+            gaussian3D.rotation[c] = block.rotation[c][i];
+        }
+        for (size_t k = 0; k < block.shPerChannel; k++) {
+            gaussian3D.shR[k] = block.sh[0][k][i];
+            gaussian3D.shG[k] = block.sh[1][k][i];
+            gaussian3D.shB[k] = block.sh[2][k][i];
+        }
+        gaussians.push_back(gaussian3D);
+    }
+}
+
+} // namespace
+
+const PlyProperty* PlyHeader::find(const std::string& name) const {
+    for (auto& property : properties) {
+        if (property.name == name) {
+            return &property;
+        }
+    }
+    return nullptr;
+}
+
+PlyHeader parsePlyHeader(const uint8_t* data, size_t size) {
+    const char* text = (const char*)data;
+
+    const char endHeader[] = "end_header";
+    size_t headerEnd = 0;
+    size_t lineStart = 0;
+    bool foundEnd = false;
+    std::vector<std::string> lines;
+    for (size_t i = 0; i < size; i++) {
+        if (text[i] != '\n') {
+            continue;
+        }
+        size_t lineEnd = i;
+        if (lineEnd > lineStart && text[lineEnd - 1] == '\r') {
+            lineEnd--;
+        }
+        lines.emplace_back(text + lineStart, lineEnd - lineStart);
+        lineStart = i + 1;
+        if (lines.back() == endHeader) {
+            headerEnd = lineStart;
+            foundEnd = true;
+            break;
+        }
+    }
+    if (lines.empty() || lines[0] != "ply") {
+        throw std::runtime_error("not a PLY file!");
+    }
+    if (!foundEnd) {
+        throw std::runtime_error("PLY header is not terminated!");
+    }
+
+    PlyHeader header;
+    bool foundFormat = false;
+    bool foundVertex = false;
+    bool inVertex = false;
+    // size of the elements in front of the vertex element
+    size_t precedingBytes = 0;
+    size_t currentCount = 0;
+    size_t currentStride = 0;
+    bool currentHasList = false;
+
+    auto finishElement = [&]() {
+        if (inVertex) {
+            header.vertexStride = currentStride;
+            inVertex = false;
+        } else if (!foundVertex) {
+            if (currentHasList && currentCount > 0) {
+                throw std::runtime_error("PLY list properties in front of the vertex element are not supported!");
+            }
+            precedingBytes += currentCount * currentStride;
+        }
+        currentCount = 0;
+        currentStride = 0;
+        currentHasList = false;
+    };
+
+    for (size_t l = 1; l < lines.size(); l++) {
+        std::istringstream line(lines[l]);
+        std::string keyword;
+        line >> keyword;
+
+        if (keyword == "format") {
+            std::string format;
+            line >> format;
+            if (format != "binary_little_endian") {
+                throw std::runtime_error("only binary_little_endian PLY files are supported, got " + format + "!");
+            }
+            foundFormat = true;
+        } else if (keyword == "element") {
+            finishElement();
+            std::string name;
+            line >> name >> currentCount;
+            if (name == "vertex") {
+                if (foundVertex) {
+                    throw std::runtime_error("PLY file has more than one vertex element!");
+                }
+                foundVertex = true;
+                inVertex = true;
+                header.vertexCount = currentCount;
+            }
+        } else if (keyword == "property") {
+            std::string type;
+            line >> type;
+            if (type == "list") {
+                if (inVertex) {
+                    throw std::runtime_error("PLY list properties in the vertex element are not supported!");
+                }
+                currentHasList = true;
+                continue;
+            }
+            std::string name;
+            line >> name;
+            PlyType plyType = parsePlyType(type);
+            if (inVertex) {
+                header.properties.push_back({name, plyType, currentStride});
+            }
+            currentStride += plyTypeSize(plyType);
+        }
+        // comment, obj_info and end_header need no handling
+    }
+    finishElement();
+
+    if (!foundFormat) {
+        throw std::runtime_error("PLY header has no format line!");
+    }
+    if (!foundVertex) {
+        throw std::runtime_error("PLY file has no vertex element!");
+    }
+
+    header.vertexOffset = headerEnd + precedingBytes;
+    if (header.vertexOffset + header.vertexCount * header.vertexStride > size) {
+        throw std::runtime_error("PLY file is truncated!");
+    }
+    return header;
+}
+
+std::vector<Gaussian3D> loadGaussiansFromPly(const std::string& path, const GaussianLoadOptions& options) {
+    MappedFile file(path);
+    PlyHeader header = parsePlyHeader(file.data(), file.size());
+
+    const PlyProperty* position[3] = {
+        &requireProperty(header, "x"),
+        &requireProperty(header, "y"),
+        &requireProperty(header, "z")};
+    const PlyProperty* scale[3] = {
+        &requireProperty(header, "scale_0"),
+        &requireProperty(header, "scale_1"),
+        &requireProperty(header, "scale_2")};
+    // the reference implementation stores the real part first (w, x, y, z),
+    // Gaussian3D expects (x, y, z, w)
+    const PlyProperty* rotation[4] = {
+        &requireProperty(header, "rot_1"),
+        &requireProperty(header, "rot_2"),
+        &requireProperty(header, "rot_3"),
+        &requireProperty(header, "rot_0")};
+    const PlyProperty& opacity = requireProperty(header, "opacity");
+    const PlyProperty* color[3] = {
+        header.find("f_dc_0"),
+        header.find("f_dc_1"),
+        header.find("f_dc_2")};
+
+    // f_rest_* is stored channel by channel, the number of coefficients depends on the sh degree
+    std::vector<const PlyProperty*> shRest;
+    while (const PlyProperty* property = header.find("f_rest_" + std::to_string(shRest.size()))) {
+        shRest.push_back(property);
+    }
+    const size_t shPerChannel = std::min<size_t>(shRest.size() / 3, 15);
+
+    const GaussianKernels& kernels = getGaussianKernels();
+    GaussianBlock block(shPerChannel);
+
+    std::vector<Gaussian3D> gaussians;
+    gaussians.reserve(header.vertexCount);
+
+    const uint8_t* vertices = file.data() + header.vertexOffset;
+    const size_t stride = header.vertexStride;
+    for (size_t first = 0; first < header.vertexCount; first += gaussianBlockSize) {
+        const size_t count = std::min(gaussianBlockSize, header.vertexCount - first);
+        const uint8_t* records = vertices + first * stride;
+
+        for (int c = 0; c < 3; c++) {
+            readColumn(kernels, records, stride, count, *position[c], block.position[c]);
+            readColumn(kernels, records, stride, count, *scale[c], block.scale[c]);
+            if (color[c] != nullptr) {
+                readColumn(kernels, records, stride, count, *color[c], block.color[c]);
+            } else {
+                std::fill_n(block.color[c], count, 0.0f);
+            }
+            for (size_t k = 0; k < shPerChannel; k++) {
+                // keep the channel major layout, but only the coefficients that fit into Gaussian3D
+                const PlyProperty& property = *shRest[c * (shRest.size() / 3) + k];
+                readColumn(kernels, records, stride, count, property, block.sh[c][k]);
+            }
+        }
+        for (int c = 0; c < 4; c++) {
+            readColumn(kernels, records, stride, count, *rotation[c], block.rotation[c]);
+        }
+        readColumn(kernels, records, stride, count, opacity, block.alpha);
+
+        activateBlock(kernels, block, count);
+        appendBlock(block, count, options, gaussians);
+    }
+
+    return gaussians;
+}
+
+std::vector<Gaussian3D> loadGaussiansFromSpz(const std::string& path, const GaussianLoadOptions& options) {
+    spz::UnpackOptions unpackOptions;
+    spz::GaussianCloud cloud = spz::loadSpz(path, unpackOptions);
+
+    const size_t numPoints = cloud.numPoints > 0 ? (size_t)cloud.numPoints : 0;
+    if (numPoints == 0) {
+        return {};
+    }
+
+    // the cloud stores sh coefficient major with the color channel as the fastest axis
+    const size_t shDim = cloud.sh.size() / (numPoints * 3);
+    const size_t shPerChannel = std::min<size_t>(shDim, 15);
+
+    const GaussianKernels& kernels = getGaussianKernels();
+    GaussianBlock block(shPerChannel);
+
+    std::vector<Gaussian3D> gaussians;
+    gaussians.reserve(numPoints);
+
+    for (size_t first = 0; first < numPoints; first += gaussianBlockSize) {
+        const size_t count = std::min(gaussianBlockSize, numPoints - first);
+
+        for (int c = 0; c < 3; c++) {
+            kernels.rescale(&cloud.positions[first * 3 + c], 3 * sizeof(float), block.position[c], count, 1.0f);
+            kernels.rescale(&cloud.scales[first * 3 + c], 3 * sizeof(float), block.scale[c], count, 1.0f);
+            kernels.rescale(&cloud.colors[first * 3 + c], 3 * sizeof(float), block.color[c], count, 1.0f);
+            for (size_t k = 0; k < shPerChannel; k++) {
+                kernels.rescale(&cloud.sh[(first * shDim + k) * 3 + c], shDim * 3 * sizeof(float), block.sh[c][k], count, 1.0f);
+            }
+        }
+        // spz already uses (x, y, z, w)
+        for (int c = 0; c < 4; c++) {
+            kernels.rescale(&cloud.rotations[first * 4 + c], 4 * sizeof(float), block.rotation[c], count, 1.0f);
+        }
+        kernels.rescale(&cloud.alphas[first], sizeof(float), block.alpha, count, 1.0f);
+
+        activateBlock(kernels, block, count);
+        appendBlock(block, count, options, gaussians);
+    }
+
+    return gaussians;
+}
+
+} // namespace klartraum
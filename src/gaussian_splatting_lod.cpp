@@ -0,0 +1,333 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "klartraum/gaussian_splatting_lod.hpp"
+
+namespace klartraum {
+
+namespace {
+
+// number of children per chunk and number of gaussians merged into one
+const uint32_t branchingFactor = 4;
+
+typedef std::array<double, 9> Matrix3;
+
+double& at(Matrix3& m, int row, int column) {
+    return m[row * 3 + column];
+}
+
+// eigen decomposition of a symmetric 3x3 matrix using cyclic jacobi rotations
+// the eigenvectors are stored in the columns of vectors
+void symmetricEigen(Matrix3 a, std::array<double, 3>& values, Matrix3& vectors) {
+    vectors = {1.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 1.0};
+
+    for (int sweep = 0; sweep < 32; sweep++) {
+        double offDiagonal = std::abs(at(a, 0, 1)) + std::abs(at(a, 0, 2)) + std::abs(at(a, 1, 2));
+        double diagonal = std::abs(at(a, 0, 0)) + std::abs(at(a, 1, 1)) + std::abs(at(a, 2, 2));
+        if (offDiagonal <= 1e-15 * diagonal || offDiagonal == 0.0) {
+            break;
+        }
+
+        for (int p = 0; p < 2; p++) {
+            for (int q = p + 1; q < 3; q++) {
+                double apq = at(a, p, q);
+                if (apq == 0.0) {
+                    continue;
+                }
+                double theta = (at(a, q, q) - at(a, p, p)) / (2.0 * apq);
+                double t = (theta >= 0.0 ? 1.0 : -1.0) / (std::abs(theta) + std::sqrt(theta * theta + 1.0));
+                double c = 1.0 / std::sqrt(t * t + 1.0);
+                double s = t * c;
+
+                // a = J^T a J
+                for (int k = 0; k < 3; k++) {
+                    double akp = at(a, k, p);
+                    double akq = at(a, k, q);
+                    at(a, k, p) = c * akp - s * akq;
+                    at(a, k, q) = s * akp + c * akq;
+                }
+                for (int k = 0; k < 3; k++) {
+                    double apk = at(a, p, k);
+                    double aqk = at(a, q, k);
+                    at(a, p, k) = c * apk - s * aqk;
+                    at(a, q, k) = s * apk + c * aqk;
+                }
+                for (int k = 0; k < 3; k++) {
+                    double vkp = at(vectors, k, p);
+                    double vkq = at(vectors, k, q);
+                    at(vectors, k, p) = c * vkp - s * vkq;
+                    at(vectors, k, q) = s * vkp + c * vkq;
+                }
+            }
+        }
+    }
+
+    for (int i = 0; i < 3; i++) {
+        values[i] = at(a, i, i);
+    }
+}
+
+// quaternion (x, y, z, w) of a proper rotation matrix
+std::array<float, 4> matrixToQuaternion(Matrix3& m) {
+    double trace = at(m, 0, 0) + at(m, 1, 1) + at(m, 2, 2);
+    double x, y, z, w;
+    if (trace > 0.0) {
+        double s = 2.0 * std::sqrt(trace + 1.0);
+        w = 0.25 * s;
+        x = (at(m, 2, 1) - at(m, 1, 2)) / s;
+        y = (at(m, 0, 2) - at(m, 2, 0)) / s;
+        z = (at(m, 1, 0) - at(m, 0, 1)) / s;
+    } else if (at(m, 0, 0) > at(m, 1, 1) && at(m, 0, 0) > at(m, 2, 2)) {
+        double s = 2.0 * std::sqrt(1.0 + at(m, 0, 0) - at(m, 1, 1) - at(m, 2, 2));
+        w = (at(m, 2, 1) - at(m, 1, 2)) / s;
+        x = 0.25 * s;
+        y = (at(m, 0, 1) + at(m, 1, 0)) / s;
+        z = (at(m, 0, 2) + at(m, 2, 0)) / s;
+    } else if (at(m, 1, 1) > at(m, 2, 2)) {
+        double s = 2.0 * std::sqrt(1.0 + at(m, 1, 1) - at(m, 0, 0) - at(m, 2, 2));
+        w = (at(m, 0, 2) - at(m, 2, 0)) / s;
+        x = (at(m, 0, 1) + at(m, 1, 0)) / s;
+        y = 0.25 * s;
+        z = (at(m, 1, 2) + at(m, 2, 1)) / s;
+    } else {
+        double s = 2.0 * std::sqrt(1.0 + at(m, 2, 2) - at(m, 0, 0) - at(m, 1, 1));
+        w = (at(m, 1, 0) - at(m, 0, 1)) / s;
+        x = (at(m, 0, 2) + at(m, 2, 0)) / s;
+        y = (at(m, 1, 2) + at(m, 2, 1)) / s;
+        z = 0.25 * s;
+    }
+    double norm = std::sqrt(x * x + y * y + z * z + w * w);
+    return {(float)(x / norm), (float)(y / norm), (float)(z / norm), (float)(w / norm)};
+}
+
+// proportional to the surface of the ellipsoid, used to weight the gaussians while merging
+float getArea(const Gaussian3D& gaussian) {
+    auto& s = gaussian.scale;
+    return s[0] * s[1] + s[1] * s[2] + s[0] * s[2];
+}
+
+float getRadius(const Gaussian3D& gaussian) {
+    return 3.0f * std::max(std::max(gaussian.scale[0], gaussian.scale[1]), gaussian.scale[2]);
+}
+
+} // namespace
+
+std::array<float, 9> computeCovariance(const Gaussian3D& gaussian) {
+    float x = gaussian.rotation[0], y = gaussian.rotation[1], z = gaussian.rotation[2], w = gaussian.rotation[3];
+    float r[9] = {
+        1.0f - 2.0f * (y * y + z * z), 2.0f * (x * y - w * z), 2.0f * (x * z + w * y),
+        2.0f * (x * y + w * z), 1.0f - 2.0f * (x * x + z * z), 2.0f * (y * z - w * x),
+        2.0f * (x * z - w * y), 2.0f * (y * z + w * x), 1.0f - 2.0f * (x * x + y * y)};
+
+    // R * S^2 * R^T
+    std::array<float, 9> covariance;
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            float sum = 0.0f;
+            for (int k = 0; k < 3; k++) {
+                sum += r[i * 3 + k] * gaussian.scale[k] * gaussian.scale[k] * r[j * 3 + k];
+            }
+            covariance[i * 3 + j] = sum;
+        }
+    }
+    return covariance;
+}
+
+Gaussian3D mergeGaussians(const Gaussian3D* gaussians, size_t count) {
+    if (count == 0) {
+        throw std::runtime_error("cannot merge zero gaussians!");
+    }
+    if (count == 1) {
+        return gaussians[0];
+    }
+
+    std::vector<double> weights(count);
+    double weightSum = 0.0;
+    for (size_t i = 0; i < count; i++) {
+        weights[i] = (double)gaussians[i].alpha * getArea(gaussians[i]);
+        weightSum += weights[i];
+    }
+    if (weightSum <= 0.0) {
+        std::fill(weights.begin(), weights.end(), 1.0);
+        weightSum = (double)count;
+    }
+
+    Gaussian3D merged{};
+
+    // STEP 1: mean
+    std::array<double, 3> mean = {0.0, 0.0, 0.0};
+    for (size_t i = 0; i < count; i++) {
+        for (int j = 0; j < 3; j++) {
+            mean[j] += weights[i] * gaussians[i].position[j];
+        }
+    }
+    for (int j = 0; j < 3; j++) {
+        mean[j] /= weightSum;
+        merged.position[j] = (float)mean[j];
+    }
+
+    // STEP 2: covariance of the mixture, sum_i w_i (cov_i + (mu_i - mu)(mu_i - mu)^T)
+    Matrix3 covariance = {};
+    for (size_t i = 0; i < count; i++) {
+        std::array<float, 9> covarianceI = computeCovariance(gaussians[i]);
+        double d[3];
+        for (int j = 0; j < 3; j++) {
+            d[j] = gaussians[i].position[j] - mean[j];
+        }
+        for (int j = 0; j < 3; j++) {
+            for (int k = 0; k < 3; k++) {
+                covariance[j * 3 + k] += weights[i] * (covarianceI[j * 3 + k] + d[j] * d[k]);
+            }
+        }
+    }
+    for (auto& value : covariance) {
+        value /= weightSum;
+    }
+
+    // STEP 3: back to rotation and scale
+    std::array<double, 3> eigenValues;
+    Matrix3 eigenVectors;
+    symmetricEigen(covariance, eigenValues, eigenVectors);
+
+    // the quaternion has to describe a rotation, not a reflection
+    double determinant =
+        at(eigenVectors, 0, 0) * (at(eigenVectors, 1, 1) * at(eigenVectors, 2, 2) - at(eigenVectors, 1, 2) * at(eigenVectors, 2, 1)) -
+        at(eigenVectors, 0, 1) * (at(eigenVectors, 1, 0) * at(eigenVectors, 2, 2) - at(eigenVectors, 1, 2) * at(eigenVectors, 2, 0)) +
+        at(eigenVectors, 0, 2) * (at(eigenVectors, 1, 0) * at(eigenVectors, 2, 1) - at(eigenVectors, 1, 1) * at(eigenVectors, 2, 0));
+    if (determinant < 0.0) {
+        for (int k = 0; k < 3; k++) {
+            at(eigenVectors, k, 2) = -at(eigenVectors, k, 2);
+        }
+    }
+
+    merged.rotation = matrixToQuaternion(eigenVectors);
+    for (int j = 0; j < 3; j++) {
+        merged.scale[j] = (float)std::sqrt(std::max(eigenValues[j], 1e-12));
+    }
+
+    // STEP 4: opacity, so that the merged gaussian covers about the same area as its parts
+    double coverage = 0.0;
+    for (size_t i = 0; i < count; i++) {
+        coverage += (double)gaussians[i].alpha * getArea(gaussians[i]);
+    }
+    float mergedArea = getArea(merged);
+    merged.alpha = mergedArea > 0.0f ? (float)std::min(1.0, coverage / mergedArea) : gaussians[0].alpha;
+
+    // STEP 5: color and sh coefficients
+    for (size_t i = 0; i < count; i++) {
+        float weight = (float)(weights[i] / weightSum);
+        for (int j = 0; j < 3; j++) {
+            merged.color[j] += weight * gaussians[i].color[j];
+        }
+        for (int j = 0; j < 15; j++) {
+            merged.shR[j] += weight * gaussians[i].shR[j];
+            merged.shG[j] += weight * gaussians[i].shG[j];
+            merged.shB[j] += weight * gaussians[i].shB[j];
+        }
+    }
+
+    return merged;
+}
+
+GaussianHierarchy buildGaussianHierarchy(std::vector<Gaussian3D> gaussians, uint32_t maxLevels, uint32_t chunkSize) {
+    if (maxLevels == 0) {
+        throw std::runtime_error("the hierarchy needs at least one level!");
+    }
+
+    GaussianHierarchy hierarchy;
+
+    // STEP 1: the leaves
+    hierarchy.chunks = partitionIntoChunks(gaussians, chunkSize);
+    hierarchy.gaussians = std::move(gaussians);
+    hierarchy.numberLeafGaussians = (uint32_t)hierarchy.gaussians.size();
+    hierarchy.numberLevels = hierarchy.chunks.empty() ? 0 : 1;
+    hierarchy.parents.assign(hierarchy.chunks.size(), NoParentChunk);
+
+    auto& allGaussians = hierarchy.gaussians;
+    auto& chunks = hierarchy.chunks;
+
+    // STEP 2: merge the levels bottom up until a single chunk is left
+    size_t levelBegin = 0;
+    size_t levelEnd = chunks.size();
+    std::vector<Gaussian3D> group;
+    while (hierarchy.numberLevels < maxLevels && levelEnd - levelBegin > 1) {
+        for (size_t c = levelBegin; c < levelEnd; c += branchingFactor) {
+            size_t childrenEnd = std::min(c + branchingFactor, levelEnd);
+
+            // the children of a chunk are consecutive, and so are their gaussians
+            uint32_t childFirst = chunks[c].first;
+            uint32_t childEnd = chunks[childrenEnd - 1].first + chunks[childrenEnd - 1].count;
+
+            GaussianChunk parent;
+            parent.first = (uint32_t)allGaussians.size();
+            parent.count = 0;
+            parent.boundsMin = chunks[c].boundsMin;
+            parent.boundsMax = chunks[c].boundsMax;
+            parent.error = 0.0f;
+            parent.parentError = std::numeric_limits<float>::infinity();
+
+            for (uint32_t g = childFirst; g < childEnd; g += branchingFactor) {
+                // copy, since allGaussians grows while merging
+                group.assign(allGaussians.begin() + g, allGaussians.begin() + std::min(g + branchingFactor, childEnd));
+                Gaussian3D merged = mergeGaussians(group.data(), group.size());
+
+                float radius = getRadius(merged);
+                for (int j = 0; j < 3; j++) {
+                    parent.boundsMin[j] = std::min(parent.boundsMin[j], merged.position[j] - radius);
+                    parent.boundsMax[j] = std::max(parent.boundsMax[j], merged.position[j] + radius);
+                }
+                // the detail below the size of the merged gaussian is lost
+                parent.error = std::max(parent.error, radius / 3.0f);
+
+                allGaussians.push_back(merged);
+                parent.count++;
+            }
+
+            for (size_t child = c; child < childrenEnd; child++) {
+                for (int j = 0; j < 3; j++) {
+                    parent.boundsMin[j] = std::min(parent.boundsMin[j], chunks[child].boundsMin[j]);
+                    parent.boundsMax[j] = std::max(parent.boundsMax[j], chunks[child].boundsMax[j]);
+                }
+                // the error has to grow monotonically towards the roots
+                parent.error = std::max(parent.error, chunks[child].error);
+            }
+
+            // the parent sphere has to contain the spheres of all children
+            float radius = 0.0f;
+            for (int j = 0; j < 3; j++) {
+                parent.sphere[j] = 0.5f * (parent.boundsMin[j] + parent.boundsMax[j]);
+                float halfExtent = 0.5f * (parent.boundsMax[j] - parent.boundsMin[j]);
+                radius += halfExtent * halfExtent;
+            }
+            radius = std::sqrt(radius);
+            for (size_t child = c; child < childrenEnd; child++) {
+                auto& sphere = chunks[child].sphere;
+                float dx = sphere[0] - parent.sphere[0];
+                float dy = sphere[1] - parent.sphere[1];
+                float dz = sphere[2] - parent.sphere[2];
+                radius = std::max(radius, std::sqrt(dx * dx + dy * dy + dz * dz) + sphere[3]);
+            }
+            parent.sphere[3] = radius;
+            parent.parentSphere = parent.sphere;
+
+            for (size_t child = c; child < childrenEnd; child++) {
+                chunks[child].parentError = parent.error;
+                chunks[child].parentSphere = parent.sphere;
+                hierarchy.parents[child] = (uint32_t)chunks.size();
+            }
+
+            // chunks may reallocate, so the references above are not used after this
+            chunks.push_back(parent);
+            hierarchy.parents.push_back(NoParentChunk);
+        }
+
+        levelBegin = levelEnd;
+        levelEnd = chunks.size();
+        hierarchy.numberLevels++;
+    }
+
+    return hierarchy;
+}
+
+} // namespace klartraum
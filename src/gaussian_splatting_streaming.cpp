@@ -0,0 +1,400 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+#include "klartraum/gaussian_splatting_streaming.hpp"
+
+namespace klartraum {
+
+namespace {
+
+const char pageFileMagic[4] = {'K', 'T', 'P', 'F'};
+const uint32_t pageFileVersion = 1;
+const uint64_t pageFileAlignment = 4096;
+
+// FNV-1a
+void hashBytes(uint64_t& hash, const void* data, size_t size) {
+    const uint8_t* bytes = (const uint8_t*)data;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+}
+
+template <typename T>
+void hashValue(uint64_t& hash, const T& value) {
+    hashBytes(hash, &value, sizeof(T));
+}
+
+} // namespace
+
+uint64_t computeGaussianSourceKey(const std::string& path, const GaussianLoadOptions& loadOptions, uint32_t maxLevels) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+
+    hashBytes(hash, path.data(), path.size());
+    hashValue(hash, (uint64_t)std::filesystem::file_size(path));
+    hashValue(hash, (int64_t)std::filesystem::last_write_time(path).time_since_epoch().count());
+
+    hashValue(hash, loadOptions.crop);
+    hashValue(hash, loadOptions.cropMin);
+    hashValue(hash, loadOptions.cropMax);
+    hashValue(hash, loadOptions.minAlpha);
+    hashValue(hash, maxLevels);
+
+    // the layout of the file depends on these as well
+    hashValue(hash, GaussianChunkSize);
+    hashValue(hash, (uint32_t)sizeof(Gaussian3D));
+    hashValue(hash, (uint32_t)sizeof(GaussianChunk));
+    return hash;
+}
+
+void writeGaussianPageFile(const std::string& path, const GaussianHierarchy& hierarchy, uint64_t sourceKey) {
+    GaussianPageFileHeader header{};
+    std::memcpy(header.magic, pageFileMagic, sizeof(pageFileMagic));
+    header.version = pageFileVersion;
+    header.sourceKey = sourceKey;
+    header.chunkSize = GaussianChunkSize;
+    header.numberLevels = hierarchy.numberLevels;
+    header.numberLeafGaussians = hierarchy.numberLeafGaussians;
+    header.numberChunks = (uint32_t)hierarchy.chunks.size();
+    header.numberGaussians = hierarchy.gaussians.size();
+
+    uint64_t tableEnd = sizeof(header) + hierarchy.chunks.size() * sizeof(GaussianChunk) + hierarchy.parents.size() * sizeof(uint32_t);
+    header.gaussiansOffset = (tableEnd + pageFileAlignment - 1) / pageFileAlignment * pageFileAlignment;
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        throw std::runtime_error("failed to open page file for writing: " + path);
+    }
+    file.write((const char*)&header, sizeof(header));
+    file.write((const char*)hierarchy.chunks.data(), hierarchy.chunks.size() * sizeof(GaussianChunk));
+    file.write((const char*)hierarchy.parents.data(), hierarchy.parents.size() * sizeof(uint32_t));
+    std::vector<char> padding(header.gaussiansOffset - tableEnd, 0);
+    file.write(padding.data(), padding.size());
+    file.write((const char*)hierarchy.gaussians.data(), hierarchy.gaussians.size() * sizeof(Gaussian3D));
+
+    if (!file) {
+        throw std::runtime_error("failed to write page file: " + path);
+    }
+}
+
+bool isGaussianPageFileValid(const std::string& path, uint64_t sourceKey) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    GaussianPageFileHeader header;
+    if (!file.read((char*)&header, sizeof(header))) {
+        return false;
+    }
+    return std::memcmp(header.magic, pageFileMagic, sizeof(pageFileMagic)) == 0 &&
+           header.version == pageFileVersion &&
+           header.sourceKey == sourceKey;
+}
+
+GaussianPageFile::GaussianPageFile(const std::string& path) : file(path) {
+    if (file.size() < sizeof(header)) {
+        throw std::runtime_error("page file is too small: " + path);
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, pageFileMagic, sizeof(pageFileMagic)) != 0 || header.version != pageFileVersion) {
+        throw std::runtime_error("not a page file of this version: " + path);
+    }
+    if (header.chunkSize != GaussianChunkSize) {
+        throw std::runtime_error("page file was written with a different chunk size: " + path);
+    }
+
+    uint64_t tableEnd = sizeof(header) + (uint64_t)header.numberChunks * (sizeof(GaussianChunk) + sizeof(uint32_t));
+    if (tableEnd > header.gaussiansOffset || header.gaussiansOffset + header.numberGaussians * sizeof(Gaussian3D) > file.size()) {
+        throw std::runtime_error("page file is truncated: " + path);
+    }
+
+    const uint8_t* data = file.data() + sizeof(header);
+    chunks.resize(header.numberChunks);
+    std::memcpy(chunks.data(), data, chunks.size() * sizeof(GaussianChunk));
+    data += chunks.size() * sizeof(GaussianChunk);
+    parents.resize(header.numberChunks);
+    std::memcpy(parents.data(), data, parents.size() * sizeof(uint32_t));
+
+    gaussians = (const Gaussian3D*)(file.data() + header.gaussiansOffset);
+}
+
+GaussianResidencyManager::GaussianResidencyManager(
+    const Gaussian3D* gaussians,
+    const std::vector<GaussianChunk>& chunks,
+    const std::vector<uint32_t>& parents,
+    uint32_t framesInFlight,
+    const GaussianStreamingOptions& options,
+    UploadFunction upload) : gaussians(gaussians),
+                             chunks(chunks),
+                             framesInFlight(framesInFlight),
+                             options(options),
+                             upload(upload) {
+    uint32_t numberChunks = (uint32_t)chunks.size();
+    if (parents.size() != numberChunks) {
+        throw std::runtime_error("every chunk needs a parent entry!");
+    }
+
+    children.resize(numberChunks);
+    std::vector<uint32_t> roots;
+    for (uint32_t chunk = 0; chunk < numberChunks; chunk++) {
+        if (parents[chunk] == NoParentChunk) {
+            roots.push_back(chunk);
+        } else {
+            children[parents[chunk]].push_back(chunk);
+        }
+    }
+
+    pageTable.assign(numberChunks, NotResident);
+    lastUsed.assign(numberChunks, 0);
+    loading.assign(numberChunks, false);
+
+    if (roots.size() > this->options.poolPages) {
+        throw std::runtime_error("the page pool is too small for the roots of the hierarchy!");
+    }
+    for (uint32_t page = this->options.poolPages; page > 0; page--) {
+        freePages.push_back(page - 1);
+    }
+
+    for (uint32_t root : roots) {
+        uint32_t page = freePages.back();
+        freePages.pop_back();
+        this->upload(page, gaussians + chunks[root].first, chunks[root].count);
+        pageTable[root] = page;
+    }
+
+    // everything fits, so load the whole hierarchy top down and do not stream at all
+    if (numberChunks <= this->options.poolPages) {
+        for (uint32_t chunk = numberChunks; chunk > 0; chunk--) {
+            // parents are stored behind their children, so this visits them first
+            uint32_t parent = chunk - 1;
+            if (!children[parent].empty()) {
+                LoadedGroup group = readGroup(parent);
+                uploadGroup(group);
+            }
+        }
+    } else {
+        worker = std::thread(&GaussianResidencyManager::work, this);
+    }
+    pageTableVersion++;
+}
+
+GaussianResidencyManager::~GaussianResidencyManager() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    condition.notify_all();
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+uint32_t GaussianResidencyManager::getNumberResidentChunks() const {
+    return (uint32_t)std::count_if(pageTable.begin(), pageTable.end(), [](uint32_t entry) { return entry != NotResident; });
+}
+
+void GaussianResidencyManager::waitForLoads() {
+    std::unique_lock<std::mutex> lock(mutex);
+    loadedCondition.wait(lock, [this]() { return loaded.size() + pendingUploads.size() == loadsInFlight; });
+}
+
+void GaussianResidencyManager::work() {
+    while (true) {
+        uint32_t parent;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [this]() { return stop || !requests.empty(); });
+            if (stop) {
+                return;
+            }
+            parent = requests.front();
+            requests.pop_front();
+        }
+
+        // this is where the pages of the mapped file are actually read
+        LoadedGroup group = readGroup(parent);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            loaded.push_back(std::move(group));
+        }
+        loadedCondition.notify_all();
+    }
+}
+
+GaussianResidencyManager::LoadedGroup GaussianResidencyManager::readGroup(uint32_t parent) const {
+    // siblings are consecutive chunks, and so are their gaussians
+    auto& first = chunks[children[parent].front()];
+    auto& last = chunks[children[parent].back()];
+
+    LoadedGroup group;
+    group.parent = parent;
+    group.gaussians.assign(gaussians + first.first, gaussians + last.first + last.count);
+    return group;
+}
+
+void GaussianResidencyManager::update(const uint32_t* feedback, const std::array<float, 3>& cameraPosition) {
+    frame++;
+
+    // pages evicted a while ago are no longer referenced by any frame in flight
+    while (!retiredPages.empty() && retiredPages.front().first + framesInFlight < frame) {
+        freePages.push_back(retiredPages.front().second);
+        retiredPages.pop_front();
+    }
+
+    if (feedback != nullptr) {
+        for (size_t chunk = 0; chunk < chunks.size(); chunk++) {
+            if (feedback[chunk] & FeedbackUsed) {
+                lastUsed[chunk] = frame;
+            }
+        }
+    }
+
+    if (!worker.joinable()) {
+        return; // everything is resident
+    }
+
+    requestRefinements(feedback, cameraPosition);
+    uploadGroups();
+}
+
+void GaussianResidencyManager::requestRefinements(const uint32_t* feedback, const std::array<float, 3>& cameraPosition) {
+    if (feedback == nullptr || loadsInFlight >= options.maxLoadsInFlight) {
+        return;
+    }
+
+    // closest to the camera first
+    std::vector<std::pair<float, uint32_t>> candidates;
+    for (uint32_t chunk = 0; chunk < (uint32_t)chunks.size(); chunk++) {
+        if ((feedback[chunk] & FeedbackRefine) == 0 || children[chunk].empty() || loading[chunk]) {
+            continue;
+        }
+        uint32_t entry = pageTable[chunk];
+        if (entry == NotResident || (entry & ChildrenResidentBit) != 0) {
+            continue;
+        }
+        auto& sphere = chunks[chunk].sphere;
+        float dx = sphere[0] - cameraPosition[0];
+        float dy = sphere[1] - cameraPosition[1];
+        float dz = sphere[2] - cameraPosition[2];
+        float distance = std::max(std::sqrt(dx * dx + dy * dy + dz * dz) - sphere[3], 0.0f);
+        candidates.emplace_back(distance, chunk);
+    }
+    std::sort(candidates.begin(), candidates.end());
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto& candidate : candidates) {
+            if (loadsInFlight >= options.maxLoadsInFlight) {
+                break;
+            }
+            loading[candidate.second] = true;
+            loadsInFlight++;
+            requests.push_back(candidate.second);
+        }
+    }
+    condition.notify_all();
+}
+
+void GaussianResidencyManager::uploadGroups() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        while (!loaded.empty()) {
+            pendingUploads.push_back(std::move(loaded.front()));
+            loaded.pop_front();
+        }
+    }
+
+    for (uint32_t i = 0; i < options.maxUploadsPerFrame && !pendingUploads.empty(); i++) {
+        LoadedGroup& group = pendingUploads.front();
+        uint32_t needed = (uint32_t)children[group.parent].size();
+
+        // evicted pages only become free after a few frames,
+        // so evict as long as that is not enough
+        while (freePages.size() + retiredPages.size() < needed) {
+            if (!evictLeastRecentlyUsed()) {
+                break;
+            }
+        }
+
+        if (freePages.size() >= needed) {
+            uploadGroup(group);
+        } else if (freePages.size() + retiredPages.size() >= needed) {
+            break; // wait for the retired pages
+        } else {
+            // everything resident is in use, try again once the feedback asks for it
+            loading[group.parent] = false;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        pendingUploads.pop_front();
+        loadsInFlight--;
+    }
+    loadedCondition.notify_all();
+}
+
+bool GaussianResidencyManager::uploadGroup(LoadedGroup& group) {
+    auto& siblings = children[group.parent];
+    if (freePages.size() < siblings.size()) {
+        return false;
+    }
+
+    uint32_t groupFirst = chunks[siblings.front()].first;
+    for (uint32_t chunk : siblings) {
+        uint32_t page = freePages.back();
+        freePages.pop_back();
+        upload(page, group.gaussians.data() + (chunks[chunk].first - groupFirst), chunks[chunk].count);
+        pageTable[chunk] = page;
+        lastUsed[chunk] = frame;
+    }
+    pageTable[group.parent] |= ChildrenResidentBit;
+    loading[group.parent] = false;
+    residentGroups.push_back(group.parent);
+    pageTableVersion++;
+    return true;
+}
+
+bool GaussianResidencyManager::evictLeastRecentlyUsed() {
+    // only groups without resident or loading children can be evicted,
+    // and not while they are still rendered by a frame in flight
+    size_t victim = residentGroups.size();
+    uint64_t victimLastUsed = 0;
+    for (size_t i = 0; i < residentGroups.size(); i++) {
+        bool evictable = true;
+        uint64_t groupLastUsed = 0;
+        for (uint32_t chunk : children[residentGroups[i]]) {
+            if ((pageTable[chunk] & ChildrenResidentBit) != 0 || loading[chunk]) {
+                evictable = false;
+                break;
+            }
+            groupLastUsed = std::max(groupLastUsed, lastUsed[chunk]);
+        }
+        if (!evictable || groupLastUsed + framesInFlight >= frame) {
+            continue;
+        }
+        if (victim == residentGroups.size() || groupLastUsed < victimLastUsed) {
+            victim = i;
+            victimLastUsed = groupLastUsed;
+        }
+    }
+    if (victim == residentGroups.size()) {
+        return false;
+    }
+
+    uint32_t parent = residentGroups[victim];
+    for (uint32_t chunk : children[parent]) {
+        retiredPages.emplace_back(frame, pageTable[chunk]);
+        pageTable[chunk] = NotResident;
+    }
+    pageTable[parent] &= ~ChildrenResidentBit;
+    residentGroups[victim] = residentGroups.back();
+    residentGroups.pop_back();
+    pageTableVersion++;
+    return true;
+}
+
+} // namespace klartraum
@@ -0,0 +1,297 @@
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+#include "klartraum/computegraph/computegraph.hpp"
+#include "klartraum/gaussian_splatting_tuning.hpp"
+
+namespace klartraum {
+
+static std::string toHex(const DeviceUUID& deviceUUID) {
+    std::ostringstream stream;
+    for (uint8_t byte : deviceUUID) {
+        stream << std::hex << std::setw(2) << std::setfill('0') << (uint32_t)byte;
+    }
+    return stream.str();
+}
+
+bool loadTunedKernelConstants(const std::string& path, const DeviceUUID& deviceUUID, GaussianKernelConstants& constants) {
+    if (path.empty()) {
+        return false;
+    }
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    std::string key = toHex(deviceUUID);
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::istringstream stream(line);
+        std::string lineKey;
+        GaussianKernelConstants lineConstants;
+        if (!(stream >> lineKey >> lineConstants.projectionGroupSize >> lineConstants.sortGroupSize >> lineConstants.splatTileSize)) {
+            continue; // e.g. written by a version with other constants
+        }
+        if (lineKey == key) {
+            constants = lineConstants;
+            return true;
+        }
+    }
+    return false;
+}
+
+void saveTunedKernelConstants(const std::string& path, const DeviceUUID& deviceUUID, const GaussianKernelConstants& constants) {
+    if (path.empty()) {
+        throw std::runtime_error("no path for the tuned kernel constants!");
+    }
+
+    std::string key = toHex(deviceUUID);
+
+    // the entries of the other devices are kept
+    std::vector<std::string> lines;
+    {
+        std::ifstream file(path);
+        std::string line;
+        while (std::getline(file, line)) {
+            if (line.empty() || line[0] == '#' || line.compare(0, key.size() + 1, key + " ") == 0) {
+                continue;
+            }
+            lines.push_back(line);
+        }
+    }
+
+    std::ostringstream entry;
+    entry << key << " " << constants.projectionGroupSize << " " << constants.sortGroupSize << " " << constants.splatTileSize;
+    lines.push_back(entry.str());
+
+    // written to a temporary file first, like the pipeline cache
+    std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream file(tmpPath, std::ios::trunc);
+        if (!file.is_open()) {
+            throw std::runtime_error("failed to write the tuned kernel constants!");
+        }
+        file << "# device uuid, projection group size, sort group size, splat tile size" << std::endl;
+        for (auto& line : lines) {
+            file << line << std::endl;
+        }
+    }
+    std::remove(path.c_str());
+    std::rename(tmpPath.c_str(), path.c_str());
+}
+
+GaussianKernelTuner::GaussianKernelTuner(VulkanContext& vulkanContext, const GaussianKernelTuningOptions& options) : vulkanContext(vulkanContext), options(options) {
+    auto& device = vulkanContext.getDevice();
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(vulkanContext.physicalDevice, &properties);
+
+    uint32_t queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(vulkanContext.physicalDevice, &queueFamilyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(vulkanContext.physicalDevice, &queueFamilyCount, queueFamilies.data());
+
+    uint32_t queueFamily = vulkanContext.getQueueFamilyIndices().graphicsAndComputeFamily.value();
+    if (properties.limits.timestampPeriod == 0.0f || queueFamilies[queueFamily].timestampValidBits == 0) {
+        throw std::runtime_error("the device does not support timestamps!");
+    }
+    timestampPeriod = properties.limits.timestampPeriod;
+
+    VkQueryPoolCreateInfo queryPoolInfo{};
+    queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    queryPoolInfo.queryCount = 2;
+
+    if (vkCreateQueryPool(device, &queryPoolInfo, nullptr, &queryPool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create timestamp query pool!");
+    }
+
+    VkCommandPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.queueFamilyIndex = queueFamily;
+
+    if (vkCreateCommandPool(device, &poolInfo, nullptr, &commandPool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create command pool!");
+    }
+
+    VkCommandBufferAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.commandPool = commandPool;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = 1;
+
+    if (vkAllocateCommandBuffers(device, &allocInfo, &beginCommandBuffer) != VK_SUCCESS ||
+        vkAllocateCommandBuffers(device, &allocInfo, &endCommandBuffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate timestamp command buffers!");
+    }
+
+    // recorded once, every frame is waited for before the next one is submitted
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+
+    vkBeginCommandBuffer(beginCommandBuffer, &beginInfo);
+    vkCmdResetQueryPool(beginCommandBuffer, queryPool, 0, 2);
+    vkCmdWriteTimestamp(beginCommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool, 0);
+    if (vkEndCommandBuffer(beginCommandBuffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to record timestamp command buffer!");
+    }
+
+    // waits for all commands submitted before, i.e. the whole graph
+    vkBeginCommandBuffer(endCommandBuffer, &beginInfo);
+    vkCmdWriteTimestamp(endCommandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool, 1);
+    if (vkEndCommandBuffer(endCommandBuffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to record timestamp command buffer!");
+    }
+
+    VkFenceCreateInfo fenceInfo{};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+    if (vkCreateFence(device, &fenceInfo, nullptr, &fence) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create fence!");
+    }
+}
+
+GaussianKernelTuner::~GaussianKernelTuner() {
+    auto& device = vulkanContext.getDevice();
+    vkDestroyFence(device, fence, nullptr);
+    vkDestroyCommandPool(device, commandPool, nullptr);
+    vkDestroyQueryPool(device, queryPool, nullptr);
+}
+
+std::vector<GaussianKernelConstants> GaussianKernelTuner::getCandidates() const {
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(vulkanContext.physicalDevice, &properties);
+    auto& limits = properties.limits;
+
+    // the splatting keeps one Splat2D per thread and a counter in shared memory
+    const uint32_t bytesPerSplat = (uint32_t)sizeof(Splat2D);
+    const uint32_t sharedBytes = (uint32_t)sizeof(uint32_t);
+
+    auto fitsGroup = [&](uint32_t sizeX, uint32_t sizeY) {
+        return sizeX > 0 && sizeY > 0 &&
+            sizeX <= limits.maxComputeWorkGroupSize[0] &&
+            sizeY <= limits.maxComputeWorkGroupSize[1] &&
+            sizeX * sizeY <= limits.maxComputeWorkGroupInvocations;
+    };
+
+    std::vector<GaussianKernelConstants> candidates;
+    for (uint32_t projectionGroupSize : options.projectionGroupSizes) {
+        for (uint32_t sortGroupSize : options.sortGroupSizes) {
+            for (uint32_t splatTileSize : options.splatTileSizes) {
+                if (!fitsGroup(projectionGroupSize, 1) || !fitsGroup(sortGroupSize, 1) || sortGroupSize < 16) {
+                    continue;
+                }
+                if (!fitsGroup(splatTileSize, splatTileSize) ||
+                    splatTileSize * splatTileSize * bytesPerSplat + sharedBytes > limits.maxComputeSharedMemorySize) {
+                    continue;
+                }
+                candidates.push_back({projectionGroupSize, sortGroupSize, splatTileSize});
+            }
+        }
+    }
+    return candidates;
+}
+
+GaussianKernelConstants GaussianKernelTuner::tune(
+    std::shared_ptr<ImageViewSrc> imageViewSrc,
+    std::shared_ptr<CameraUboType> cameraUBO,
+    const std::string& path,
+    const GaussianSplattingOptions& splattingOptions) {
+
+    std::vector<GaussianKernelConstants> candidates = getCandidates();
+    if (candidates.empty()) {
+        throw std::runtime_error("no kernel constants fit the limits of the device!");
+    }
+
+    results.clear();
+    for (auto& candidate : candidates) {
+        GaussianSplattingOptions candidateOptions = splattingOptions;
+        candidateOptions.kernels = candidate;
+        float gpuTime = measure(imageViewSrc, cameraUBO, path, candidateOptions);
+        results.push_back({candidate, gpuTime});
+
+        std::cout << "kernel constants " << candidate.projectionGroupSize << " " << candidate.sortGroupSize << " "
+                  << candidate.splatTileSize << ": " << gpuTime << " ms" << std::endl;
+    }
+
+    auto best = std::min_element(results.begin(), results.end(), [](const GaussianKernelTuningResult& a, const GaussianKernelTuningResult& b) {
+        return a.gpuTime < b.gpuTime;
+    });
+
+    auto& tuningPath = vulkanContext.getConfig().KERNEL_TUNING_PATH;
+    if (!tuningPath.empty()) {
+        saveTunedKernelConstants(tuningPath, vulkanContext.getDeviceUUID(), best->constants);
+    }
+    return best->constants;
+}
+
+float GaussianKernelTuner::measure(
+    std::shared_ptr<ImageViewSrc> imageViewSrc,
+    std::shared_ptr<CameraUboType> cameraUBO,
+    const std::string& path,
+    GaussianSplattingOptions splattingOptions) {
+
+    auto& device = vulkanContext.getDevice();
+    auto& queue = vulkanContext.getGraphicsQueue();
+
+    // the candidate is measured, not the constants tuned before
+    splattingOptions.useTunedKernels = false;
+    // the camera does not move, the temporal sort would only measure the fix-up passes
+    splattingOptions.sort.temporal = false;
+    auto splatting = std::make_shared<VulkanGaussianSplatting>(vulkanContext, imageViewSrc, cameraUBO, path, splattingOptions);
+
+    ComputeGraph graph(vulkanContext, 1);
+    graph.compileFrom(splatting);
+
+    std::vector<float> gpuTimes;
+    for (uint32_t frame = 0; frame < options.warmupFrames + options.measuredFrames; frame++) {
+        // the begin timestamp is written in the first submission of the graph
+        VkSemaphore finishSemaphore = graph.submitTo(queue, 0, VK_NULL_HANDLE, beginCommandBuffer);
+
+        VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+        VkSubmitInfo endInfo{};
+        endInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        endInfo.waitSemaphoreCount = 1;
+        endInfo.pWaitSemaphores = &finishSemaphore;
+        endInfo.pWaitDstStageMask = &waitStage;
+        endInfo.commandBufferCount = 1;
+        endInfo.pCommandBuffers = &endCommandBuffer;
+        if (vkQueueSubmit(queue, 1, &endInfo, fence) != VK_SUCCESS) {
+            throw std::runtime_error("failed to submit timestamp!");
+        }
+
+        if (vkWaitForFences(device, 1, &fence, VK_TRUE, UINT64_MAX) != VK_SUCCESS) {
+            throw std::runtime_error("failed to wait for fence!");
+        }
+        vkResetFences(device, 1, &fence);
+
+        if (frame < options.warmupFrames) {
+            continue;
+        }
+
+        uint64_t timestamps[2] = {0, 0};
+        if (vkGetQueryPoolResults(device, queryPool, 0, 2, sizeof(timestamps), timestamps, sizeof(uint64_t),
+                VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT) != VK_SUCCESS) {
+            throw std::runtime_error("failed to read timestamps!");
+        }
+        gpuTimes.push_back((float)((double)(timestamps[1] - timestamps[0]) * timestampPeriod / 1e6));
+    }
+
+    if (gpuTimes.empty()) {
+        throw std::runtime_error("no frames to measure!");
+    }
+
+    // the median is robust against frames disturbed by other work on the gpu
+    std::nth_element(gpuTimes.begin(), gpuTimes.begin() + gpuTimes.size() / 2, gpuTimes.end());
+    return gpuTimes[gpuTimes.size() / 2];
+}
+
+} // namespace klartraum
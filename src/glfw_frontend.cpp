@@ -10,7 +10,7 @@
 namespace klartraum {
 
 
-GlfwFrontend::GlfwFrontend() : old_mouse_x(0), old_mouse_y(0)
+GlfwFrontend::GlfwFrontend(const BackendConfig& config) : old_mouse_x(0), old_mouse_y(0)
 {
     // GLFW needs to be initialized before Vulkan
     // which is done in the core afterwards
@@ -19,6 +19,7 @@ GlfwFrontend::GlfwFrontend() : old_mouse_x(0), old_mouse_y(0)
     }
 
     klartraumEngine = std::make_unique<KlartraumEngine>();
+    klartraumEngine->getVulkanContext().getConfig() = config;
 
     initialize();
 }
@@ -38,6 +39,12 @@ static void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
     scrollYAccum += yoffset;
 }
 
+static void framebuffer_size_callback(GLFWwindow* window, int width, int height)
+{
+    auto frontend = static_cast<GlfwFrontend*>(glfwGetWindowUserPointer(window));
+    frontend->getKlartraumEngine().getVulkanContext().setWindowExtent({(uint32_t)width, (uint32_t)height});
+}
+
 static void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods)
 {
     auto frontend = static_cast<GlfwFrontend*>(glfwGetWindowUserPointer(window));
@@ -48,7 +55,7 @@ void GlfwFrontend::initialize() {
     // Initialize the glfw window
 
     glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-    glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+    glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
     
     // TODO window size should be configurable somewhere else
     auto config = klartraumEngine->getVulkanContext().getConfig();
@@ -59,6 +66,7 @@ void GlfwFrontend::initialize() {
     // set GLFW event callbacks
     glfwSetScrollCallback(window, scroll_callback);
     glfwSetKeyCallback(window, key_callback);
+    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
 
     auto instance = klartraumEngine->getVulkanContext().getInstance();
 
@@ -68,6 +76,11 @@ void GlfwFrontend::initialize() {
         throw std::runtime_error("failed to create window surface!");
     }
 
+    // the size of the swapchain, if the surface does not define it
+    int width, height;
+    glfwGetFramebufferSize(window, &width, &height);
+    klartraumEngine->getVulkanContext().setWindowExtent({(uint32_t)width, (uint32_t)height});
+
     klartraumEngine->getVulkanContext().initialize(surface);
 }
 
@@ -77,6 +90,14 @@ void GlfwFrontend::loop() {
     while (!glfwWindowShouldClose(window)) {
         glfwPollEvents();
 
+        // no swapchain can be created while the window is minimized
+        int width, height;
+        glfwGetFramebufferSize(window, &width, &height);
+        if (width == 0 || height == 0) {
+            glfwWaitEvents();
+            continue;
+        }
+
         processGLFWEvents();
 
         klartraumEngine->step();
@@ -3,6 +3,8 @@
 
 #include "klartraum/klartraum_core.hpp"
 
+#include <array>
+
 #include "klartraum/computegraph/computegraph.hpp"
 #include "klartraum/computegraph/imageviewsrc.hpp"
 #include "klartraum/computegraph/renderpass.hpp"
@@ -21,7 +23,15 @@ KlartraumEngine::~KlartraumEngine() {
 void KlartraumEngine::step() {
 
     // start frame rendering
-    auto [imageIndex, semaphore] = vulkanContext.beginRender();
+    auto [imageIndex, imageAvailableSemaphore] = vulkanContext.beginRender();
+
+    // the paths of the graphs are the frames in flight, the previous
+    // submission of the path has finished when beginRender returns
+    uint32_t pathId = vulkanContext.getCurrentFrame();
+
+    updateSwapChainImages();
+
+    updateDynamicResolution();
 
     // process event queue,
     // this currently only updates the camera
@@ -34,14 +44,23 @@ void KlartraumEngine::step() {
         }
         
         interfaceCamera->update(cameraUBO->ubo);
-        cameraUBO->update(imageIndex);
+        cameraUBO->update(pathId);
     }
 
     auto& graphicsQueue = vulkanContext.getGraphicsQueue();
 
+    // the begin timestamp is written in the first submission of the frame's work
+    VkCommandBuffer timestampCommandBuffer = computeGraphs.empty() ? VK_NULL_HANDLE : vulkanContext.beginTimestamp();
+
     VkSemaphore renderFinishedSemaphore;
     for(auto &computeGraph : computeGraphs) {
-        renderFinishedSemaphore = computeGraph.submitTo(graphicsQueue, imageIndex);
+        renderFinishedSemaphore = computeGraph.submitTo(graphicsQueue, pathId, VK_NULL_HANDLE, timestampCommandBuffer);
+        timestampCommandBuffer = VK_NULL_HANDLE;
+    }
+
+    // copy the frame image of the path to the acquired swapchain image
+    if (frameImage != nullptr) {
+        renderFinishedSemaphore = submitFrameCopy(pathId, imageIndex, renderFinishedSemaphore, imageAvailableSemaphore);
     }
 
     // finish frame rendering
@@ -68,36 +87,264 @@ VulkanContext& KlartraumEngine::getVulkanContext()
 
 void KlartraumEngine::add(ComputeGraphElementPtr element)
 {
-    computeGraphs.emplace_back(vulkanContext, 3);
+    // the paths of the graph are the frames in flight, so the buffers of the elements
+    // are not replicated for every swapchain image, see FrameImage
+    computeGraphs.emplace_back(vulkanContext, (uint32_t)vulkanContext.getConfig().MAX_FRAMES_IN_FLIGHT);
     auto& computeGraph = computeGraphs.back();
+    // if neither the camera nor the scene changed, the images rendered before are
+    // presented again, which needs the offscreen frame images, since the content of a
+    // swapchain image is undefined once it was presented
+    computeGraph.setSkipUnchanged(frameImage != nullptr);
     computeGraph.compileFrom(element);
+
+    // the frame images are created by the graph
+    if (frameImage != nullptr) {
+        recordFrameCopies();
+    }
 }
 
-RenderPassPtr KlartraumEngine::createRenderPass()
+void KlartraumEngine::clearComputeGraphs()
 {
-    std::vector<VkImageView> imageViews;
-    std::vector<VkImage> images;
-    std::vector<VkSemaphore> imageAvailableSemaphores;
+    auto& device = vulkanContext.getDevice();
+    if (!frameCopyCommandBuffers.empty()) {
+        vkFreeCommandBuffers(device, vulkanContext.commandPool, (uint32_t)frameCopyCommandBuffers.size(), frameCopyCommandBuffers.data());
+        frameCopyCommandBuffers.clear();
+    }
+    for (auto semaphore : frameCopySemaphores) {
+        vkDestroySemaphore(device, semaphore, nullptr);
+    }
+    frameCopySemaphores.clear();
+
+    frameImage = nullptr;
+    computeGraphs.clear();
+}
 
-    for (int i = 0; i < 3; i++) {
-        imageViews.push_back(vulkanContext.getImageView(i));
-        images.push_back(vulkanContext.getSwapChainImage(i));
-        imageAvailableSemaphores.push_back(vulkanContext.imageAvailableSemaphoresPerImage[i]);
+void KlartraumEngine::setDynamicResolution(std::shared_ptr<ScaledImage> image, const DynamicResolutionOptions& options)
+{
+    dynamicResolutionImage = image;
+    dynamicResolutionOptions = options;
+    averageGpuFrameTime = 0.0f;
+    framesSinceScaleChange = 0;
+    image->setScale(options.maxScale);
+}
+
+void KlartraumEngine::updateDynamicResolution()
+{
+    if (dynamicResolutionImage == nullptr) {
+        return;
+    }
+    // 0 if no timestamps are available
+    float frameTime = vulkanContext.getGpuFrameTime();
+    if (frameTime <= 0.0f) {
+        return;
     }
 
-    auto imageViewSrc = std::make_shared<ImageViewSrc>(imageViews, images);
+    // frames rendered before the last change do not count
+    framesSinceScaleChange++;
+    if (framesSinceScaleChange <= vulkanContext.getConfig().MAX_FRAMES_IN_FLIGHT) {
+        return;
+    }
+    averageGpuFrameTime = averageGpuFrameTime == 0.0f ? frameTime : 0.9f * averageGpuFrameTime + 0.1f * frameTime;
 
-    imageViewSrc->setWaitFor(0, imageAvailableSemaphores[0]);
-    imageViewSrc->setWaitFor(1, imageAvailableSemaphores[1]);
-    imageViewSrc->setWaitFor(2, imageAvailableSemaphores[2]);
+    auto& options = dynamicResolutionOptions;
+    float scale = dynamicResolutionImage->getScale();
+    float newScale = scale;
+    if (averageGpuFrameTime > options.targetFrameTime || frameTime > 1.5f * options.targetFrameTime) {
+        // react to load spikes right away
+        newScale = std::max(options.minScale, scale - options.scaleStep);
+    } else if (framesSinceScaleChange > options.increaseDelayFrames) {
+        // the cost of the splatting grows with the number of pixels,
+        // only increase the scale if the larger one is expected to stay below the target
+        float largerScale = std::min(options.maxScale, scale + options.scaleStep);
+        float expectedFrameTime = averageGpuFrameTime * (largerScale * largerScale) / (scale * scale);
+        if (expectedFrameTime < 0.9f * options.targetFrameTime) {
+            newScale = largerScale;
+        }
+    }
 
-    auto camera = std::make_shared<CameraUboType>();
+    if (newScale != scale) {
+        dynamicResolutionImage->setScale(newScale);
+        averageGpuFrameTime = 0.0f;
+        framesSinceScaleChange = 0;
+    }
+}
+
+void KlartraumEngine::updateSwapChainImages()
+{
+    if (frameImage == nullptr || swapChainVersion == vulkanContext.getSwapChainVersion()) {
+        return;
+    }
+    swapChainVersion = vulkanContext.getSwapChainVersion();
+
+    // the device is idle after the swapchain was recreated, only the elements depending
+    // on the frame images (framebuffers, descriptor sets) and on their extent
+    // (e.g. the sizes of the splatting) are updated by the graphs
+    frameImage->resize(vulkanContext.getSwapChainExtent());
+    recordFrameCopies();
+}
+
+void KlartraumEngine::recordFrameCopies()
+{
+    auto& device = vulkanContext.getDevice();
+    uint32_t numberFrames = (uint32_t)vulkanContext.getConfig().MAX_FRAMES_IN_FLIGHT;
+    uint32_t numberImages = vulkanContext.getSwapChainImageCount();
+
+    // the command buffers might still be in use
+    vkQueueWaitIdle(vulkanContext.getGraphicsQueue());
+
+    if (frameCopySemaphores.empty()) {
+        VkSemaphoreCreateInfo semaphoreInfo{};
+        semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+        frameCopySemaphores.resize(numberFrames);
+        for (auto& semaphore : frameCopySemaphores) {
+            if (vkCreateSemaphore(device, &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS) {
+                throw std::runtime_error("failed to create frame copy semaphore!");
+            }
+        }
+    }
+
+    if (frameCopyCommandBuffers.empty()) {
+        frameCopyCommandBuffers.resize(numberFrames * numberImages);
+
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool = vulkanContext.commandPool;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandBufferCount = (uint32_t)frameCopyCommandBuffers.size();
+
+        if (vkAllocateCommandBuffers(device, &allocInfo, frameCopyCommandBuffers.data()) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate frame copy command buffers!");
+        }
+    }
+
+    VkExtent2D extent = frameImage->getExtent();
+
+    // one command buffer for every combination of frame image and swapchain image
+    for (uint32_t pathId = 0; pathId < numberFrames; pathId++) {
+        for (uint32_t imageIndex = 0; imageIndex < numberImages; imageIndex++) {
+            VkCommandBuffer commandBuffer = frameCopyCommandBuffers[pathId * numberImages + imageIndex];
+            vkResetCommandBuffer(commandBuffer, 0);
+
+            VkCommandBufferBeginInfo beginInfo{};
+            beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+
+            if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+                throw std::runtime_error("failed to begin recording command buffer!");
+            }
+
+            // the graph leaves the frame image ready for presentation, the writes are
+            // made visible by the semaphore the submission waits for
+            std::array<VkImageMemoryBarrier, 2> barriers{};
+            for (auto& barrier : barriers) {
+                barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+                barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+                barrier.subresourceRange.baseMipLevel = 0;
+                barrier.subresourceRange.levelCount = 1;
+                barrier.subresourceRange.baseArrayLayer = 0;
+                barrier.subresourceRange.layerCount = 1;
+            }
+            barriers[0].oldLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+            barriers[0].newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+            barriers[0].image = frameImage->getImage(pathId);
+            barriers[0].srcAccessMask = 0;
+            barriers[0].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+            barriers[1].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            barriers[1].newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            barriers[1].image = vulkanContext.getSwapChainImage(imageIndex);
+            barriers[1].srcAccessMask = 0;
+            barriers[1].dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+            vkCmdPipelineBarrier(
+                commandBuffer,
+                VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_PIPELINE_STAGE_TRANSFER_BIT,
+                0,
+                0, nullptr,
+                0, nullptr,
+                (uint32_t)barriers.size(), barriers.data());
+
+            VkImageCopy region{};
+            region.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            region.srcSubresource.layerCount = 1;
+            region.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            region.dstSubresource.layerCount = 1;
+            region.extent = {extent.width, extent.height, 1};
+
+            vkCmdCopyImage(
+                commandBuffer,
+                frameImage->getImage(pathId), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                vulkanContext.getSwapChainImage(imageIndex), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                1, &region);
+
+            // the frame image goes back to the layout the graph leaves it in, it is
+            // copied again without rendering if the graph skips the unchanged elements
+            barriers[0].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+            barriers[0].newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+            barriers[0].srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+            barriers[0].dstAccessMask = 0;
+
+            barriers[1].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            barriers[1].newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+            barriers[1].srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barriers[1].dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
 
+            vkCmdPipelineBarrier(
+                commandBuffer,
+                VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                0,
+                0, nullptr,
+                0, nullptr,
+                (uint32_t)barriers.size(), barriers.data());
+
+            if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+                throw std::runtime_error("failed to record command buffer!");
+            }
+        }
+    }
+}
+
+VkSemaphore KlartraumEngine::submitFrameCopy(uint32_t pathId, uint32_t imageIndex, VkSemaphore renderFinishedSemaphore, VkSemaphore imageAvailableSemaphore)
+{
+    std::array<VkSemaphore, 2> waitSemaphores = {renderFinishedSemaphore, imageAvailableSemaphore};
+    std::array<VkPipelineStageFlags, 2> waitStages = {VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT};
+
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.waitSemaphoreCount = (uint32_t)waitSemaphores.size();
+    submitInfo.pWaitSemaphores = waitSemaphores.data();
+    submitInfo.pWaitDstStageMask = waitStages.data();
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &frameCopyCommandBuffers[pathId * vulkanContext.getSwapChainImageCount() + imageIndex];
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.pSignalSemaphores = &frameCopySemaphores[pathId];
+
+    if (vkQueueSubmit(vulkanContext.getGraphicsQueue(), 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
+        throw std::runtime_error("failed to submit frame copy!");
+    }
+    return frameCopySemaphores[pathId];
+}
+
+RenderPassPtr KlartraumEngine::createRenderPass()
+{
     auto swapChainImageFormat = vulkanContext.getSwapChainImageFormat();
     auto swapChainExtent = vulkanContext.getSwapChainExtent();
+
+    // the graph renders to an image per frame in flight, which is copied
+    // to the swapchain image, it is replaced whenever the swapchain is recreated
+    frameImage = std::make_shared<FrameImage>(swapChainImageFormat, swapChainExtent);
+    frameImage->setName("FrameImage");
+    swapChainVersion = vulkanContext.getSwapChainVersion();
+
+    auto camera = std::make_shared<CameraUboType>();
+
     auto renderpass = std::make_shared<RenderPass>(swapChainImageFormat, swapChainExtent);
 
-    renderpass->setInput(imageViewSrc, 0);
+    renderpass->setInput(frameImage, 0);
     renderpass->setInput(camera, 1);
 
     return renderpass;
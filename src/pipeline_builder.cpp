@@ -0,0 +1,124 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include "klartraum/embedded_shaders.hpp"
+#include "klartraum/pipeline_builder.hpp"
+#include "klartraum/vulkan_helpers.hpp"
+
+namespace klartraum {
+
+void PipelineBuilder::initialize(VkDevice device, VkPipelineCache pipelineCache, ThreadPool& threadPool) {
+    this->device = device;
+    this->pipelineCache = pipelineCache;
+    this->threadPool = &threadPool;
+}
+
+void PipelineBuilder::addComputePipeline(const std::string& shaderPath, VkPipelineLayout layout, VkPipeline* pipeline,
+    const SpecializationConstants& specializationConstants) {
+    *pipeline = VK_NULL_HANDLE;
+    if (deferDepth > 0) {
+        pendingRequests.push_back({shaderPath, layout, pipeline, specializationConstants});
+        return;
+    }
+    createPipelines({{shaderPath, layout, pipeline, specializationConstants}});
+}
+
+void PipelineBuilder::defer() {
+    deferDepth++;
+}
+
+void PipelineBuilder::build() {
+    if (deferDepth == 0) {
+        throw std::runtime_error("build without defer!");
+    }
+    if (--deferDepth > 0) {
+        return;
+    }
+    std::vector<Request> requests;
+    requests.swap(pendingRequests);
+    createPipelines(requests);
+}
+
+void PipelineBuilder::discard() {
+    if (deferDepth == 0) {
+        throw std::runtime_error("discard without defer!");
+    }
+    if (--deferDepth == 0) {
+        pendingRequests.clear();
+    }
+}
+
+std::shared_ptr<const std::vector<char>> PipelineBuilder::getShaderCode(const std::string& shaderPath) {
+    std::lock_guard<std::mutex> lock(shaderCodesMutex);
+    auto& code = shaderCodes[shaderPath];
+    if (code == nullptr) {
+        // the shaders of the library are compiled into it,
+        // only other shaders are read from the working directory
+        const EmbeddedShader* embedded = findEmbeddedShader(shaderPath);
+        if (embedded != nullptr) {
+            code = std::make_shared<const std::vector<char>>(embedded->code, embedded->code + embedded->size);
+        } else {
+            code = std::make_shared<const std::vector<char>>(readFile(shaderPath));
+        }
+    }
+    return code;
+}
+
+void PipelineBuilder::createPipelines(const std::vector<Request>& requests) {
+    if (requests.empty()) {
+        return;
+    }
+
+    // one shader module per shader, shared by all pipelines using it
+    std::vector<std::string> shaderPaths;
+    for (auto& request : requests) {
+        if (std::find(shaderPaths.begin(), shaderPaths.end(), request.shaderPath) == shaderPaths.end()) {
+            shaderPaths.push_back(request.shaderPath);
+        }
+    }
+
+    std::vector<VkShaderModule> shaderModules(shaderPaths.size(), VK_NULL_HANDLE);
+    auto destroyShaderModules = [&]() {
+        for (auto& shaderModule : shaderModules) {
+            vkDestroyShaderModule(device, shaderModule, nullptr);
+        }
+    };
+
+    try {
+        threadPool->parallelFor(shaderPaths.size(), [&](size_t i) {
+            shaderModules[i] = createShaderModule(*getShaderCode(shaderPaths[i]), device);
+        });
+
+        threadPool->parallelFor(requests.size(), [&](size_t i) {
+            auto& request = requests[i];
+            size_t moduleIndex = std::find(shaderPaths.begin(), shaderPaths.end(), request.shaderPath) - shaderPaths.begin();
+
+            VkPipelineShaderStageCreateInfo computeShaderStageInfo{};
+            computeShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+            computeShaderStageInfo.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+            computeShaderStageInfo.module = shaderModules[moduleIndex];
+            computeShaderStageInfo.pName = "main";
+
+            VkSpecializationInfo specializationInfo = request.specializationConstants.getInfo();
+            if (!request.specializationConstants.empty()) {
+                computeShaderStageInfo.pSpecializationInfo = &specializationInfo;
+            }
+
+            VkComputePipelineCreateInfo pipelineInfo{};
+            pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+            pipelineInfo.layout = request.layout;
+            pipelineInfo.stage = computeShaderStageInfo;
+
+            if (vkCreateComputePipelines(device, pipelineCache, 1, &pipelineInfo, nullptr, request.pipeline) != VK_SUCCESS) {
+                throw std::runtime_error("failed to create compute pipeline!");
+            }
+        });
+    } catch (...) {
+        destroyShaderModules();
+        throw;
+    }
+
+    destroyShaderModules();
+}
+
+} // namespace klartraum
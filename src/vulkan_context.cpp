@@ -1,3 +1,7 @@
+#include <cstring>
+#include <cstdio>
+#include <fstream>
+
 #include <vulkan/vulkan.h>
 
 #include "klartraum/vulkan_context.hpp"
@@ -250,12 +254,20 @@ VkSurfaceFormatKHR VulkanContext::chooseSwapSurfaceFormat(const std::vector<VkSu
 }
 
 VkPresentModeKHR VulkanContext::chooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes) {
+    VkPresentModeKHR requestedPresentMode = VK_PRESENT_MODE_FIFO_KHR;
+    switch (config.PRESENT_MODE) {
+        case PresentMode::Mailbox: requestedPresentMode = VK_PRESENT_MODE_MAILBOX_KHR; break;
+        case PresentMode::Immediate: requestedPresentMode = VK_PRESENT_MODE_IMMEDIATE_KHR; break;
+        case PresentMode::Fifo: requestedPresentMode = VK_PRESENT_MODE_FIFO_KHR; break;
+    }
+
     for (const auto& availablePresentMode : availablePresentModes) {
-        if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR) {
+        if (availablePresentMode == requestedPresentMode) {
             return availablePresentMode;
         }
     }
 
+    // fifo is always supported
     return VK_PRESENT_MODE_FIFO_KHR;
 }
 
@@ -264,19 +276,17 @@ VkExtent2D VulkanContext::chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capab
         return capabilities.currentExtent;
     }
     else {
-        throw std::runtime_error("Not implemented / Failed to choose swap extent!");
-        /*int width, height;
-        glfwGetFramebufferSize(window, &width, &height);
+        // the surface takes the size of the swapchain, the frontend tells the size of the window
+        if (windowExtent.width == 0 || windowExtent.height == 0) {
+            throw std::runtime_error("Failed to choose swap extent, window extent not set!");
+        }
 
-        VkExtent2D actualExtent = {
-            static_cast<uint32_t>(width),
-            static_cast<uint32_t>(height)
-        };
+        VkExtent2D actualExtent = windowExtent;
 
         actualExtent.width = std::clamp(actualExtent.width, capabilities.minImageExtent.width, capabilities.maxImageExtent.width);
         actualExtent.height = std::clamp(actualExtent.height, capabilities.minImageExtent.height, capabilities.maxImageExtent.height);
 
-        return actualExtent;*/
+        return actualExtent;
     }
 }
 
@@ -288,6 +298,13 @@ void VulkanContext::createSwapChain() {
     VkExtent2D extent = chooseSwapExtent(swapChainSupport.capabilities);
 
     uint32_t imageCount = swapChainSupport.capabilities.minImageCount + 1;
+    if (config.SWAPCHAIN_IMAGE_COUNT > 0) {
+        imageCount = std::max(config.SWAPCHAIN_IMAGE_COUNT, swapChainSupport.capabilities.minImageCount);
+    }
+    // a maximum of 0 means there is no limit
+    if (swapChainSupport.capabilities.maxImageCount > 0) {
+        imageCount = std::min(imageCount, swapChainSupport.capabilities.maxImageCount);
+    }
 
     VkSwapchainCreateInfoKHR createInfo{};
     createInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
@@ -298,7 +315,7 @@ void VulkanContext::createSwapChain() {
     createInfo.imageColorSpace = surfaceFormat.colorSpace;
     createInfo.imageExtent = extent;
     createInfo.imageArrayLayers = 1;
-    createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_STORAGE_BIT;
+    createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
 
     QueueFamilyIndices indices = findQueueFamilies(physicalDevice);
     uint32_t queueFamilyIndices[] = { indices.graphicsAndComputeFamily.value(), indices.presentFamily.value() };
@@ -321,19 +338,61 @@ void VulkanContext::createSwapChain() {
     createInfo.presentMode = presentMode;
     createInfo.clipped = VK_TRUE;
 
-    createInfo.oldSwapchain = VK_NULL_HANDLE;
+    // VK_NULL_HANDLE when the swapchain is created the first time
+    createInfo.oldSwapchain = swapChain;
 
     if (vkCreateSwapchainKHR(device, &createInfo, nullptr, &swapChain) != VK_SUCCESS) {
         throw std::runtime_error("failed to create swap chain!");
     }
 
     vkGetSwapchainImagesKHR(device, swapChain, &imageCount, nullptr);
+    // the semaphores per image and the paths of the compute graphs depend on the number of images
+    if (!swapChainImages.empty() && imageCount != swapChainImages.size()) {
+        throw std::runtime_error("number of swap chain images changed!");
+    }
     swapChainImages.resize(imageCount);
     vkGetSwapchainImagesKHR(device, swapChain, &imageCount, swapChainImages.data());
 
     swapChainImageFormat = surfaceFormat.format;
     swapChainExtent = extent;
+    swapChainOutdated = false;
+
+}
+
+void VulkanContext::setWindowExtent(VkExtent2D extent) {
+    if (extent.width != windowExtent.width || extent.height != windowExtent.height) {
+        windowExtent = extent;
+        swapChainOutdated = true;
+    }
+}
+
+bool VulkanContext::recreateSwapChain() {
+    // a minimized window has no size, the swapchain stays out of date until it is restored
+    VkSurfaceCapabilitiesKHR capabilities;
+    vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physicalDevice, surface, &capabilities);
+    VkExtent2D extent = capabilities.currentExtent.width != std::numeric_limits<uint32_t>::max() ? capabilities.currentExtent : windowExtent;
+    if (extent.width == 0 || extent.height == 0) {
+        swapChainOutdated = true;
+        return false;
+    }
+
+    // the image views might still be used by submitted command buffers
+    vkDeviceWaitIdle(device);
+
+    for (auto imageView : swapChainImageViews) {
+        vkDestroyImageView(device, imageView, nullptr);
+    }
 
+    // images of the old swapchain that are still presented are
+    // handed over to the new one, which is created with oldSwapchain
+    VkSwapchainKHR oldSwapChain = swapChain;
+    createSwapChain();
+    vkDestroySwapchainKHR(device, oldSwapChain, nullptr);
+
+    createImageViews();
+
+    swapChainVersion++;
+    return true;
 }
 
 void VulkanContext::createImageViews() {
@@ -406,6 +465,14 @@ void VulkanContext::pickPhysicalDevice() {
     if (physicalDevice == VK_NULL_HANDLE) {
         throw std::runtime_error("failed to find a suitable GPU!");
     }
+
+    VkPhysicalDeviceIDProperties idProperties{};
+    idProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES;
+    VkPhysicalDeviceProperties2 properties{};
+    properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+    properties.pNext = &idProperties;
+    vkGetPhysicalDeviceProperties2(physicalDevice, &properties);
+    memcpy(deviceUUID.data(), idProperties.deviceUUID, VK_UUID_SIZE);
 }
 
 void VulkanContext::createLogicalDevice() {
@@ -444,6 +511,28 @@ void VulkanContext::createLogicalDevice() {
 
     createInfo.pNext = &scalarBlockLayoutFeatures;
 
+    // buffer device addresses are core since vulkan 1.2, but optional for the device
+    VkPhysicalDeviceBufferDeviceAddressFeatures bufferDeviceAddressFeatures{};
+    bufferDeviceAddressFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_BUFFER_DEVICE_ADDRESS_FEATURES;
+    bufferDeviceAddressEnabled = false;
+    if (config.BUFFER_DEVICE_ADDRESS) {
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+        if (properties.apiVersion >= VK_API_VERSION_1_2) {
+            VkPhysicalDeviceFeatures2 features{};
+            features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+            features.pNext = &bufferDeviceAddressFeatures;
+            vkGetPhysicalDeviceFeatures2(physicalDevice, &features);
+            bufferDeviceAddressEnabled = bufferDeviceAddressFeatures.bufferDeviceAddress == VK_TRUE;
+        }
+    }
+    if (bufferDeviceAddressEnabled) {
+        bufferDeviceAddressFeatures.pNext = nullptr;
+        bufferDeviceAddressFeatures.bufferDeviceAddressCaptureReplay = VK_FALSE;
+        bufferDeviceAddressFeatures.bufferDeviceAddressMultiDevice = VK_FALSE;
+        scalarBlockLayoutFeatures.pNext = &bufferDeviceAddressFeatures;
+    }
+
 
     if (vkCreateDevice(physicalDevice, &createInfo, nullptr, &device) != VK_SUCCESS) {
         throw std::runtime_error("failed to create logical device!");
@@ -467,13 +556,20 @@ void VulkanContext::initialize(VkSurfaceKHR& surface) {
 
     this->surface = surface;
 
+    if (config.MAX_FRAMES_IN_FLIGHT == 0) {
+        throw std::runtime_error("at least one frame in flight is required!");
+    }
+
     pickPhysicalDevice();
     createLogicalDevice();
     createSwapChain();
     createImageViews();
     
     createCommandPool();
+    createPipelineCache();
+    descriptorAllocator.initialize(device);
     createSyncObjects();
+    createTimestampQueries();
 
     state = State::INITIALIZED;
 
@@ -486,7 +582,16 @@ void VulkanContext::shutdown() {
 
     stopRender();
 
+    if (timestampQueryPool != VK_NULL_HANDLE) {
+        vkDestroyQueryPool(device, timestampQueryPool, nullptr);
+    }
+
     vkDestroyCommandPool(device, commandPool, nullptr);
+
+    savePipelineCache();
+    vkDestroyPipelineCache(device, pipelineCache, nullptr);
+
+    descriptorAllocator.destroy();
     
     for (size_t i = 0; i < config.MAX_FRAMES_IN_FLIGHT; i++)
     {
@@ -563,6 +668,11 @@ VkImage& VulkanContext::getSwapChainImage(uint32_t imageIndex)
     return swapChainImages[imageIndex];
 }
 
+uint32_t VulkanContext::getSwapChainImageCount() const
+{
+    return (uint32_t)swapChainImages.size();
+}
+
 VkExtent2D& VulkanContext::getSwapChainExtent()
 {
     return swapChainExtent;
@@ -587,6 +697,13 @@ void VulkanContext::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, Vk
     bufferInfo.usage = usage;
     bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
+    // buffers shaders can access get an address, see getBufferDeviceAddress
+    bool addressable = bufferDeviceAddressEnabled &&
+        (usage & (VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT)) != 0;
+    if (addressable) {
+        bufferInfo.usage |= VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+    }
+
     if (vkCreateBuffer(device, &bufferInfo, nullptr, &buffer) != VK_SUCCESS) {
         throw std::runtime_error("failed to create buffer!");
     }
@@ -599,6 +716,13 @@ void VulkanContext::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, Vk
     allocInfo.allocationSize = memRequirements.size;
     allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
 
+    VkMemoryAllocateFlagsInfo allocFlagsInfo{};
+    allocFlagsInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO;
+    allocFlagsInfo.flags = VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT;
+    if (addressable) {
+        allocInfo.pNext = &allocFlagsInfo;
+    }
+
     if (vkAllocateMemory(device, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS) {
         throw std::runtime_error("failed to allocate buffer memory!");
     }
@@ -606,6 +730,16 @@ void VulkanContext::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, Vk
     vkBindBufferMemory(device, buffer, bufferMemory, 0);
 }
 
+VkDeviceAddress VulkanContext::getBufferDeviceAddress(VkBuffer buffer) {
+    if (!bufferDeviceAddressEnabled) {
+        throw std::runtime_error("buffer device addresses are not enabled!");
+    }
+    VkBufferDeviceAddressInfo addressInfo{};
+    addressInfo.sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO;
+    addressInfo.buffer = buffer;
+    return vkGetBufferDeviceAddress(device, &addressInfo);
+}
+
 BackendConfig& VulkanContext::getConfig()
 {
     return config;
@@ -677,16 +811,30 @@ std::tuple<uint32_t, VkSemaphore&> VulkanContext::beginRender() {
         }
     }
 
-    if (vkResetFences(device, 1, &fence) != VK_SUCCESS) {
-        throw std::runtime_error("failed to reset inFlightFence");
-    }
+    // the frame that used this slot before has finished
+    readTimestampQueries();
 
     uint32_t imageIndex;
     VkResult acquireResult = vkAcquireNextImageKHR(device, swapChain, one_second, imageAvailableSemaphoresPerFrame[currentFrame], VK_NULL_HANDLE, &imageIndex);
-    if (acquireResult != VK_SUCCESS) {
+    while (acquireResult == VK_ERROR_OUT_OF_DATE_KHR) {
+        // the semaphore is not signaled, acquire again from the new swapchain
+        if (!recreateSwapChain()) {
+            throw std::runtime_error("swap chain out of date and window has no size!");
+        }
+        acquireResult = vkAcquireNextImageKHR(device, swapChain, one_second, imageAvailableSemaphoresPerFrame[currentFrame], VK_NULL_HANDLE, &imageIndex);
+    }
+    if (acquireResult == VK_SUBOPTIMAL_KHR) {
+        // the image can still be presented, the swapchain is recreated after the frame
+        swapChainOutdated = true;
+    } else if (acquireResult != VK_SUCCESS) {
         throw std::runtime_error("failed to acquire swap chain image!");
     }
 
+    // reset the fence only if the frame is rendered, otherwise nothing would signal it
+    if (vkResetFences(device, 1, &fence) != VK_SUCCESS) {
+        throw std::runtime_error("failed to reset inFlightFence");
+    }
+
     VkSubmitInfo submitInfo{};
     submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
     submitInfo.waitSemaphoreCount = 1;
@@ -720,6 +868,13 @@ void VulkanContext::endRender(uint32_t imageIndex, VkSemaphore& renderFinishedSe
     submitInfo.pSignalSemaphores = &renderEndSemaphores[currentFrame];
     submitInfo.commandBufferCount = 0;
     submitInfo.pCommandBuffers = nullptr;
+    // the submission waits for the frame's work, so the end timestamp is written after it
+    if (timestampQueryPool != VK_NULL_HANDLE && timestampsBegun[currentFrame]) {
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &timestampEndCommandBuffers[currentFrame];
+        timestampsBegun[currentFrame] = false;
+        timestampsWritten[currentFrame] = true;
+    }
 
     if (vkQueueSubmit(graphicsQueue, 1, &submitInfo, inFlightFences[currentFrame]) != VK_SUCCESS) {
         throw std::runtime_error("failed to submit inFlightFence");
@@ -739,11 +894,23 @@ void VulkanContext::endRender(uint32_t imageIndex, VkSemaphore& renderFinishedSe
     presentInfo.pResults = nullptr; // Optional
 
     VkResult presentResult = vkQueuePresentKHR(presentQueue, &presentInfo);
-    if (presentResult != VK_SUCCESS) {
+    if (presentResult != VK_SUCCESS && presentResult != VK_SUBOPTIMAL_KHR && presentResult != VK_ERROR_OUT_OF_DATE_KHR) {
         throw std::runtime_error("failed to present swap chain image!");
     }
 
     currentFrame = (currentFrame + 1) % config.MAX_FRAMES_IN_FLIGHT;
+
+    if (presentResult != VK_SUCCESS || swapChainOutdated) {
+        recreateSwapChain();
+    }
+}
+
+VkCommandBuffer VulkanContext::beginTimestamp() {
+    if (timestampQueryPool == VK_NULL_HANDLE) {
+        return VK_NULL_HANDLE;
+    }
+    timestampsBegun[currentFrame] = true;
+    return timestampBeginCommandBuffers[currentFrame];
 }
 
 void VulkanContext::stopRender() {
@@ -753,6 +920,81 @@ void VulkanContext::stopRender() {
     }
 }
 
+void VulkanContext::createTimestampQueries() {
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+    uint32_t queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilies.data());
+
+    uint32_t queueFamily = getQueueFamilyIndices().graphicsAndComputeFamily.value();
+    if (properties.limits.timestampPeriod == 0.0f || queueFamilies[queueFamily].timestampValidBits == 0) {
+        // no timestamps, getGpuFrameTime stays 0
+        return;
+    }
+    timestampPeriod = properties.limits.timestampPeriod;
+
+    VkQueryPoolCreateInfo queryPoolInfo{};
+    queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    queryPoolInfo.queryCount = (uint32_t)(2 * config.MAX_FRAMES_IN_FLIGHT);
+
+    if (vkCreateQueryPool(device, &queryPoolInfo, nullptr, &timestampQueryPool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create timestamp query pool!");
+    }
+
+    timestampBeginCommandBuffers.resize(config.MAX_FRAMES_IN_FLIGHT);
+    timestampEndCommandBuffers.resize(config.MAX_FRAMES_IN_FLIGHT);
+    timestampsBegun.assign(config.MAX_FRAMES_IN_FLIGHT, false);
+    timestampsWritten.assign(config.MAX_FRAMES_IN_FLIGHT, false);
+
+    VkCommandBufferAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.commandPool = commandPool;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = (uint32_t)config.MAX_FRAMES_IN_FLIGHT;
+
+    if (vkAllocateCommandBuffers(device, &allocInfo, timestampBeginCommandBuffers.data()) != VK_SUCCESS ||
+        vkAllocateCommandBuffers(device, &allocInfo, timestampEndCommandBuffers.data()) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate timestamp command buffers!");
+    }
+
+    // the command buffers are recorded once, the in flight fences
+    // guarantee that they are not in use when submitted again
+    for (uint32_t i = 0; i < config.MAX_FRAMES_IN_FLIGHT; i++) {
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+
+        vkBeginCommandBuffer(timestampBeginCommandBuffers[i], &beginInfo);
+        vkCmdResetQueryPool(timestampBeginCommandBuffers[i], timestampQueryPool, 2 * i, 2);
+        vkCmdWriteTimestamp(timestampBeginCommandBuffers[i], VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestampQueryPool, 2 * i);
+        if (vkEndCommandBuffer(timestampBeginCommandBuffers[i]) != VK_SUCCESS) {
+            throw std::runtime_error("failed to record timestamp command buffer!");
+        }
+
+        vkBeginCommandBuffer(timestampEndCommandBuffers[i], &beginInfo);
+        vkCmdWriteTimestamp(timestampEndCommandBuffers[i], VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestampQueryPool, 2 * i + 1);
+        if (vkEndCommandBuffer(timestampEndCommandBuffers[i]) != VK_SUCCESS) {
+            throw std::runtime_error("failed to record timestamp command buffer!");
+        }
+    }
+}
+
+void VulkanContext::readTimestampQueries() {
+    if (timestampQueryPool == VK_NULL_HANDLE || !timestampsWritten[currentFrame]) {
+        return;
+    }
+    uint64_t timestamps[2];
+    VkResult result = vkGetQueryPoolResults(
+        device, timestampQueryPool, 2 * currentFrame, 2,
+        sizeof(timestamps), timestamps, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+    if (result == VK_SUCCESS && timestamps[1] >= timestamps[0]) {
+        gpuFrameTime = (float)((double)(timestamps[1] - timestamps[0]) * timestampPeriod * 1e-6);
+    }
+}
+
 void VulkanContext::createCommandPool() {
 
     VkCommandPoolCreateInfo poolInfo{};
@@ -766,4 +1008,78 @@ void VulkanContext::createCommandPool() {
 }
 
 
+void VulkanContext::createPipelineCache() {
+    std::vector<char> data;
+
+    if (!config.PIPELINE_CACHE_PATH.empty()) {
+        std::ifstream file(config.PIPELINE_CACHE_PATH, std::ios::ate | std::ios::binary);
+        if (file.is_open()) {
+            data.resize((size_t)file.tellg());
+            file.seekg(0);
+            file.read(data.data(), data.size());
+        }
+    }
+
+    // the data is only valid for the device and driver that wrote it,
+    // drivers should reject other data themselves, but not all do
+    if (!data.empty()) {
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+        VkPipelineCacheHeaderVersionOne header{};
+        bool valid = data.size() >= sizeof(header);
+        if (valid) {
+            memcpy(&header, data.data(), sizeof(header));
+            valid = header.headerSize >= sizeof(header) &&
+                header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+                header.vendorID == properties.vendorID &&
+                header.deviceID == properties.deviceID &&
+                memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+        }
+        if (!valid) {
+            std::cout << "pipeline cache " << config.PIPELINE_CACHE_PATH << " was written by another device or driver, it is ignored" << std::endl;
+            data.clear();
+        }
+    }
+
+    VkPipelineCacheCreateInfo cacheInfo{};
+    cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    cacheInfo.initialDataSize = data.size();
+    cacheInfo.pInitialData = data.empty() ? nullptr : data.data();
+
+    if (vkCreatePipelineCache(device, &cacheInfo, nullptr, &pipelineCache) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create pipeline cache!");
+    }
+
+    pipelineBuilder.initialize(device, pipelineCache, threadPool);
+}
+
+void VulkanContext::savePipelineCache() {
+    if (config.PIPELINE_CACHE_PATH.empty()) {
+        return;
+    }
+
+    size_t size = 0;
+    if (vkGetPipelineCacheData(device, pipelineCache, &size, nullptr) != VK_SUCCESS || size == 0) {
+        return;
+    }
+    std::vector<char> data(size);
+    if (vkGetPipelineCacheData(device, pipelineCache, &size, data.data()) != VK_SUCCESS) {
+        return;
+    }
+
+    // written to a temporary file first, so that a crash never leaves a truncated cache
+    std::string tmpPath = config.PIPELINE_CACHE_PATH + ".tmp";
+    {
+        std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            std::cout << "failed to write pipeline cache " << config.PIPELINE_CACHE_PATH << std::endl;
+            return;
+        }
+        file.write(data.data(), size);
+    }
+    std::remove(config.PIPELINE_CACHE_PATH.c_str());
+    std::rename(tmpPath.c_str(), config.PIPELINE_CACHE_PATH.c_str());
+}
+
 } // namespace klartraum
\ No newline at end of file
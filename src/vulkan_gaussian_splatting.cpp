@@ -1,10 +1,14 @@
+#include <algorithm>
 #include <array>
+#include <cctype>
+#include <cmath>
+#include <filesystem>
 #include <glm/glm.hpp>
+#include <iostream>
 #include <stdexcept>
 
-#include "load-spz.h"
-
 #include "klartraum/computegraph/imageviewsrc.hpp"
+#include "klartraum/gaussian_splatting_tuning.hpp"
 #include "klartraum/vulkan_gaussian_splatting.hpp"
 #include "klartraum/vulkan_helpers.hpp"
 
@@ -14,16 +18,84 @@ VulkanGaussianSplatting::VulkanGaussianSplatting(
     VulkanContext& vulkanContext,
     std::shared_ptr<ImageViewSrc> _imageViewSrc,
     std::shared_ptr<CameraUboType> _cameraUBO,
-    std::string path) {
-    loadSPZModel(path);
+    std::string path,
+    const GaussianSplattingOptions& options) {
+    lodOptions = options.lod;
+    streamingOptions = options.streaming;
+    sortOptions = options.sort;
+    kernelConstants = options.kernels;
+    if (options.useTunedKernels) {
+        loadTunedKernelConstants(vulkanContext.getConfig().KERNEL_TUNING_PATH, vulkanContext.getDeviceUUID(), kernelConstants);
+    }
+    if (kernelConstants.projectionGroupSize == 0 || kernelConstants.splatTileSize == 0) {
+        throw std::runtime_error("workgroup sizes must not be 0!");
+    }
+    if (kernelConstants.sortGroupSize < 16) {
+        throw std::runtime_error("the sort needs at least one thread per bin!");
+    }
 
-    const float screenWidth = 512.0f;
-    const float screenHeight = 512.0f;
+    // the splat kernel counts the saturated pixels with subgroup ballots
+    VkPhysicalDeviceSubgroupProperties subgroupProperties{};
+    subgroupProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SUBGROUP_PROPERTIES;
+    VkPhysicalDeviceProperties2 properties{};
+    properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+    properties.pNext = &subgroupProperties;
+    vkGetPhysicalDeviceProperties2(vulkanContext.physicalDevice, &properties);
+    const VkSubgroupFeatureFlags requiredOperations = VK_SUBGROUP_FEATURE_BASIC_BIT | VK_SUBGROUP_FEATURE_BALLOT_BIT;
+    if ((subgroupProperties.supportedStages & VK_SHADER_STAGE_COMPUTE_BIT) == 0 ||
+        (subgroupProperties.supportedOperations & requiredOperations) != requiredOperations) {
+        throw std::runtime_error("the gaussian splatting needs subgroup ballot operations in compute shaders!");
+    }
+    uint32_t maxLevels = lodOptions.enabled ? lodOptions.maxLevels : 1;
+
+    // the leaves of the hierarchy are the loaded gaussians, the coarser
+    // levels are appended behind them
+    if (streamingOptions.enabled) {
+        // the hierarchy is built once and cached in the page file,
+        // the gaussians are streamed from the memory mapped file,
+        // without the scene an existing page file is used as it is
+        std::string pageFilePath = streamingOptions.pageFile.empty() ? path + ".kts" : streamingOptions.pageFile;
+        if (std::filesystem::exists(path)) {
+            uint64_t sourceKey = computeGaussianSourceKey(path, options.load, maxLevels);
+            if (!isGaussianPageFileValid(pageFilePath, sourceKey)) {
+                loadModel(path, options.load);
+                GaussianHierarchy hierarchy = buildGaussianHierarchy(std::move(gaussians3DData), maxLevels);
+                writeGaussianPageFile(pageFilePath, hierarchy, sourceKey);
+                std::cout << "Wrote page file: " << pageFilePath << std::endl;
+            }
+            // the scene is not kept in memory, only the page file is streamed from
+            gaussians3DData.clear();
+            gaussians3DData.shrink_to_fit();
+        } else if (!std::filesystem::exists(pageFilePath)) {
+            throw std::runtime_error("neither the scene nor its page file exist!");
+        }
+        pageFile = std::make_unique<GaussianPageFile>(pageFilePath);
+        chunksData = pageFile->getChunks();
+        parentsData = pageFile->getParents();
+        number_of_gaussians = pageFile->getHeader().numberLeafGaussians;
+        streamingOptions.poolPages = std::min(streamingOptions.poolPages, (uint32_t)chunksData.size());
+        std::cout << "Streaming " << chunksData.size() << " chunks from page file: " << pageFilePath << std::endl;
+    } else {
+        loadModel(path, options.load);
+        GaussianHierarchy hierarchy = buildGaussianHierarchy(std::move(gaussians3DData), maxLevels);
+        gaussians3DData = std::move(hierarchy.gaussians);
+        chunksData = std::move(hierarchy.chunks);
+        parentsData = std::move(hierarchy.parents);
+        std::cout << "Built a hierarchy with " << hierarchy.numberLevels << " levels and " << chunksData.size() << " chunks" << std::endl;
+
+        // the page pool holds the whole hierarchy
+        streamingOptions.poolPages = (uint32_t)chunksData.size();
+    }
+
+    // the camera movement up to which the sort order is reused is relative to the size of the scene
+    for (size_t i = 0; i < chunksData.size(); i++) {
+        if (parentsData[i] == NoParentChunk) {
+            sceneRadius = std::max(sceneRadius, chunksData[i].sphere[3]);
+        }
+    }
 
-    const uint32_t gridSize = 4; // 4x4 grid for binning
     const uint32_t numBins = gridSize * gridSize; // number of bins in the grid
-    const uint32_t threadsPerGroup = 128; // number of threads per workgroup
-    const uint32_t maxGaussiansModifier = 2; // arbitrary number, currently 2x the number of initial 3D gaussians
+    const uint32_t threadsPerGroup = kernelConstants.sortGroupSize; // elements per local histogram of the sort
 
     this->vulkanContext = &vulkanContext;
     this->setInput(_imageViewSrc, 0);
@@ -36,59 +108,200 @@ VulkanGaussianSplatting::VulkanGaussianSplatting(
     if (imageViewSrc == nullptr) {
         throw std::runtime_error("input is not an ImageViewSrc!");
     }
+    target = imageViewSrc.get();
+    camera = std::dynamic_pointer_cast<CameraUboType>(getInputElement(1)).get();
 
-    gaussians3D = std::make_shared<BufferElementSinglePath<Gaussian3DBuffer>>(vulkanContext, number_of_gaussians);
+    // the page pool, every resident chunk of the hierarchy occupies one page,
+    // it is filled by the residency manager (see _setup)
+    gaussians3D = std::make_shared<BufferElementSinglePath<Gaussian3DBuffer>>(vulkanContext, streamingOptions.poolPages * GaussianChunkSize);
     gaussians3D->setName("Gaussians3D");
 
-    gaussians3D->getBuffer().memcopyFrom(gaussians3DData);
+    // created once, so that the resident chunks are kept when the graph is compiled again,
+    // the number of frames in flight is set in _setup
+    const Gaussian3D* gaussians = pageFile ? pageFile->getGaussians() : gaussians3DData.data();
+    // the pool stays mapped, so a page upload from the streaming thread is a plain memcpy
+    auto& pool = gaussians3D->getBuffer();
+    residencyManager = std::make_unique<GaussianResidencyManager>(
+        gaussians, chunksData, parentsData, 1, streamingOptions,
+        [&pool](uint32_t page, const Gaussian3D* data, uint32_t count) {
+            pool.memcopyFrom(data, page * GaussianChunkSize, count);
+        });
+    if (!pageFile) {
+        // the pool holds the whole hierarchy, which the residency manager uploaded
+        // right away and never reads again, so the host copy is not needed anymore
+        gaussians3DData.clear();
+        gaussians3DData.shrink_to_fit();
+    }
+
+    // a cut through the hierarchy never has more gaussians than the leaves
+    // and never more than the pool holds
+    maxVisibleSplats = std::min(number_of_gaussians, streamingOptions.poolPages * GaussianChunkSize);
 
-    gaussians2D = std::make_shared<BufferElement<Gaussian2DBuffer>>(vulkanContext, number_of_gaussians * maxGaussiansModifier);
+    gaussians2D = std::make_shared<BufferElement<Gaussian2DBuffer>>(vulkanContext, maxVisibleSplats * maxGaussiansModifier);
     gaussians2D->setName("Gaussians2D");
 
+    auto flags = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+                 VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+
+    // setup chunk culling stage
+    /////////////////////////////////////////////
+    uint32_t numberOfChunks = (uint32_t)chunksData.size();
+
+    chunks = std::make_shared<BufferElementSinglePath<GaussianChunkBuffer>>(vulkanContext, numberOfChunks);
+    chunks->setName("GaussianChunks");
+    chunks->getBuffer().memcopyFrom(chunksData);
+
+    auto visibleSplats = std::make_shared<BufferElement<VulkanBuffer<uint32_t>>>(vulkanContext, maxVisibleSplats);
+    visibleSplats->setName("VisibleSplats");
+
+    auto numberVisibleSplats = std::make_shared<BufferElement<VulkanBuffer<uint32_t>>>(vulkanContext, 1);
+    numberVisibleSplats->setRecordToZero(true);
+    numberVisibleSplats->setName("NumberVisibleSplats");
+
+    // the number of workgroups of the projection (and binning) stage
+    // is only known after culling
+    auto dynamicNumberOfProjectionThreads = vulkanContext.create<BufferElement<VulkanBuffer<VkDispatchIndirectCommand>>>(1, flags);
+    dynamicNumberOfProjectionThreads->setRecordToZero(true);
+    dynamicNumberOfProjectionThreads->setName("DynamicNumberOfProjectionThreads");
+
+    // keeps the error threshold of the level of detail selection between frames,
+    // it is initialized in _setup
+    lodState = std::make_shared<BufferElement<VulkanBuffer<GaussianLodState>>>(vulkanContext, 1);
+    lodState->setName("GaussianLodState");
+
+    // maps the chunks to their pages in the pool, uploaded whenever the residency changes
+    pageTable = std::make_shared<BufferElement<VulkanBuffer<uint32_t>>>(vulkanContext, numberOfChunks);
+    pageTable->setName("GaussianPageTable");
+
+    // which chunks were rendered or need more detail, read back in _update
+    feedback = std::make_shared<BufferElement<VulkanBuffer<uint32_t>>>(vulkanContext, numberOfChunks);
+    feedback->setName("GaussianStreamingFeedback");
+
+    cullChunks = vulkanContext.create<GaussianChunkCulling>("shaders/gsplat/gsplat_chunk_culling.comp.spv");
+    cullChunks->setName("GaussianChunkCulling");
+    cullChunks->setSpecializationConstants(kernelConstants);
+    cullChunks->setInput(chunks, 0);
+    cullChunks->setInput(_cameraUBO, 1);
+    cullChunks->setInput(visibleSplats, 2);
+    cullChunks->setInput(numberVisibleSplats, 3);
+    cullChunks->setInput(dynamicNumberOfProjectionThreads, 4);
+    cullChunks->setInput(lodState, 5);
+    cullChunks->setInput(pageTable, 6);
+    cullChunks->setInput(feedback, 7);
+
+    // one workgroup per chunk, spread over two dimensions
+    // since the workgroup count of a single dimension is limited to 65535
+    const uint32_t maxGroupCount = 65535;
+    uint32_t cullGroupCountX = std::min(numberOfChunks, maxGroupCount);
+    cullChunks->setGroupCount(cullGroupCountX, (numberOfChunks + cullGroupCountX - 1) / cullGroupCountX, 1);
+
     // setup projection stage
     /////////////////////////////////////////////
 
-    auto flags = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT |
-                 VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
     auto dynamicNumberOf2DGaussiansThreads = vulkanContext.create<BufferElement<VulkanBuffer<VkDispatchIndirectCommand>>>(1, flags);
     dynamicNumberOf2DGaussiansThreads->setName("DynamicNumberOf2DGaussiansThreads");
 
-    ProjectionPushConstants pushConstants = {
-        number_of_gaussians, // numElements
-        gridSize,             // gridSize (4x4)
-        screenWidth,         // screenWidth
-        screenHeight         // screenHeight
-    };
+    // maps every gaussian of the pool to its projection, see gsplat_temporal_sort_refresh.comp
+    auto projectedIndices = std::make_shared<BufferElement<VulkanBuffer<uint32_t>>>(vulkanContext, streamingOptions.poolPages * GaussianChunkSize);
+    projectedIndices->setName("ProjectedIndices");
 
     project3Dto2D = vulkanContext.create<GaussianProjection>("shaders/gsplat/gsplat_projection.comp.spv");
     project3Dto2D->setName("GaussianProjection");
+    project3Dto2D->setSpecializationConstants(kernelConstants);
     project3Dto2D->setInput(gaussians3D, 0);
     project3Dto2D->setInput(_cameraUBO, 1);
     project3Dto2D->setInput(gaussians2D, 2);
-    project3Dto2D->setGroupCountX(number_of_gaussians / threadsPerGroup + 1);
-    project3Dto2D->setPushConstants({pushConstants});
+    project3Dto2D->setInput(cullChunks, 3, 2); // visibleSplats
+    project3Dto2D->setInput(cullChunks, 4, 3); // numberVisibleSplats
+    project3Dto2D->setInput(projectedIndices, 5);
+    project3Dto2D->setDynamicGroupDispatchParams(dynamicNumberOfProjectionThreads);
 
     // setup binning stage
     /////////////////////////////////////////////
 
-    auto totalGaussian2DCounts = std::make_shared<BufferElement<VulkanBuffer<uint32_t>>>(vulkanContext, 1);
+    // the number of binned gaussians and the number of those dropped since they did not fit
+    auto totalGaussian2DCounts = std::make_shared<BufferElement<VulkanBuffer<uint32_t>>>(vulkanContext, 2);
     totalGaussian2DCounts->setRecordToZero(true);
     totalGaussian2DCounts->setName("TotalGaussian2DCounts");
 
-    auto binnedGaussians2D = vulkanContext.create<BufferElement<Gaussian2DBuffer>>(number_of_gaussians * maxGaussiansModifier);
+    auto binnedGaussians2D = vulkanContext.create<BufferElement<Gaussian2DBuffer>>(maxVisibleSplats * maxGaussiansModifier);
     binnedGaussians2D->zero();                 // nice if it is zero initially, but not necessary
     binnedGaussians2D->setRecordToZero(false); // does not have to be reset
     binnedGaussians2D->setName("BinnedGaussians2D");
 
     bin = std::make_shared<GaussianBinning>(vulkanContext, "shaders/gsplat/gsplat_binning.comp.spv");
     bin->setName("GaussianBinning");
+    bin->setSpecializationConstants(kernelConstants);
     bin->setInput(project3Dto2D, 0, 2);
     bin->setInput(binnedGaussians2D, 1);
     bin->setInput(totalGaussian2DCounts, 2);
     bin->setInput(dynamicNumberOf2DGaussiansThreads, 3);
+    bin->setInput(project3Dto2D, 4, 4); // numberVisibleSplats
 
-    bin->setGroupCountX((number_of_gaussians * maxGaussiansModifier) / threadsPerGroup + 1);
-    bin->setPushConstants({pushConstants});
+    // one thread per projected gaussian
+    bin->setDynamicGroupDispatchParams(dynamicNumberOfProjectionThreads);
+
+    // setup incremental sorting stage
+    /////////////////////////////////////////////
+    std::shared_ptr<GaussianTemporalSortFixup> fixupSort;
+    std::shared_ptr<GaussianTemporalSortCheck> checkSort;
+    auto sortDispatch = vulkanContext.create<BufferElement<VulkanBuffer<VkDispatchIndirectCommand>>>(1, flags);
+    sortDispatch->setName("SortDispatch");
+    if (sortOptions.temporal) {
+        // the sorted gaussians of the previous frame of each path
+        auto sortHistory = std::make_shared<BufferElement<Gaussian2DBuffer>>(vulkanContext, maxVisibleSplats * maxGaussiansModifier);
+        sortHistory->setName("SortHistory");
+
+        // initialized in _setup, updated by the host in _update
+        sortState = std::make_shared<BufferElement<VulkanBuffer<TemporalSortState>>>(vulkanContext, 1);
+        sortState->setName("TemporalSortState");
+
+        // only written by the host, in _update
+        forceFullSort = std::make_shared<BufferElement<VulkanBuffer<uint32_t>>>(vulkanContext, 1);
+        forceFullSort->setName("ForceFullSort");
+
+        auto fixupDispatch = vulkanContext.create<BufferElement<VulkanBuffer<VkDispatchIndirectCommand>>>(1, flags);
+        fixupDispatch->setName("FixupDispatch");
+
+        refreshSort = vulkanContext.create<GaussianTemporalSortRefresh>("shaders/gsplat/gsplat_temporal_sort_refresh.comp.spv");
+        refreshSort->setName("GaussianTemporalSortRefresh");
+        refreshSort->setSpecializationConstants(kernelConstants);
+        refreshSort->setInput(sortHistory, 0);
+        refreshSort->setInput(project3Dto2D, 1, 5); // projectedIndices
+        refreshSort->setInput(project3Dto2D, 2, 2); // gaussians2D
+        refreshSort->setInput(project3Dto2D, 3, 4); // numberVisibleSplats
+        refreshSort->setInput(bin, 4, 2);           // totalGaussian2DCounts
+        refreshSort->setInput(sortState, 5);
+        refreshSort->setInput(sortDispatch, 6);
+        refreshSort->setInput(fixupDispatch, 7);
+        refreshSort->setInput(bin, 8, 1);           // binnedGaussians2D, the input of the full sort
+        refreshSort->setInput(forceFullSort, 9);
+        refreshSort->setDynamicGroupDispatchParams(dynamicNumberOf2DGaussiansThreads);
+
+        fixupSort = vulkanContext.create<GaussianTemporalSortFixup>("shaders/gsplat/gsplat_temporal_sort_fixup.comp.spv");
+        fixupSort->setName("GaussianTemporalSortFixup");
+        fixupSort->setSpecializationConstants(kernelConstants);
+        fixupSort->setInput(refreshSort, 0, 0); // sortHistory
+        fixupSort->setInput(refreshSort, 1, 4); // totalGaussian2DCounts
+        fixupSort->setDynamicGroupDispatchParams(fixupDispatch);
+
+        std::vector<SortPushConstants> fixupPushConstants;
+        for (uint32_t i = 0; i < sortOptions.fixupPasses; i++) {
+            fixupPushConstants.push_back({i, maxVisibleSplats * maxGaussiansModifier, numBins}); // pass, numElements, numBins
+        }
+        fixupSort->setPushConstants(fixupPushConstants);
+
+        // enables the full sort if the fix-up was not enough, before the full sort runs
+        checkSort = vulkanContext.create<GaussianTemporalSortCheck>("shaders/gsplat/gsplat_temporal_sort_check.comp.spv");
+        checkSort->setName("GaussianTemporalSortCheck");
+        checkSort->setSpecializationConstants(kernelConstants);
+        checkSort->setInput(fixupSort, 0, 0);   // sortHistory
+        checkSort->setInput(fixupSort, 1, 1);   // totalGaussian2DCounts
+        checkSort->setInput(refreshSort, 2, 5); // sortState
+        checkSort->setInput(refreshSort, 3, 6); // sortDispatch
+        checkSort->setInput(refreshSort, 4, 8); // binnedGaussians2D, the input of the full sort
+        checkSort->setDynamicGroupDispatchParams(fixupDispatch);
+    }
 
     // setup sorting stage
     /////////////////////////////////////////////
@@ -100,10 +313,16 @@ VulkanGaussianSplatting::VulkanGaussianSplatting(
     sort2DGaussians = std::make_shared<GaussianSort>(vulkanContext, shaders);
 
     sort2DGaussians->setName("GaussianSort");
+    sort2DGaussians->setSpecializationConstants(kernelConstants);
 
-    sort2DGaussians->setInput(bin, 0, 1);
+    if (sortOptions.temporal) {
+        // only runs if the order of the previous frame cannot be reused
+        sort2DGaussians->setInput(checkSort, 0, 4);
+    } else {
+        sort2DGaussians->setInput(bin, 0, 1);
+    }
 
-    auto scratchBufferHistograms = std::make_shared<BufferElement<VulkanBuffer<uint32_t>>>(vulkanContext, numBins * ((number_of_gaussians * maxGaussiansModifier) / threadsPerGroup + 1));
+    auto scratchBufferHistograms = std::make_shared<BufferElement<VulkanBuffer<uint32_t>>>(vulkanContext, numBins * ((maxVisibleSplats * maxGaussiansModifier) / threadsPerGroup + 1));
     scratchBufferHistograms->setName("ScratchBufferHistograms");
     scratchBufferHistograms->setRecordToZero(true);
 
@@ -114,11 +333,11 @@ VulkanGaussianSplatting::VulkanGaussianSplatting(
     scratchBufferOffsets->setName("ScratchBufferOffsets");
     scratchBufferOffsets->setRecordToZero(true);
 
-    auto scratchBufferIndexA = std::make_shared<BufferElement<VulkanBuffer<uint32_t>>>(vulkanContext, number_of_gaussians * maxGaussiansModifier);
+    auto scratchBufferIndexA = std::make_shared<BufferElement<VulkanBuffer<uint32_t>>>(vulkanContext, maxVisibleSplats * maxGaussiansModifier);
     scratchBufferIndexA->setName("ScratchBufferIndexA");
     scratchBufferIndexA->setRecordToZero(true);
 
-    auto scratchBufferIndexB = std::make_shared<BufferElement<VulkanBuffer<uint32_t>>>(vulkanContext, number_of_gaussians * maxGaussiansModifier);
+    auto scratchBufferIndexB = std::make_shared<BufferElement<VulkanBuffer<uint32_t>>>(vulkanContext, maxVisibleSplats * maxGaussiansModifier);
     scratchBufferIndexB->setName("ScratchBufferIndexB");
     scratchBufferIndexB->setRecordToZero(true);
 
@@ -129,9 +348,9 @@ VulkanGaussianSplatting::VulkanGaussianSplatting(
     sort2DGaussians->addScratchBufferElement(scratchBufferIndexA, false);
     sort2DGaussians->addScratchBufferElement(scratchBufferIndexB, false);
 
-    sort2DGaussians->setDynamicGroupDispatchParams(dynamicNumberOf2DGaussiansThreads);
+    sort2DGaussians->setDynamicGroupDispatchParams(sortOptions.temporal ? sortDispatch : dynamicNumberOf2DGaussiansThreads);
 
-    uint32_t numElements = (uint32_t)((number_of_gaussians));
+    uint32_t numElements = (uint32_t)((maxVisibleSplats));
     uint32_t numBitsPerPass = 4; // Number of bits per pass (4 bits for 16 bins)
     //uint32_t numBins = numBins;       // Number of bins for sorting = 2 ^ numBitsPerPass
     uint32_t passes = 32 + 16;   // 32 bits for depth, 16 bits for binning
@@ -142,6 +361,17 @@ VulkanGaussianSplatting::VulkanGaussianSplatting(
 
     sort2DGaussians->setPushConstants(sortPushConstants);
 
+    if (sortOptions.temporal) {
+        resolveSort = vulkanContext.create<GaussianTemporalSortResolve>("shaders/gsplat/gsplat_temporal_sort_resolve.comp.spv");
+        resolveSort->setName("GaussianTemporalSortResolve");
+        resolveSort->setSpecializationConstants(kernelConstants);
+        resolveSort->setInput(sort2DGaussians, 0);
+        resolveSort->setInput(checkSort, 1, 0); // sortHistory
+        resolveSort->setInput(checkSort, 2, 1); // totalGaussian2DCounts
+        resolveSort->setInput(refreshSort, 3, 5); // sortState
+        resolveSort->setDynamicGroupDispatchParams(dynamicNumberOf2DGaussiansThreads);
+    }
+
     // setup bounds computation stage
     /////////////////////////////////////////////
     auto scratchBinStartAndEnd = std::make_shared<BufferElement<VulkanBuffer<uint32_t>>>(vulkanContext, numBins * 2);
@@ -150,40 +380,22 @@ VulkanGaussianSplatting::VulkanGaussianSplatting(
 
     computeBounds = std::make_shared<GaussianComputeBounds>(vulkanContext, "shaders/gsplat/gsplat_bin_bounds.comp.spv");
     computeBounds->setName("GaussianComputeBounds");
+    computeBounds->setSpecializationConstants(kernelConstants);
 
-    ProjectionPushConstants computeBoundsPushConstants = {
-        (uint32_t)((number_of_gaussians)), // numElements
-        gridSize,                          // gridSize (4x4)
-        screenWidth,                       // screenWidth
-        screenHeight                       // screenHeight
-    };
-
-    computeBounds->setInput(sort2DGaussians, 0);       // bufferElement, 0);
+    if (sortOptions.temporal) {
+        computeBounds->setInput(resolveSort, 0, 0);    // sorted gaussians, after the incremental sort
+    } else {
+        computeBounds->setInput(sort2DGaussians, 0);   // bufferElement, 0);
+    }
     computeBounds->setInput(bin, 1, 2);                // totalGaussian2DCounts, 1);
     computeBounds->setInput(scratchBinStartAndEnd, 2); // scratchBinStartAndEnd, 2);
     computeBounds->setDynamicGroupDispatchParams(dynamicNumberOf2DGaussiansThreads);
 
-
-    computeBounds->setPushConstants({computeBoundsPushConstants});
-
     // setup splatting stage
     /////////////////////////////////////////////
     splat = std::make_shared<GaussianSplatting>(vulkanContext, "shaders/gsplat/gsplat_binned_splatting.comp.spv");
     splat->setName("GaussianSplatting");
-
-    std::vector<SplatPushConstants> splatPushConstants;
-    for (uint32_t y = 0; y < gridSize; y++) {
-        for (uint32_t x = 0; x < gridSize; x++) {
-            splatPushConstants.push_back({
-                (uint32_t)(number_of_gaussians * maxGaussiansModifier), // max. numElements
-                gridSize,                             // gridSize (4x4)
-                x,                                    // gridX
-                y,                                    // gridY
-                screenWidth,                          // screenWidth
-                screenHeight                           // screenHeight
-            });
-        }
-    }
+    splat->setSpecializationConstants(kernelConstants);
 
     splat->setInput(computeBounds, 0, 0); // bufferElement, 0);
     splat->setInput(computeBounds, 1, 1); // totalGaussian2DCounts, 1);
@@ -191,19 +403,14 @@ VulkanGaussianSplatting::VulkanGaussianSplatting(
     splat->setInput(imageViewSrc, 3);
 
 
-    // each bin computes several workgroups, each processing 8x8 pixels
-    // where each pixel is processed by a single thread
-    const uint32_t threadsPerBinX = 8;
-    const uint32_t threadsPerBinY = 8;
-
-    const uint32_t groupsPerBinX = (screenWidth / threadsPerBinX) / gridSize;
-    const uint32_t groupsPerBinY = (screenHeight / threadsPerBinY) / gridSize;
-
-    splat->setGroupCountX(groupsPerBinX);
-    splat->setGroupCountY(groupsPerBinY);
-    splat->setGroupCountZ(1);
-
-    splat->setPushConstants(splatPushConstants);
+    // the push constants and group counts that depend on the resolution,
+    // they are updated in _update whenever the extent of the image changes
+    if (options.dynamicResolution) {
+        for (auto& element : getResolutionElements()) {
+            element->setDynamic(true);
+        }
+    }
+    setResolution(getTargetExtent());
 
     // this is the last element in the splatting pipeline
     // it will be used as the output of the computegraphgroup
@@ -231,8 +438,163 @@ void VulkanGaussianSplatting::checkInput(ComputeGraphElementPtr input, int index
     }
 }
 
+VkExtent2D VulkanGaussianSplatting::getTargetExtent() {
+    VkExtent2D extent = target->getExtent();
+    if (extent.width == 0 || extent.height == 0) {
+        // images of unknown size are assumed to be 512x512
+        extent = {512, 512};
+    }
+    return extent;
+}
+
+void VulkanGaussianSplatting::setResolution(VkExtent2D extent) {
+    resolution = extent;
+    const float screenWidth = (float)extent.width;
+    const float screenHeight = (float)extent.height;
+
+    ChunkCullingPushConstants cullPushConstants = {
+        (uint32_t)chunksData.size(), // numChunks
+        maxVisibleSplats,          // maxVisibleSplats
+        lodOptions.splatBudget,    // splatBudget
+        screenHeight,              // screenHeight
+        lodOptions.errorThreshold  // minErrorThreshold
+    };
+    cullChunks->setPushConstants({cullPushConstants});
+
+    ProjectionPushConstants pushConstants = {
+        maxVisibleSplats, // numElements
+        gridSize,             // gridSize (4x4)
+        screenWidth,         // screenWidth
+        screenHeight         // screenHeight
+    };
+    project3Dto2D->setPushConstants({pushConstants});
+    bin->setPushConstants({pushConstants});
+    computeBounds->setPushConstants({pushConstants});
+    if (sortOptions.temporal) {
+        refreshSort->setPushConstants({pushConstants});
+        resolveSort->setPushConstants({pushConstants});
+    }
+
+    std::vector<SplatPushConstants> splatPushConstants;
+    for (uint32_t y = 0; y < gridSize; y++) {
+        for (uint32_t x = 0; x < gridSize; x++) {
+            splatPushConstants.push_back({
+                (uint32_t)(maxVisibleSplats * maxGaussiansModifier), // max. numElements
+                gridSize,                             // gridSize (4x4)
+                x,                                    // gridX
+                y,                                    // gridY
+                screenWidth,                          // screenWidth
+                screenHeight                           // screenHeight
+            });
+        }
+    }
+    splat->setPushConstants(splatPushConstants);
+
+    // each bin computes several workgroups, each processing splatTileSize x splatTileSize
+    // pixels where each pixel is processed by a single thread,
+    // the bins are screen size / gridSize wide (rounded up)
+    const uint32_t threadsPerBinX = kernelConstants.splatTileSize;
+    const uint32_t threadsPerBinY = kernelConstants.splatTileSize;
+
+    const uint32_t binWidth = (extent.width + gridSize - 1) / gridSize;
+    const uint32_t binHeight = (extent.height + gridSize - 1) / gridSize;
+
+    splat->setGroupCountX((binWidth + threadsPerBinX - 1) / threadsPerBinX);
+    splat->setGroupCountY((binHeight + threadsPerBinY - 1) / threadsPerBinY);
+    splat->setGroupCountZ(1);
+
+    // dynamic elements ignore this, they are recorded before every submission anyway
+    for (auto& element : getResolutionElements()) {
+        element->setRecordOutdated();
+    }
+}
+
+std::vector<ComputeGraphElementPtr> VulkanGaussianSplatting::getResolutionElements() const {
+    std::vector<ComputeGraphElementPtr> elements = {cullChunks, project3Dto2D, bin, computeBounds, splat};
+    if (sortOptions.temporal) {
+        elements.push_back(refreshSort);
+        elements.push_back(resolveSort);
+    }
+    return elements;
+}
+
 void VulkanGaussianSplatting::_setup(VulkanContext& vulkanContext, uint32_t numberPaths) {
     numberOfPaths = numberPaths;
+
+    // the group is set up after its elements, so the buffers exist by now
+    for (uint32_t pathId = 0; pathId < numberPaths; pathId++) {
+        lodState->getBuffer(pathId).memcopyFrom({{lodOptions.errorThreshold, 0}});
+        feedback->getBuffer(pathId).zero();
+    }
+
+    // the pool is shared by all paths, so evicted pages may only be
+    // reused after every path has been submitted again
+    residencyManager->setFramesInFlight(numberPaths + 1);
+    pageTableVersions.assign(numberPaths, UINT64_MAX);
+    feedbackData.resize(chunksData.size());
+
+    if (sortOptions.temporal) {
+        for (uint32_t pathId = 0; pathId < numberPaths; pathId++) {
+            sortState->getBuffer(pathId).zero();
+            forceFullSort->getBuffer(pathId).memcopyFrom({1});
+        }
+        previousModelViews.assign(numberPaths, glm::mat4(0.0f));
+    }
+}
+
+void VulkanGaussianSplatting::_update(uint32_t pathId) {
+    // the graph records the elements again, before this path is submitted
+    VkExtent2D extent = getTargetExtent();
+    if (extent.width != resolution.width || extent.height != resolution.height) {
+        setResolution(extent);
+    }
+
+    // the previous submission of this path has finished, so its feedback is complete
+    feedback->getBuffer(pathId).memcopyTo(feedbackData);
+
+    // chunks closer to the camera are streamed in first
+    glm::mat4 modelView = camera->ubo.view * camera->ubo.model;
+    glm::vec4 cameraPosition = glm::inverse(modelView) * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+
+    residencyManager->update(feedbackData.data(), {cameraPosition.x, cameraPosition.y, cameraPosition.z});
+
+    // streamed chunks change the rendering of all paths
+    if (changedPageTableVersion != residencyManager->getPageTableVersion()) {
+        changedPageTableVersion = residencyManager->getPageTableVersion();
+        pageTable->setChanged();
+    }
+
+    if (pageTableVersions[pathId] != residencyManager->getPageTableVersion()) {
+        pageTable->getBuffer(pathId).memcopyFrom(residencyManager->getPageTable());
+        pageTableVersions[pathId] = residencyManager->getPageTableVersion();
+    }
+
+    if (sortOptions.temporal) {
+        // the order of the previous frame of this path is only reused if the camera barely moved,
+        // the gpu falls back to the full sort by itself if the gaussians changed otherwise
+        bool smallViewChange = isViewChangeSmall(previousModelViews[pathId], modelView);
+        previousModelViews[pathId] = modelView;
+
+        forceFullSort->getBuffer(pathId).memcopyFrom({smallViewChange ? 0u : 1u});
+    }
+}
+
+bool VulkanGaussianSplatting::isViewChangeSmall(const glm::mat4& previous, const glm::mat4& current) const {
+    if (previous == glm::mat4(0.0f)) {
+        return false; // first frame of the path
+    }
+    glm::mat4 previousInverse = glm::inverse(previous);
+    glm::mat4 currentInverse = glm::inverse(current);
+
+    glm::vec3 previousPosition = glm::vec3(previousInverse * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+    glm::vec3 currentPosition = glm::vec3(currentInverse * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+    if (glm::length(currentPosition - previousPosition) > sortOptions.maxViewTranslation * sceneRadius) {
+        return false;
+    }
+
+    glm::vec3 previousDirection = glm::normalize(glm::vec3(previousInverse * glm::vec4(0.0f, 0.0f, -1.0f, 0.0f)));
+    glm::vec3 currentDirection = glm::normalize(glm::vec3(currentInverse * glm::vec4(0.0f, 0.0f, -1.0f, 0.0f)));
+    return glm::dot(previousDirection, currentDirection) >= std::cos(sortOptions.maxViewAngle);
 }
 
 void VulkanGaussianSplatting::_record(VkCommandBuffer commandBuffer, uint32_t pathId) {
@@ -242,11 +604,7 @@ void VulkanGaussianSplatting::_record(VkCommandBuffer commandBuffer, uint32_t pa
 
     auto& swapChainExtent = vulkanContext->getSwapChainExtent();
 
-    ImageViewSrc* imageViewSrc = std::dynamic_pointer_cast<ImageViewSrc>(getInputElement(0)).get();
-    if (imageViewSrc == nullptr) {
-        throw std::runtime_error("input is not an ImageViewSrc!");
-    }
-    VkImage image = imageViewSrc->getImage(pathId);
+    VkImage image = target->getImage(pathId);
 
     //     // Ensure compute writes are visible to graphics
     //     VkImageMemoryBarrier imageBarrier = {};
@@ -289,6 +647,11 @@ void VulkanGaussianSplatting::_record(VkCommandBuffer commandBuffer, uint32_t pa
 
     //     vkCmdDispatch(commandBuffer, 64, 64, num_groups_z);*/
 
+    // images kept in the general layout are read by the following elements
+    if (target->getLayout() == VK_IMAGE_LAYOUT_GENERAL) {
+        return;
+    }
+
     VkImageMemoryBarrier barrierBack = {};
     barrierBack.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
     barrierBack.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
@@ -315,101 +678,33 @@ void VulkanGaussianSplatting::_record(VkCommandBuffer commandBuffer, uint32_t pa
         1, &barrierBack);
 }
 
-double sigmoid(double x) {
-    return 1.0 / (1.0 + std::exp(-x));
-}
-
-void VulkanGaussianSplatting::loadSPZModel(std::string path) {
-
-    spz::PackedGaussians packed = spz::loadSpzPacked(path);
-
-    gaussians3DData.clear();
-    gaussians3DData.reserve(packed.numPoints);
-    number_of_gaussians = 256 * 256;
-
-    // float clipBoundsX = 300.0f;
-    // float clipBoundsY = 300.0f;
-    // float clipBoundsZ = 300.0f;
-
-    spz::CoordinateConverter defaultCoordinateConverter;
-
-    for (int i = 0; i < packed.numPoints; i++) {
-    //for (int i = 60000; i < 60000 + number_of_gaussians; /*packed.numPoints*/ i++) {
-        spz::UnpackedGaussian gaussian = packed.unpack(i, defaultCoordinateConverter);
-        // if (gaussian.position[0] < -clipBoundsX || gaussian.position[0] > clipBoundsX ||
-        //     gaussian.position[1] < -clipBoundsY || gaussian.position[1] > clipBoundsY ||
-        //     gaussian.position[2] < -clipBoundsZ || gaussian.position[2] > clipBoundsZ) {
-        //     continue; // Skip gaussians outside the clipping bounds
-        // }
-        Gaussian3D gaussian3D;
-        memcpy(&gaussian3D, &gaussian, sizeof(spz::UnpackedGaussian));
-
-        // use activation functions as done in original implementation and described in the paper
-        gaussian3D.alpha = sigmoid(gaussian.alpha); // inverse logistic back to alpha
-
-        // color is sh0 encoding, if we want to skip the spherical harmonics, we can use the following:
-        // gaussian3D.color[0] = 0.5 + 0.282095 * gaussian.color[0];
-        // gaussian3D.color[1] = 0.5 + 0.282095 * gaussian.color[1];
-        // gaussian3D.color[2] = 0.5 + 0.282095 * gaussian.color[2];
+void VulkanGaussianSplatting::loadModel(const std::string& path, const GaussianLoadOptions& options) {
+    std::string extension = std::filesystem::path(path).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return (char)std::tolower(c); });
 
+    if (extension == ".spz") {
+        loadSPZModel(path, options);
+    } else if (extension == ".ply") {
+        loadPLYModel(path, options);
+    } else {
+        throw std::runtime_error("unsupported gaussian splatting file format: " + path);
+    }
 
-        gaussian3D.scale[0] = std::exp(gaussian.scale[0]);
-        gaussian3D.scale[1] = std::exp(gaussian.scale[1]);
-        gaussian3D.scale[2] = std::exp(gaussian.scale[2]);
-        gaussians3DData.push_back(gaussian3D);
+    if (number_of_gaussians == 0) {
+        throw std::runtime_error("no gaussians loaded from " + path + "!");
     }
+}
+
+void VulkanGaussianSplatting::loadSPZModel(const std::string& path, const GaussianLoadOptions& options) {
+    gaussians3DData = loadGaussiansFromSpz(path, options);
 
     number_of_gaussians = (uint32_t)gaussians3DData.size();
 
     std::cout << "Loaded " << number_of_gaussians << " gaussians from SPZ file: " << path << std::endl;
 }
 
-void VulkanGaussianSplatting::loadPLYModel(std::string path) {
-
-    spz::UnpackOptions unpackOptions;
-    spz::GaussianCloud cloud = spz::loadSplatFromPly("input/bonsai/point_cloud/iteration_7000/point_cloud.ply", unpackOptions);
-
-    gaussians3DData.clear();
-    gaussians3DData.reserve(cloud.numPoints);
-    number_of_gaussians = 256 * 256;
-
-    float clipBounds = 1.5f;
-
-    spz::CoordinateConverter defaultCoordinateConverter;
-
-    for (int i = 0; i < cloud.numPoints; i++) {
-    //for (int i = 60000; i < 60000 + number_of_gaussians; /*packed.numPoints*/ i++) {
-        Gaussian3D gaussian3D;
-        // use activation functions as done in original implementation and described in the paper
-        // position
-        gaussian3D.position[0] = cloud.positions[i * 3 + 0];
-        gaussian3D.position[1] = cloud.positions[i * 3 + 1];
-        gaussian3D.position[2] = cloud.positions[i * 3 + 2];
-
-        // rotation
-        gaussian3D.rotation[0] = cloud.rotations[i * 4 + 0];
-        gaussian3D.rotation[1] = cloud.rotations[i * 4 + 1];
-        gaussian3D.rotation[2] = cloud.rotations[i * 4 + 2];
-        gaussian3D.rotation[3] = cloud.rotations[i * 4 + 3];
-
-        // alpha, color, scale
-        gaussian3D.alpha = sigmoid(cloud.alphas[i]); // inverse logistic back to alpha
-        gaussian3D.color[0] = 0.5 + 0.282095 * cloud.colors[i*3+0];
-        gaussian3D.color[1] = 0.5 + 0.282095 * cloud.colors[i*3+1];
-        gaussian3D.color[2] = 0.5 + 0.282095 * cloud.colors[i*3+2];
-        
-        gaussian3D.scale[0] = std::exp(cloud.scales[i*3+0]);
-        gaussian3D.scale[1] = std::exp(cloud.scales[i*3+1]);
-        gaussian3D.scale[2] = std::exp(cloud.scales[i*3+2]);
-
-
-        if (cloud.positions[i*3+0] < -clipBounds || cloud.positions[i*3+0] > clipBounds ||
-            cloud.positions[i*3+1] < -clipBounds || cloud.positions[i*3+1] > clipBounds ||
-            cloud.positions[i*3+2] < -clipBounds || cloud.positions[i*3+2] > clipBounds) {
-            continue; // Skip gaussians outside the clipping bounds
-        }
-        gaussians3DData.push_back(gaussian3D);
-    }
+void VulkanGaussianSplatting::loadPLYModel(const std::string& path, const GaussianLoadOptions& options) {
+    gaussians3DData = loadGaussiansFromPly(path, options);
 
     number_of_gaussians = (uint32_t)gaussians3DData.size();
 
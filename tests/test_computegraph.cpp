@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <map>
 #include <vector>
 
@@ -7,9 +8,12 @@
 
 #include "klartraum/computegraph/computegraph.hpp"
 
+#include "klartraum/computegraph/bufferelement.hpp"
+#include "klartraum/computegraph/generalcomputation.hpp"
 #include "klartraum/computegraph/imageviewsrc.hpp"
 #include "klartraum/computegraph/renderpass.hpp"
 #include "klartraum/draw_basics.hpp"
+#include "klartraum/vulkan_buffer.hpp"
 
 using namespace klartraum;
 
@@ -66,6 +70,35 @@ class CopyOp : public ComputeGraphElement {
 };
 
 
+// records nothing, for the tests of which elements are submitted
+class PassOp : public ComputeGraphElement {
+public:
+    PassOp(bool requiredByOutputs = false) : requiredByOutputs(requiredByOutputs) {}
+
+    virtual const char* getType() const {
+        return "PassOp";
+    }
+
+    virtual void checkInput(ComputeGraphElementPtr input, int index = 0) {
+        // accept everything
+    }
+
+    // like a buffer that is reset before the elements using it
+    virtual bool isRequiredByOutputs() const {
+        return requiredByOutputs;
+    }
+
+private:
+    bool requiredByOutputs;
+};
+
+// see shaders/operator_multiply_push.comp
+struct MultiplyPushConstants {
+    float multiplier;
+};
+
+typedef BufferElement<VulkanBuffer<float>> FloatBufferElement;
+
 
 TEST(ComputeGraph, create) {
     klartraum::GlfwFrontend frontend;
@@ -190,4 +223,151 @@ TEST(ComputeGraph, trippleFramebuffer) {
 
     vkDestroyFence(device, fence, nullptr);  
     return;
-}
\ No newline at end of file
+}
+
+TEST(ComputeGraph, skipUnchanged) {
+    klartraum::GlfwFrontend frontend;
+
+    auto& core = frontend.getKlartraumEngine();
+    auto& vulkanContext = core.getVulkanContext();
+
+    // sourceA -> a -> sink <- b <- sourceB, the reset buffer is an input of a
+    auto sourceA = std::make_shared<PassOp>();
+    auto sourceB = std::make_shared<PassOp>();
+    auto reset = std::make_shared<PassOp>(true);
+    auto a = std::make_shared<PassOp>();
+    a->setInput(sourceA, 0);
+    a->setInput(reset, 1);
+    auto b = std::make_shared<PassOp>();
+    b->setInput(sourceB, 0);
+    auto sink = std::make_shared<PassOp>();
+    sink->setInput(a, 0);
+    sink->setInput(b, 1);
+
+    auto computegraph = ComputeGraph(vulkanContext, 1);
+    computegraph.setSkipUnchanged(true);
+    computegraph.compileFrom(sink);
+
+    auto isChanged = [&](ComputeGraphElementPtr element) {
+        auto& elements = computegraph.getOrderedElements();
+        size_t position = std::find(elements.begin(), elements.end(), element) - elements.begin();
+        return (bool)computegraph.getChangedElements(0).at(position);
+    };
+
+    // STEP 1: everything is submitted the first time
+    for (auto& element : computegraph.getOrderedElements()) {
+        EXPECT_TRUE(isChanged(element));
+    }
+    computegraph.submitAndWait(vulkanContext.getGraphicsQueue(), 0);
+
+    // STEP 2: an unchanged graph skips all elements
+    for (auto& element : computegraph.getOrderedElements()) {
+        EXPECT_FALSE(isChanged(element));
+    }
+    computegraph.submitAndWait(vulkanContext.getGraphicsQueue(), 0);
+
+    // STEP 3: a changed input submits the elements downstream of it,
+    // and the elements required by them, but not the other branch
+    sourceA->setChanged();
+    EXPECT_TRUE(isChanged(sourceA));
+    EXPECT_TRUE(isChanged(a));
+    EXPECT_TRUE(isChanged(sink));
+    EXPECT_TRUE(isChanged(reset));
+    EXPECT_FALSE(isChanged(sourceB));
+    EXPECT_FALSE(isChanged(b));
+    computegraph.submitAndWait(vulkanContext.getGraphicsQueue(), 0);
+
+    for (auto& element : computegraph.getOrderedElements()) {
+        EXPECT_FALSE(isChanged(element));
+    }
+}
+
+TEST(ComputeGraph, dynamicPushConstants) {
+    klartraum::GlfwFrontend frontend;
+
+    auto& core = frontend.getKlartraumEngine();
+    auto& vulkanContext = core.getVulkanContext();
+
+    auto input = std::make_shared<FloatBufferElement>(vulkanContext, 7);
+    auto output = std::make_shared<FloatBufferElement>(vulkanContext, 7);
+
+    auto multiply = std::make_shared<GeneralComputation<MultiplyPushConstants>>(vulkanContext, "shaders/operator_multiply_push.comp.spv");
+    multiply->setInput(input, 0);
+    multiply->setInput(output, 1);
+    multiply->setGroupCount(7, 1, 1);
+    multiply->setDynamic(true);
+    multiply->setPushConstants({{1.0f}});
+
+    auto computegraph = ComputeGraph(vulkanContext, 1);
+    computegraph.compileFrom(multiply);
+
+    std::vector<float> data = {1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f};
+    input->getBuffer(0).memcopyFrom(data);
+
+    // the dynamic element is recorded again with the push constants of each submission
+    for (float multiplier : {2.0f, 3.0f, 0.5f}) {
+        multiply->setPushConstants({{multiplier}});
+        computegraph.submitAndWait(vulkanContext.getGraphicsQueue(), 0);
+
+        std::vector<float> data_out(7, 0.0f);
+        output->getBuffer(0).memcopyTo(data_out);
+        for (int i = 0; i < 7; i++) {
+            EXPECT_EQ(data[i] * multiplier, data_out[i]);
+        }
+    }
+}
+
+TEST(ComputeGraph, parallelRecording) {
+    klartraum::GlfwFrontend frontend;
+
+    auto& core = frontend.getKlartraumEngine();
+    auto& vulkanContext = core.getVulkanContext();
+
+    std::vector<float> data = {1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f};
+
+    // a chain of elements multiplying the output of the previous one,
+    // every other element is dynamic and recorded before each submission
+    auto run = [&](bool parallel) {
+        auto input = std::make_shared<FloatBufferElement>(vulkanContext, 7);
+        input->getBuffer(0).memcopyFrom(data);
+
+        ComputeGraphElementPtr previous;
+        std::shared_ptr<FloatBufferElement> output;
+        for (int i = 0; i < 12; i++) {
+            output = std::make_shared<FloatBufferElement>(vulkanContext, 7);
+
+            auto multiply = std::make_shared<GeneralComputation<MultiplyPushConstants>>(vulkanContext, "shaders/operator_multiply_push.comp.spv");
+            if (previous == nullptr) {
+                multiply->setInput(input, 0);
+            } else {
+                multiply->setInput(previous, 0, 1);
+            }
+            multiply->setInput(output, 1);
+            multiply->setGroupCount(7, 1, 1);
+            multiply->setDynamic(i % 2 == 1);
+            multiply->setPushConstants({{(float)(i % 3 + 1)}});
+            previous = multiply;
+        }
+
+        auto computegraph = ComputeGraph(vulkanContext, 1);
+        computegraph.setParallelRecording(parallel);
+        computegraph.compileFrom(previous);
+
+        // the second submission uses the recorded and the again recorded dynamic elements
+        std::vector<float> data_out(7, 0.0f);
+        for (int submission = 0; submission < 2; submission++) {
+            computegraph.submitAndWait(vulkanContext.getGraphicsQueue(), 0);
+            output->getBuffer(0).memcopyTo(data_out);
+        }
+        return data_out;
+    };
+
+    std::vector<float> serial = run(false);
+    std::vector<float> parallel = run(true);
+
+    // 1 * 2 * 3 repeated four times
+    for (int i = 0; i < 7; i++) {
+        EXPECT_EQ(data[i] * 1296.0f, serial[i]);
+        EXPECT_EQ(serial[i], parallel[i]);
+    }
+}
@@ -0,0 +1,51 @@
+#include <gtest/gtest.h>
+
+#include "klartraum/glfw_frontend.hpp"
+
+TEST(DescriptorAllocator, grows) {
+    klartraum::GlfwFrontend frontend;
+
+    auto& core = frontend.getKlartraumEngine();
+    auto& vulkanContext = core.getVulkanContext();
+    auto& device = vulkanContext.getDevice();
+    auto& allocator = vulkanContext.getDescriptorAllocator();
+
+    VkDescriptorSetLayoutBinding bindings[2]{};
+    for (uint32_t i = 0; i < 2; i++) {
+        bindings[i].binding = i;
+        bindings[i].descriptorCount = 1;
+        bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = 2;
+    layoutInfo.pBindings = bindings;
+
+    VkDescriptorSetLayout layout;
+    ASSERT_EQ(vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &layout), VK_SUCCESS);
+
+    // STEP 1: far more paths than a single pool holds
+    size_t poolsBefore = allocator.getNumberPools();
+    std::vector<VkDescriptorSet> sets;
+    for (int i = 0; i < 100; i++) {
+        auto pathSets = allocator.allocate(layout, {{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2}}, 7);
+        ASSERT_EQ(pathSets.size(), 7u);
+        sets.insert(sets.end(), pathSets.begin(), pathSets.end());
+    }
+    for (auto set : sets) {
+        EXPECT_NE(set, (VkDescriptorSet)VK_NULL_HANDLE);
+    }
+    size_t poolsAfter = allocator.getNumberPools();
+    EXPECT_GT(poolsAfter, poolsBefore);
+
+    // STEP 2: freed sets are reused, no new pools are needed
+    allocator.free(sets);
+    for (int i = 0; i < 100; i++) {
+        allocator.allocate(layout, {{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2}}, 7);
+    }
+    EXPECT_EQ(allocator.getNumberPools(), poolsAfter);
+
+    vkDestroyDescriptorSetLayout(device, layout, nullptr);
+}
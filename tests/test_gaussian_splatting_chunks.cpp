@@ -0,0 +1,78 @@
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "klartraum/gaussian_splatting_chunks.hpp"
+
+using namespace klartraum;
+
+namespace {
+
+Gaussian3D makeGaussian(float x, float y, float z, float scale) {
+    Gaussian3D gaussian{};
+    gaussian.position = {x, y, z};
+    gaussian.rotation = {0.0f, 0.0f, 0.0f, 1.0f};
+    gaussian.scale = {scale, scale, scale};
+    return gaussian;
+}
+
+} // namespace
+
+TEST(GaussianSplattingChunks, mortonCode) {
+    EXPECT_EQ(encodeMortonCode(0, 0, 0), 0u);
+    EXPECT_EQ(encodeMortonCode(1, 0, 0), 1u);
+    EXPECT_EQ(encodeMortonCode(0, 1, 0), 2u);
+    EXPECT_EQ(encodeMortonCode(0, 0, 1), 4u);
+    EXPECT_EQ(encodeMortonCode(3, 0, 0), 9u);
+    EXPECT_EQ(encodeMortonCode(0x1fffff, 0x1fffff, 0x1fffff), 0x7fffffffffffffffull);
+}
+
+TEST(GaussianSplattingChunks, partition) {
+    // STEP 1: two clusters far apart, interleaved in the input
+    // each cluster fills exactly 8 chunks
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+    std::vector<Gaussian3D> gaussians;
+    for (int i = 0; i < 1024; i++) {
+        float offset = (i % 2 == 0) ? 0.0f : 100.0f;
+        gaussians.push_back(makeGaussian(offset + distribution(generator), distribution(generator), distribution(generator), 0.01f));
+    }
+
+    // STEP 2: partition
+    std::vector<GaussianChunk> chunks = partitionIntoChunks(gaussians, 64);
+
+    // STEP 3: the chunks cover all gaussians exactly once, in order
+    ASSERT_EQ(chunks.size(), 16);
+    ASSERT_EQ(gaussians.size(), 1024);
+    uint32_t next = 0;
+    for (auto& chunk : chunks) {
+        EXPECT_EQ(chunk.first, next);
+        next += chunk.count;
+    }
+    EXPECT_EQ(next, 1024);
+
+    // STEP 4: every gaussian (with its extent) lies inside the bounds of its chunk
+    // and no chunk spans both clusters
+    for (auto& chunk : chunks) {
+        for (uint32_t i = chunk.first; i < chunk.first + chunk.count; i++) {
+            for (int j = 0; j < 3; j++) {
+                EXPECT_LE(chunk.boundsMin[j], gaussians[i].position[j] - 0.03f + 1e-6f);
+                EXPECT_GE(chunk.boundsMax[j], gaussians[i].position[j] + 0.03f - 1e-6f);
+            }
+        }
+        EXPECT_LT(chunk.boundsMax[0] - chunk.boundsMin[0], 2.0f);
+    }
+
+    // STEP 5: the last chunk takes the remainder
+    chunks = partitionIntoChunks(gaussians, 1000);
+    ASSERT_EQ(chunks.size(), 2);
+    EXPECT_EQ(chunks[1].first, 1000);
+    EXPECT_EQ(chunks[1].count, 24);
+}
+
+TEST(GaussianSplattingChunks, empty) {
+    std::vector<Gaussian3D> gaussians;
+    EXPECT_TRUE(partitionIntoChunks(gaussians).empty());
+    EXPECT_THROW(partitionIntoChunks(gaussians, 0), std::runtime_error);
+}
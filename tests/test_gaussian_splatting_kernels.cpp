@@ -0,0 +1,165 @@
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "klartraum/gaussian_splatting_kernels.hpp"
+
+using namespace klartraum;
+
+namespace {
+
+const KernelIsa allIsas[] = {KernelIsa::SSE2, KernelIsa::AVX2, KernelIsa::NEON};
+
+// an odd length, so that every kernel also runs its tail loop
+const size_t testCount = 1031;
+
+std::vector<float> randomValues(size_t count, float min, float max, unsigned int seed) {
+    std::mt19937 generator(seed);
+    std::uniform_real_distribution<float> distribution(min, max);
+    std::vector<float> values(count);
+    for (auto& value : values) {
+        value = distribution(generator);
+    }
+    return values;
+}
+
+} // namespace
+
+TEST(GaussianSplattingKernels, sigmoid) {
+    std::vector<float> input = randomValues(testCount, -20.0f, 20.0f, 1);
+    input[0] = 0.0f;
+    input[1] = -100.0f;
+    input[2] = 100.0f;
+
+    std::vector<float> expected(testCount);
+    getGaussianKernels(KernelIsa::Scalar).sigmoid(input.data(), expected.data(), testCount);
+
+    for (KernelIsa isa : allIsas) {
+        if (!isKernelIsaSupported(isa)) {
+            continue;
+        }
+        std::vector<float> output(testCount);
+        getGaussianKernels(isa).sigmoid(input.data(), output.data(), testCount);
+        for (size_t i = 0; i < testCount; i++) {
+            EXPECT_NEAR(output[i], expected[i], 1e-6f) << getKernelIsaName(isa) << " at " << i;
+        }
+    }
+}
+
+TEST(GaussianSplattingKernels, exp) {
+    std::vector<float> input = randomValues(testCount, -15.0f, 15.0f, 2);
+    input[0] = 0.0f;
+
+    std::vector<float> expected(testCount);
+    getGaussianKernels(KernelIsa::Scalar).exp(input.data(), expected.data(), testCount);
+
+    for (KernelIsa isa : allIsas) {
+        if (!isKernelIsaSupported(isa)) {
+            continue;
+        }
+        // run in place, as the loaders do
+        std::vector<float> output = input;
+        getGaussianKernels(isa).exp(output.data(), output.data(), testCount);
+        for (size_t i = 0; i < testCount; i++) {
+            EXPECT_NEAR(output[i], expected[i], 2e-6f * expected[i]) << getKernelIsaName(isa) << " at " << i;
+        }
+    }
+}
+
+TEST(GaussianSplattingKernels, expAtTheClampBound) {
+    // the bound of the argument, the floats just above and below it,
+    // and the largest arguments whose exp is still finite
+    const float bound = 88.3762626647949f;
+    std::vector<float> input = {
+        bound, std::nextafter(bound, 100.0f), std::nextafter(bound, 0.0f),
+        88.0f, 88.3f, -bound, -88.0f};
+    // the vectorized loops only run for full vectors
+    input.resize(16, bound);
+
+    std::vector<float> expected(input.size());
+    getGaussianKernels(KernelIsa::Scalar).exp(input.data(), expected.data(), input.size());
+
+    for (KernelIsa isa : allIsas) {
+        if (!isKernelIsaSupported(isa)) {
+            continue;
+        }
+        std::vector<float> output(input.size());
+        getGaussianKernels(isa).exp(input.data(), output.data(), input.size());
+        for (size_t i = 0; i < input.size(); i++) {
+            EXPECT_TRUE(std::isfinite(output[i])) << getKernelIsaName(isa) << " at " << input[i];
+            // just above the bound the argument is clamped, which changes exp by one ulp of the argument
+            EXPECT_NEAR(output[i], expected[i], 2e-5f * expected[i] + 1e-38f) << getKernelIsaName(isa) << " at " << input[i];
+        }
+
+        // beyond the bound the result stays finite instead of becoming +inf
+        std::vector<float> large(16, 1000.0f);
+        getGaussianKernels(isa).exp(large.data(), large.data(), large.size());
+        for (float value : large) {
+            EXPECT_TRUE(std::isfinite(value)) << getKernelIsaName(isa);
+            EXPECT_GT(value, expected[0] * 0.99f) << getKernelIsaName(isa);
+        }
+    }
+}
+
+TEST(GaussianSplattingKernels, normalizeQuaternions) {
+    std::vector<float> x = randomValues(testCount, -2.0f, 2.0f, 3);
+    std::vector<float> y = randomValues(testCount, -2.0f, 2.0f, 4);
+    std::vector<float> z = randomValues(testCount, -2.0f, 2.0f, 5);
+    std::vector<float> w = randomValues(testCount, -2.0f, 2.0f, 6);
+    // degenerate quaternion
+    x[3] = y[3] = z[3] = w[3] = 0.0f;
+
+    std::vector<float> ex = x, ey = y, ez = z, ew = w;
+    getGaussianKernels(KernelIsa::Scalar).normalizeQuaternions(ex.data(), ey.data(), ez.data(), ew.data(), testCount);
+
+    for (KernelIsa isa : allIsas) {
+        if (!isKernelIsaSupported(isa)) {
+            continue;
+        }
+        std::vector<float> ox = x, oy = y, oz = z, ow = w;
+        getGaussianKernels(isa).normalizeQuaternions(ox.data(), oy.data(), oz.data(), ow.data(), testCount);
+        for (size_t i = 0; i < testCount; i++) {
+            EXPECT_NEAR(ox[i], ex[i], 1e-6f) << getKernelIsaName(isa) << " at " << i;
+            EXPECT_NEAR(oy[i], ey[i], 1e-6f) << getKernelIsaName(isa) << " at " << i;
+            EXPECT_NEAR(oz[i], ez[i], 1e-6f) << getKernelIsaName(isa) << " at " << i;
+            EXPECT_NEAR(ow[i], ew[i], 1e-6f) << getKernelIsaName(isa) << " at " << i;
+        }
+        EXPECT_EQ(ox[3], 0.0f);
+    }
+}
+
+TEST(GaussianSplattingKernels, rescale) {
+    // interleaved like the sh coefficients of a spz cloud, plus one contiguous case
+    const size_t strides[] = {1, 3, 45};
+    for (size_t stride : strides) {
+        std::vector<float> input = randomValues(testCount * stride, -1.0f, 1.0f, 7);
+
+        std::vector<float> expected(testCount);
+        getGaussianKernels(KernelIsa::Scalar).rescale(input.data() + stride - 1, stride * sizeof(float), expected.data(), testCount, 0.5f);
+        EXPECT_FLOAT_EQ(expected[1], 0.5f * input[2 * stride - 1]);
+
+        for (KernelIsa isa : allIsas) {
+            if (!isKernelIsaSupported(isa)) {
+                continue;
+            }
+            std::vector<float> output(testCount);
+            getGaussianKernels(isa).rescale(input.data() + stride - 1, stride * sizeof(float), output.data(), testCount, 0.5f);
+            for (size_t i = 0; i < testCount; i++) {
+                EXPECT_EQ(output[i], expected[i]) << getKernelIsaName(isa) << " stride " << stride << " at " << i;
+            }
+        }
+    }
+}
+
+TEST(GaussianSplattingKernels, dispatch) {
+    EXPECT_TRUE(isKernelIsaSupported(getGaussianKernels().isa));
+    for (KernelIsa isa : allIsas) {
+        if (isKernelIsaSupported(isa)) {
+            EXPECT_EQ(getGaussianKernels(isa).isa, isa);
+        } else {
+            EXPECT_THROW(getGaussianKernels(isa), std::runtime_error);
+        }
+    }
+}
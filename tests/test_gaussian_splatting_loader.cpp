@@ -0,0 +1,105 @@
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "klartraum/gaussian_splatting_loader.hpp"
+
+using namespace klartraum;
+
+namespace {
+
+// writes a binary little endian PLY file with the same layout as the reference implementation
+std::string writeTestPly(const std::string& name, const std::vector<std::vector<float>>& vertices) {
+    std::vector<std::string> properties = {"x", "y", "z", "nx", "ny", "nz", "f_dc_0", "f_dc_1", "f_dc_2"};
+    for (int i = 0; i < 45; i++) {
+        properties.push_back("f_rest_" + std::to_string(i));
+    }
+    for (auto name : {"opacity", "scale_0", "scale_1", "scale_2", "rot_0", "rot_1", "rot_2", "rot_3"}) {
+        properties.push_back(name);
+    }
+
+    std::filesystem::path path = std::filesystem::temp_directory_path() / name;
+    std::ofstream file(path, std::ios::binary);
+    file << "ply\n";
+    file << "format binary_little_endian 1.0\n";
+    file << "element vertex " << vertices.size() << "\n";
+    for (auto& property : properties) {
+        file << "property float " << property << "\n";
+    }
+    file << "end_header\n";
+    for (auto& vertex : vertices) {
+        EXPECT_EQ(vertex.size(), properties.size());
+        file.write((const char*)vertex.data(), vertex.size() * sizeof(float));
+    }
+    return path.string();
+}
+
+std::vector<float> makeVertex(float x, float y, float z, float opacity) {
+    std::vector<float> vertex = {x, y, z, 0.0f, 0.0f, 0.0f, 0.1f, 0.2f, 0.3f};
+    for (int i = 0; i < 45; i++) {
+        vertex.push_back((float)i);
+    }
+    std::vector<float> rest = {opacity, 0.0f, std::log(2.0f), std::log(0.5f), 2.0f, 0.0f, 0.0f, 0.0f};
+    vertex.insert(vertex.end(), rest.begin(), rest.end());
+    return vertex;
+}
+
+} // namespace
+
+TEST(GaussianSplattingLoader, loadPly) {
+    // STEP 1: write a small ply file
+    std::string path = writeTestPly("klartraum_test_load.ply", {makeVertex(1.0f, 2.0f, 3.0f, 0.0f), makeVertex(-1.0f, 0.5f, 0.0f, 100.0f)});
+
+    // STEP 2: load it
+    std::vector<Gaussian3D> gaussians = loadGaussiansFromPly(path);
+
+    // STEP 3: check the activated values
+    ASSERT_EQ(gaussians.size(), 2);
+    EXPECT_FLOAT_EQ(gaussians[0].position[0], 1.0f);
+    EXPECT_FLOAT_EQ(gaussians[0].position[1], 2.0f);
+    EXPECT_FLOAT_EQ(gaussians[0].position[2], 3.0f);
+    EXPECT_NEAR(gaussians[0].alpha, 0.5f, 1e-6f);
+    EXPECT_NEAR(gaussians[1].alpha, 1.0f, 1e-6f);
+    EXPECT_NEAR(gaussians[0].scale[0], 1.0f, 1e-6f);
+    EXPECT_NEAR(gaussians[0].scale[1], 2.0f, 1e-6f);
+    EXPECT_NEAR(gaussians[0].scale[2], 0.5f, 1e-6f);
+
+    // rot_0 is the real part and ends up in w after normalization
+    EXPECT_NEAR(gaussians[0].rotation[0], 0.0f, 1e-6f);
+    EXPECT_NEAR(gaussians[0].rotation[3], 1.0f, 1e-6f);
+
+    EXPECT_FLOAT_EQ(gaussians[0].color[2], 0.3f);
+    EXPECT_FLOAT_EQ(gaussians[0].shR[0], 0.0f);
+    EXPECT_FLOAT_EQ(gaussians[0].shG[0], 15.0f);
+    EXPECT_FLOAT_EQ(gaussians[0].shB[14], 44.0f);
+
+    std::filesystem::remove(path);
+}
+
+TEST(GaussianSplattingLoader, cropPly) {
+    // STEP 1: write a small ply file
+    std::string path = writeTestPly("klartraum_test_crop.ply", {makeVertex(0.0f, 0.0f, 0.0f, 0.0f), makeVertex(5.0f, 0.0f, 0.0f, 0.0f), makeVertex(0.5f, -0.5f, 0.5f, -10.0f)});
+
+    // STEP 2: load it with a crop box and an opacity threshold
+    GaussianLoadOptions options;
+    options.crop = true;
+    options.cropMin = {-1.0f, -1.0f, -1.0f};
+    options.cropMax = {1.0f, 1.0f, 1.0f};
+    options.minAlpha = 0.01f;
+    std::vector<Gaussian3D> gaussians = loadGaussiansFromPly(path, options);
+
+    // STEP 3: only the first gaussian is inside the box and opaque enough
+    ASSERT_EQ(gaussians.size(), 1);
+    EXPECT_FLOAT_EQ(gaussians[0].position[0], 0.0f);
+
+    std::filesystem::remove(path);
+}
+
+TEST(GaussianSplattingLoader, rejectAsciiPly) {
+    std::string header = "ply\nformat ascii 1.0\nelement vertex 0\nproperty float x\nend_header\n";
+    EXPECT_THROW(parsePlyHeader((const uint8_t*)header.data(), header.size()), std::runtime_error);
+}
@@ -0,0 +1,103 @@
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "klartraum/gaussian_splatting_lod.hpp"
+
+using namespace klartraum;
+
+namespace {
+
+Gaussian3D makeGaussian(float x, float y, float z, float scale, float alpha) {
+    Gaussian3D gaussian{};
+    gaussian.position = {x, y, z};
+    gaussian.rotation = {0.0f, 0.0f, 0.0f, 1.0f};
+    gaussian.scale = {scale, scale, scale};
+    gaussian.alpha = alpha;
+    return gaussian;
+}
+
+} // namespace
+
+TEST(GaussianSplattingLod, mergeSingle) {
+    Gaussian3D gaussian = makeGaussian(1.0f, 2.0f, 3.0f, 0.5f, 0.7f);
+    gaussian.rotation = {0.5f, 0.5f, 0.5f, 0.5f};
+    gaussian.scale = {0.1f, 0.2f, 0.3f};
+
+    Gaussian3D merged = mergeGaussians(&gaussian, 1);
+    EXPECT_FLOAT_EQ(merged.alpha, 0.7f);
+    EXPECT_FLOAT_EQ(merged.position[2], 3.0f);
+}
+
+TEST(GaussianSplattingLod, mergeMomentMatching) {
+    // STEP 1: two equal spheres on the x axis, one rotated
+    Gaussian3D gaussians[2] = {makeGaussian(-1.0f, 0.0f, 0.0f, 1.0f, 0.5f), makeGaussian(1.0f, 0.0f, 0.0f, 1.0f, 0.5f)};
+    gaussians[1].rotation = {0.0f, 0.0f, std::sqrt(0.5f), std::sqrt(0.5f)};
+    gaussians[0].shR[3] = 1.0f;
+
+    // STEP 2: merge them
+    Gaussian3D merged = mergeGaussians(gaussians, 2);
+
+    // STEP 3: the mixture has variance 1 + 1 along x and 1 along y and z
+    std::array<float, 9> covariance = computeCovariance(merged);
+    const float expected[9] = {2.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f};
+    for (int i = 0; i < 9; i++) {
+        EXPECT_NEAR(covariance[i], expected[i], 1e-5f) << "at " << i;
+    }
+    EXPECT_NEAR(merged.position[0], 0.0f, 1e-6f);
+    EXPECT_NEAR(merged.shR[3], 0.5f, 1e-6f);
+
+    float norm = 0.0f;
+    for (float q : merged.rotation) {
+        norm += q * q;
+    }
+    EXPECT_NEAR(norm, 1.0f, 1e-5f);
+    EXPECT_GT(merged.alpha, 0.5f);
+    EXPECT_LE(merged.alpha, 1.0f);
+}
+
+TEST(GaussianSplattingLod, hierarchy) {
+    // STEP 1: build a hierarchy of random gaussians
+    std::mt19937 generator(3);
+    std::uniform_real_distribution<float> distribution(-10.0f, 10.0f);
+    std::vector<Gaussian3D> gaussians;
+    for (int i = 0; i < 4096; i++) {
+        gaussians.push_back(makeGaussian(distribution(generator), distribution(generator), distribution(generator), 0.05f, 0.8f));
+    }
+
+    GaussianHierarchy hierarchy = buildGaussianHierarchy(gaussians, 8, 64);
+
+    // STEP 2: 64 leaf chunks, merged to 16, 4 and finally a single root
+    EXPECT_EQ(hierarchy.numberLevels, 4);
+    EXPECT_EQ(hierarchy.numberLeafGaussians, 4096);
+    EXPECT_EQ(hierarchy.chunks.size(), 64 + 16 + 4 + 1);
+    EXPECT_EQ(hierarchy.gaussians.size(), 4096 + 1024 + 256 + 64);
+
+    // STEP 3: errors grow towards the root and parent spheres contain their children
+    auto& root = hierarchy.chunks.back();
+    EXPECT_TRUE(std::isinf(root.parentError));
+    for (auto& chunk : hierarchy.chunks) {
+        EXPECT_LE(chunk.error, chunk.parentError);
+        EXPECT_LE(chunk.first + chunk.count, hierarchy.gaussians.size());
+        if (&chunk == &root) {
+            continue;
+        }
+        float dx = chunk.sphere[0] - chunk.parentSphere[0];
+        float dy = chunk.sphere[1] - chunk.parentSphere[1];
+        float dz = chunk.sphere[2] - chunk.parentSphere[2];
+        EXPECT_LE(std::sqrt(dx * dx + dy * dy + dz * dz) + chunk.sphere[3], chunk.parentSphere[3] * 1.0001f);
+    }
+    EXPECT_EQ(hierarchy.parents[0], 64);
+    EXPECT_EQ(hierarchy.parents[4], 65);
+    EXPECT_EQ(hierarchy.parents.back(), NoParentChunk);
+    EXPECT_EQ(hierarchy.chunks[0].error, 0.0f);
+    EXPECT_GT(root.error, 0.0f);
+
+    // STEP 4: without lod, there is only the leaf level
+    GaussianHierarchy flat = buildGaussianHierarchy(gaussians, 1, 64);
+    EXPECT_EQ(flat.numberLevels, 1);
+    EXPECT_EQ(flat.chunks.size(), 64);
+    EXPECT_TRUE(std::isinf(flat.chunks[0].parentError));
+}
@@ -0,0 +1,147 @@
+#include <filesystem>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "klartraum/gaussian_splatting_streaming.hpp"
+
+using namespace klartraum;
+
+namespace {
+
+const uint32_t testChunkSize = 64;
+
+GaussianHierarchy buildTestHierarchy() {
+    std::mt19937 generator(5);
+    std::uniform_real_distribution<float> distribution(-10.0f, 10.0f);
+    std::vector<Gaussian3D> gaussians(4096);
+    for (auto& gaussian : gaussians) {
+        gaussian = Gaussian3D{};
+        gaussian.position = {distribution(generator), distribution(generator), distribution(generator)};
+        gaussian.rotation = {0.0f, 0.0f, 0.0f, 1.0f};
+        gaussian.scale = {0.05f, 0.05f, 0.05f};
+        gaussian.alpha = 0.8f;
+    }
+    // 64 leaf chunks, 16, 4 and a single root
+    return buildGaussianHierarchy(gaussians, 8, testChunkSize);
+}
+
+// checks that the resident chunks form the top of the hierarchy
+// and that the pool contains their gaussians
+void checkResidency(const GaussianResidencyManager& manager, const GaussianHierarchy& hierarchy, const std::vector<Gaussian3D>& pool) {
+    auto& pageTable = manager.getPageTable();
+    for (size_t chunk = 0; chunk < hierarchy.chunks.size(); chunk++) {
+        if (pageTable[chunk] == GaussianResidencyManager::NotResident) {
+            continue;
+        }
+        uint32_t parent = hierarchy.parents[chunk];
+        if (parent != NoParentChunk) {
+            ASSERT_TRUE(manager.isResident(parent));
+            EXPECT_NE(pageTable[parent] & GaussianResidencyManager::ChildrenResidentBit, 0u);
+        }
+        uint32_t page = pageTable[chunk] & ~GaussianResidencyManager::ChildrenResidentBit;
+        auto& chunkData = hierarchy.chunks[chunk];
+        EXPECT_EQ(pool[page * testChunkSize].position, hierarchy.gaussians[chunkData.first].position);
+        EXPECT_EQ(pool[page * testChunkSize + chunkData.count - 1].position, hierarchy.gaussians[chunkData.first + chunkData.count - 1].position);
+    }
+}
+
+} // namespace
+
+TEST(GaussianSplattingStreaming, pageFile) {
+    GaussianHierarchy hierarchy = buildTestHierarchy();
+    std::string path = (std::filesystem::temp_directory_path() / "klartraum_test.kts").string();
+
+    writeGaussianPageFile(path, hierarchy, 42);
+    EXPECT_TRUE(isGaussianPageFileValid(path, 42));
+    EXPECT_FALSE(isGaussianPageFileValid(path, 43));
+    EXPECT_FALSE(isGaussianPageFileValid(path + ".missing", 42));
+
+    {
+        GaussianPageFile pageFile(path);
+        EXPECT_EQ(pageFile.getHeader().numberChunks, hierarchy.chunks.size());
+        EXPECT_EQ(pageFile.getHeader().numberGaussians, hierarchy.gaussians.size());
+        EXPECT_EQ(pageFile.getHeader().numberLeafGaussians, 4096);
+        EXPECT_EQ(pageFile.getParents(), hierarchy.parents);
+        EXPECT_EQ(pageFile.getChunks().back().first, hierarchy.chunks.back().first);
+        EXPECT_EQ(pageFile.getGaussians()[5000].position, hierarchy.gaussians[5000].position);
+    }
+
+    std::filesystem::remove(path);
+}
+
+TEST(GaussianSplattingStreaming, everythingFits) {
+    GaussianHierarchy hierarchy = buildTestHierarchy();
+
+    GaussianStreamingOptions options;
+    options.poolPages = 100;
+    std::vector<Gaussian3D> pool(options.poolPages * testChunkSize);
+    auto upload = [&pool](uint32_t page, const Gaussian3D* gaussians, uint32_t count) {
+        std::copy(gaussians, gaussians + count, pool.begin() + page * testChunkSize);
+    };
+
+    GaussianResidencyManager manager(hierarchy.gaussians.data(), hierarchy.chunks, hierarchy.parents, 2, options, upload);
+    EXPECT_EQ(manager.getNumberResidentChunks(), hierarchy.chunks.size());
+    checkResidency(manager, hierarchy, pool);
+}
+
+TEST(GaussianSplattingStreaming, stream) {
+    GaussianHierarchy hierarchy = buildTestHierarchy();
+
+    GaussianStreamingOptions options;
+    options.poolPages = 10;
+    std::vector<Gaussian3D> pool(options.poolPages * testChunkSize);
+    auto upload = [&pool](uint32_t page, const Gaussian3D* gaussians, uint32_t count) {
+        std::copy(gaussians, gaussians + count, pool.begin() + page * testChunkSize);
+    };
+
+    // STEP 1: only the root is resident at first
+    GaussianResidencyManager manager(hierarchy.gaussians.data(), hierarchy.chunks, hierarchy.parents, 2, options, upload);
+    EXPECT_EQ(manager.getNumberResidentChunks(), 1);
+
+    // STEP 2: every resident chunk asks for more detail
+    std::vector<uint32_t> feedback(hierarchy.chunks.size());
+    std::array<float, 3> camera = {0.0f, 0.0f, 0.0f};
+    for (int frame = 0; frame < 20; frame++) {
+        for (size_t chunk = 0; chunk < feedback.size(); chunk++) {
+            feedback[chunk] = manager.isResident((uint32_t)chunk) ? GaussianResidencyManager::FeedbackUsed | GaussianResidencyManager::FeedbackRefine : 0;
+        }
+        manager.update(feedback.data(), camera);
+        manager.waitForLoads();
+
+        EXPECT_LE(manager.getNumberResidentChunks(), options.poolPages);
+        checkResidency(manager, hierarchy, pool);
+    }
+    uint32_t refined = manager.getNumberResidentChunks();
+    EXPECT_GE(refined, 5);
+
+    // STEP 3: nothing changes without feedback asking for it
+    uint64_t version = manager.getPageTableVersion();
+    std::fill(feedback.begin(), feedback.end(), 0);
+    for (int frame = 0; frame < 10; frame++) {
+        manager.update(feedback.data(), camera);
+    }
+    EXPECT_EQ(manager.getPageTableVersion(), version);
+
+    // STEP 4: the unused groups get evicted to make room for the children
+    // of another chunk
+    for (int frame = 0; frame < 20; frame++) {
+        for (size_t chunk = 0; chunk < feedback.size(); chunk++) {
+            feedback[chunk] = manager.isResident((uint32_t)chunk) && hierarchy.parents[chunk] == NoParentChunk ? GaussianResidencyManager::FeedbackUsed : 0;
+        }
+        // a chunk of the level below the root, whose children are not resident, asks for refinement
+        for (size_t chunk = 80; chunk < 84; chunk++) {
+            if (manager.isResident((uint32_t)chunk) && (manager.getPageTable()[chunk] & GaussianResidencyManager::ChildrenResidentBit) == 0) {
+                feedback[chunk] |= GaussianResidencyManager::FeedbackUsed | GaussianResidencyManager::FeedbackRefine;
+                break;
+            }
+        }
+        manager.update(feedback.data(), camera);
+        manager.waitForLoads();
+
+        EXPECT_LE(manager.getNumberResidentChunks(), options.poolPages);
+        checkResidency(manager, hierarchy, pool);
+    }
+    EXPECT_NE(manager.getPageTableVersion(), version);
+}
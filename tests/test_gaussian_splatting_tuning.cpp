@@ -0,0 +1,86 @@
+#include <filesystem>
+
+#include <gtest/gtest.h>
+
+#include "klartraum/glfw_frontend.hpp"
+#include "klartraum/gaussian_splatting_tuning.hpp"
+
+using namespace klartraum;
+
+TEST(GaussianSplattingTuning, saveAndLoad) {
+    std::string path = (std::filesystem::temp_directory_path() / "klartraum_test_tuning.txt").string();
+    std::filesystem::remove(path);
+
+    DeviceUUID deviceA{};
+    DeviceUUID deviceB{};
+    deviceA[0] = 0x01;
+    deviceB[15] = 0xab;
+
+    // STEP 1: nothing is found without a file, the constants stay unchanged
+    GaussianKernelConstants constants;
+    EXPECT_FALSE(loadTunedKernelConstants(path, deviceA, constants));
+    EXPECT_EQ(constants.sortGroupSize, 128u);
+
+    // STEP 2: each device has its own entry
+    saveTunedKernelConstants(path, deviceA, {64, 256, 16});
+    saveTunedKernelConstants(path, deviceB, {256, 64, 8});
+
+    ASSERT_TRUE(loadTunedKernelConstants(path, deviceA, constants));
+    EXPECT_EQ(constants.projectionGroupSize, 64u);
+    EXPECT_EQ(constants.sortGroupSize, 256u);
+    EXPECT_EQ(constants.splatTileSize, 16u);
+
+    ASSERT_TRUE(loadTunedKernelConstants(path, deviceB, constants));
+    EXPECT_EQ(constants.projectionGroupSize, 256u);
+
+    // STEP 3: saving again replaces the entry of the device only
+    saveTunedKernelConstants(path, deviceA, {128, 128, 8});
+    ASSERT_TRUE(loadTunedKernelConstants(path, deviceA, constants));
+    EXPECT_EQ(constants.sortGroupSize, 128u);
+    ASSERT_TRUE(loadTunedKernelConstants(path, deviceB, constants));
+    EXPECT_EQ(constants.sortGroupSize, 64u);
+
+    DeviceUUID deviceC{};
+    EXPECT_FALSE(loadTunedKernelConstants(path, deviceC, constants));
+    EXPECT_FALSE(loadTunedKernelConstants("", deviceA, constants));
+
+    std::filesystem::remove(path);
+}
+
+TEST(GaussianSplattingTuning, candidatesFitDeviceLimits) {
+    klartraum::GlfwFrontend frontend;
+
+    auto& core = frontend.getKlartraumEngine();
+    auto& vulkanContext = core.getVulkanContext();
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(vulkanContext.physicalDevice, &properties);
+    auto& limits = properties.limits;
+
+    // a projection group larger than the device allows, a sort group with less
+    // than one thread per bin and a tile with more threads than a workgroup can have
+    GaussianKernelTuningOptions options;
+    options.projectionGroupSizes = {64, limits.maxComputeWorkGroupSize[0] + 1};
+    options.sortGroupSizes = {8, 128};
+    options.splatTileSizes = {8, 1024};
+
+    GaussianKernelTuner tuner(vulkanContext, options);
+    auto candidates = tuner.getCandidates();
+
+    ASSERT_EQ(candidates.size(), 1u);
+    EXPECT_EQ(candidates[0].projectionGroupSize, 64u);
+    EXPECT_EQ(candidates[0].sortGroupSize, 128u);
+    EXPECT_EQ(candidates[0].splatTileSize, 8u);
+
+    // the default grid only has candidates within the limits
+    GaussianKernelTuner defaultTuner(vulkanContext);
+    auto defaultCandidates = defaultTuner.getCandidates();
+    EXPECT_FALSE(defaultCandidates.empty());
+    for (auto& candidate : defaultCandidates) {
+        EXPECT_LE(candidate.projectionGroupSize, limits.maxComputeWorkGroupSize[0]);
+        EXPECT_LE(candidate.sortGroupSize, limits.maxComputeWorkGroupSize[0]);
+        EXPECT_GE(candidate.sortGroupSize, 16u);
+        EXPECT_LE(candidate.splatTileSize * candidate.splatTileSize, limits.maxComputeWorkGroupInvocations);
+        EXPECT_LE(candidate.splatTileSize * candidate.splatTileSize * sizeof(Splat2D) + sizeof(uint32_t), limits.maxComputeSharedMemorySize);
+    }
+}
@@ -0,0 +1,48 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "klartraum/glfw_frontend.hpp"
+
+#include "klartraum/computegraph/computegraph.hpp"
+
+#include "klartraum/computegraph/bufferelement.hpp"
+#include "klartraum/computegraph/generalcomputation.hpp"
+#include "klartraum/vulkan_buffer.hpp"
+
+using namespace klartraum;
+
+TEST(GeneralComputation, bufferAddressMode) {
+    klartraum::GlfwFrontend frontend;
+
+    auto& core = frontend.getKlartraumEngine();
+    auto& vulkanContext = core.getVulkanContext();
+
+    if (!vulkanContext.hasBufferDeviceAddress()) {
+        GTEST_SKIP() << "the device does not support buffer device addresses";
+    }
+
+    auto input = std::make_shared<BufferElement<VulkanBuffer<float>>>(vulkanContext, 7);
+    auto output = std::make_shared<BufferElement<VulkanBuffer<float>>>(vulkanContext, 7);
+
+    auto doubling = std::make_shared<GeneralComputation<>>(vulkanContext, "shaders/operator_double_address.comp.spv");
+    doubling->setBufferAddressMode(true);
+    doubling->setInput(input, 0);
+    doubling->setInput(output, 1);
+    doubling->setGroupCount(7, 1, 1);
+
+    auto computegraph = ComputeGraph(vulkanContext, 1);
+    computegraph.compileFrom(doubling);
+
+    // the shader reads and writes the inputs through the address table
+    std::vector<float> data = {1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f};
+    input->getBuffer(0).memcopyFrom(data);
+
+    computegraph.submitAndWait(vulkanContext.getGraphicsQueue(), 0);
+
+    std::vector<float> data_out(7, 0.0f);
+    output->getBuffer(0).memcopyTo(data_out);
+    for (int i = 0; i < 7; i++) {
+        EXPECT_EQ(data[i] * 2, data_out[i]);
+    }
+}
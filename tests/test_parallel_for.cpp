@@ -0,0 +1,77 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "klartraum/parallel_for.hpp"
+
+using namespace klartraum;
+
+TEST(ThreadPool, forEachWorker) {
+    ThreadPool threadPool(4);
+    ASSERT_EQ(threadPool.getNumberThreads(), 4u);
+
+    // the same workers are used by every job, each index on its own thread
+    std::set<std::thread::id> allThreads;
+    for (int job = 0; job < 100; job++) {
+        std::vector<std::thread::id> threads(4);
+        threadPool.forEachWorker(4, [&](size_t worker) {
+            threads[worker] = std::this_thread::get_id();
+        });
+        EXPECT_EQ(threads[0], std::this_thread::get_id());
+        EXPECT_EQ(std::set<std::thread::id>(threads.begin(), threads.end()).size(), 4u);
+        allThreads.insert(threads.begin(), threads.end());
+    }
+    EXPECT_EQ(allThreads.size(), 4u);
+}
+
+TEST(ThreadPool, nestedJobsRunOnTheCallingThread) {
+    ThreadPool threadPool(4);
+
+    std::atomic<int> count{0};
+    std::atomic<bool> sameThread{true};
+    threadPool.forEachWorker(4, [&](size_t worker) {
+        EXPECT_EQ(threadPool.getNumberThreads(8), 1u);
+        std::thread::id outer = std::this_thread::get_id();
+        threadPool.parallelFor(8, [&](size_t i) {
+            if (std::this_thread::get_id() != outer) {
+                sameThread = false;
+            }
+            count++;
+        });
+    });
+    EXPECT_TRUE(sameThread);
+    EXPECT_EQ(count, 32);
+    EXPECT_EQ(threadPool.getNumberThreads(8), 4u);
+}
+
+TEST(ThreadPool, parallelFor) {
+    ThreadPool threadPool(4);
+
+    std::vector<int> visited(1000, 0);
+    threadPool.parallelFor(visited.size(), [&](size_t i) {
+        visited[i]++;
+    });
+    for (int v : visited) {
+        EXPECT_EQ(v, 1);
+    }
+
+    // the exception is rethrown after all tasks finished, the pool stays usable
+    std::atomic<int> count{0};
+    EXPECT_THROW(threadPool.parallelFor(100, [&](size_t i) {
+        count++;
+        if (i == 10) {
+            throw std::runtime_error("task failed");
+        }
+    }), std::runtime_error);
+    EXPECT_EQ(count, 100);
+
+    count = 0;
+    threadPool.parallelFor(100, [&](size_t i) {
+        count++;
+    });
+    EXPECT_EQ(count, 100);
+}